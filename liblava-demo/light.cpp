@@ -91,8 +91,8 @@ int main(int argc, char* argv[]) {
         .minFilter = VK_FILTER_NEAREST,
         .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST
     };
-    VkSampler sampler;
-    if (!app.device->vkCreateSampler(&sampler_info, &sampler))
+    VkSampler sampler = app.device->get_sampler_cache().acquire(sampler_info);
+    if (!sampler)
         return error::create_failed;
 
     // pipeline-specific resources
@@ -389,7 +389,7 @@ int main(int argc, char* argv[]) {
     };
 
     app.add_run_end([&]() {
-        app.device->vkDestroySampler(sampler);
+        app.device->get_sampler_cache().release(sampler);
         sampler = VK_NULL_HANDLE;
 
         light_buffer.destroy();
@@ -9,3 +9,4 @@
 #include <liblava/app/config.hpp>
 #include <liblava/app/forward_shading.hpp>
 #include <liblava/app/imgui.hpp>
+#include <liblava/app/render_graph.hpp>
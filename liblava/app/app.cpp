@@ -66,8 +66,13 @@ namespace lava {
             {
                 scoped_label stage_label(cmd_buf, _lava_texture_staging_, { 0.f, 0.13f, 0.4f, 1.f });
                 staging.stage(cmd_buf, current_frame);
+
+                if (auto const point = staging.get_transfer_sync(); point.valid())
+                    renderer.add_wait(point, staging::transfer_wait_stage);
             }
 
+            defragmenter.process(cmd_buf);
+
             if (on_process)
                 on_process(cmd_buf, current_frame);
 
@@ -99,12 +104,25 @@ namespace lava {
         cmd_line({ "-vs", "--v_sync" }) >> config.v_sync;
         cmd_line({ "-pd", "--physical_device" }) >> config.physical_device;
 
+        if (cmd_line[{ "-ms", "--memory_stats" }])
+            config.memory_stats_file = _memory_stats_file_;
+
         if (!window.create(load_window_state(window.get_save_name())))
             return false;
 
         set_window_icon(window);
 
         if (!device) {
+            if (config.transfer_queue) {
+                auto create_param = manager.on_create_param;
+                manager.on_create_param = [create_param](device::create_param& param) {
+                    if (create_param)
+                        create_param(param);
+
+                    param.add_queue(VK_QUEUE_TRANSFER_BIT);
+                };
+            }
+
             device = create_device(config.physical_device);
             if (!device)
                 return false;
@@ -122,6 +140,42 @@ namespace lava {
         if (!create_imgui())
             return false;
 
+        if (!staging.create(device))
+            return false;
+
+        if (!defragmenter.create(device, target->get_frame_count()))
+            return false;
+
+        // static commands and cached secondaries hold the moved handles,
+        // the old ones stay valid for the frames in flight
+        defragmenter.on_moved = [&]() {
+            resources_moved = true;
+        };
+
+        if (config.transfer_queue) {
+            auto graphics_family = device->graphics_queue().family;
+
+            for (auto& queue : device->get_transfer_queues()) {
+                if (queue.family == graphics_family)
+                    continue;
+
+                if (staging.set_transfer_queue(queue, graphics_family))
+                    log()->debug("staging on transfer queue family {}", queue.family);
+                break;
+            }
+        }
+
+        if (!immediate.create(device, device->graphics_queue()))
+            return false;
+
+        if (!staging.use_transfer_queue()) {
+            // startup uploads are done before the first frame
+            while (staging.busy()) {
+                if (!immediate.execute([&](VkCommandBuffer cmd_buf) { staging.stage(cmd_buf, 0); }))
+                    return false;
+            }
+        }
+
         if (!create_block())
             return false;
 
@@ -132,11 +186,17 @@ namespace lava {
         render();
 
         add_run_end([&]() {
+            if (!config.memory_stats_file.empty())
+                write_memory_stats(device, config.memory_stats_file);
+
             camera.destroy();
 
             destroy_imgui();
 
             block.destroy();
+            defragmenter.destroy();
+            immediate.destroy();
+            staging.destroy();
 
             destroy_target();
 
@@ -321,6 +381,8 @@ namespace lava {
                 if (!create_target())
                     return false;
 
+                block.mark_dirty();
+
                 return create_imgui();
             }
 
@@ -328,6 +390,8 @@ namespace lava {
                 camera.aspect_ratio = window.get_aspect_ratio();
                 camera.update_projection();
 
+                block.mark_dirty();
+
                 return window.handle_resize();
             }
 
@@ -375,6 +439,16 @@ namespace lava {
 
             frame_counter++;
 
+            // not while the block records on its threads
+            if (resources_moved) {
+                block.mark_dirty();
+
+                if (auto pass = shading.get_pass())
+                    pass->invalidate();
+
+                resources_moved = false;
+            }
+
             if (!block.process(*frame_index))
                 return false;
 
@@ -402,4 +476,121 @@ namespace lava {
         }
     }
 
+    void app::draw_memory_stats() const {
+        if (!device)
+            return;
+
+        auto const stats = device->get_memory_stats();
+
+        auto const to_mb = [](VkDeviceSize bytes) {
+            return bytes / (1024.f * 1024.f);
+        };
+
+        ImGui::Text("%u allocations, %.1f MB used, %.1f MB unused%s", stats.allocation_count,
+                    to_mb(stats.used_bytes), to_mb(stats.unused_bytes),
+                    stats.budget_supported ? "" : " (no budget)");
+
+        for (auto i = 0u; i < stats.heaps.size(); ++i) {
+            auto const& heap = stats.heaps.at(i);
+            if (heap.budget == 0)
+                continue;
+
+            auto const overlay = fmt::format("{:.1f} / {:.1f} MB (peak {:.1f})", to_mb(heap.usage),
+                                             to_mb(heap.budget), to_mb(heap.peak_usage));
+
+            ImGui::Text("heap %u%s", i, heap.device_local ? " (device local)" : "");
+            ImGui::ProgressBar(float(heap.usage) / heap.budget, ImVec2(-1.f, 0.f), str(overlay));
+        }
+
+        ImGui::Separator();
+
+        for (auto i = 0u; i < stats.tags.size(); ++i) {
+            auto const& tag = stats.tags.at(i);
+            if (tag.peak_bytes == 0)
+                continue;
+
+            ImGui::Text("%s: %u, %.1f MB (peak %.1f)", memory_tag_name(memory_tag(i)), tag.count,
+                        to_mb(tag.bytes), to_mb(tag.peak_bytes));
+        }
+
+        ImGui::Separator();
+
+        auto const cpu_stats = memory::get_cpu_stats();
+        for (auto i = 0u; i < cpu_stats.size(); ++i) {
+            auto const& scope = cpu_stats.at(i);
+            if (scope.total_count == 0)
+                continue;
+
+            ImGui::Text("cpu %s: %zu, %.2f MB (peak %.2f), %zu total", allocation_scope_name(VkSystemAllocationScope(i)),
+                        scope.count, to_mb(scope.bytes), to_mb(scope.peak_bytes), scope.total_count);
+        }
+    }
+
+    void to_json(json& j, memory_stats const& stats) {
+        j[_budget_supported_] = stats.budget_supported;
+        j[_allocation_count_] = stats.allocation_count;
+        j[_used_bytes_] = stats.used_bytes;
+        j[_unused_bytes_] = stats.unused_bytes;
+
+        auto heaps = json::array();
+        for (auto& heap : stats.heaps) {
+            heaps.push_back({
+                { _device_local_, heap.device_local },
+                { _size_, heap.size },
+                { _budget_, heap.budget },
+                { _usage_, heap.usage },
+                { _peak_usage_, heap.peak_usage },
+                { _block_bytes_, heap.block_bytes },
+                { _allocation_bytes_, heap.allocation_bytes },
+                { _block_count_, heap.block_count },
+                { _allocation_count_, heap.allocation_count },
+            });
+        }
+        j[_heaps_] = heaps;
+
+        json tags;
+        for (auto i = 0u; i < stats.tags.size(); ++i) {
+            auto const& tag = stats.tags.at(i);
+            tags[memory_tag_name(memory_tag(i))] = {
+                { _count_, tag.count },
+                { _bytes_, tag.bytes },
+                { _peak_bytes_, tag.peak_bytes },
+            };
+        }
+        j[_tags_] = tags;
+    }
+
+    bool write_memory_stats(device_cptr device, string_ref path) {
+        if (!device)
+            return false;
+
+        json j = device->get_memory_stats();
+
+        json cpu;
+        auto const cpu_stats = memory::get_cpu_stats();
+        for (auto i = 0u; i < cpu_stats.size(); ++i) {
+            auto const& scope = cpu_stats.at(i);
+            cpu[allocation_scope_name(VkSystemAllocationScope(i))] = {
+                { _count_, scope.count },
+                { _bytes_, scope.bytes },
+                { _peak_bytes_, scope.peak_bytes },
+                { _total_count_, scope.total_count },
+                { _arena_count_, scope.arena_count },
+            };
+        }
+        j[_cpu_] = cpu;
+        auto const content = j.dump(4);
+
+        file file(str(path), true);
+        if (!file.opened()) {
+            log()->error("write memory stats {}", path);
+            return false;
+        }
+
+        file.write(content.data(), content.size());
+
+        log()->info("memory stats written to {}", path);
+        return true;
+    }
+
 } // namespace lava
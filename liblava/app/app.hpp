@@ -9,6 +9,8 @@
 #include <liblava/app/forward_shading.hpp>
 #include <liblava/block.hpp>
 #include <liblava/frame.hpp>
+#include <liblava/resource/defragmenter.hpp>
+#include <liblava/resource/staging.hpp>
 
 namespace lava {
 
@@ -29,6 +31,8 @@ namespace lava {
         lava::camera camera;
 
         lava::staging staging;
+        lava::immediate_submit immediate;
+        lava::defragmenter defragmenter;
         lava::block block;
 
         lava::renderer renderer;
@@ -56,6 +60,9 @@ namespace lava {
 
         void draw_about(bool separator = true) const;
 
+        // heap budgets and allocations by tag
+        void draw_memory_stats() const;
+
         app_config config;
         json_file config_file;
 
@@ -87,9 +94,15 @@ namespace lava {
         bool toggle_v_sync = false;
         ui32 frame_counter = 0;
 
+        bool resources_moved = false;
+
         json_file::callback config_callback;
 
         id block_command;
     };
 
+    void to_json(json& j, memory_stats const& stats);
+
+    bool write_memory_stats(device_cptr device, string_ref path);
+
 } // namespace lava
@@ -22,7 +22,13 @@ namespace lava {
 
         index physical_device = 0;
 
+        // stage uploads on a dedicated transfer queue (if available, opt-in)
+        bool transfer_queue = false;
+
         imgui::font imgui_font;
+
+        // memory statistics written on shutdown (if not empty)
+        string memory_stats_file;
     };
 
     window::state::optional load_window_state(name save_name);
@@ -20,6 +20,29 @@ namespace lava {
     constexpr name _v_sync_ = "v-sync";
     constexpr name _physical_device_ = "physical device";
 
+    // memory stats
+    constexpr name _memory_stats_file_ = "memory_stats.json";
+    constexpr name _budget_supported_ = "budget supported";
+    constexpr name _allocation_count_ = "allocation count";
+    constexpr name _used_bytes_ = "used bytes";
+    constexpr name _unused_bytes_ = "unused bytes";
+    constexpr name _heaps_ = "heaps";
+    constexpr name _device_local_ = "device local";
+    constexpr name _size_ = "size";
+    constexpr name _budget_ = "budget";
+    constexpr name _usage_ = "usage";
+    constexpr name _peak_usage_ = "peak usage";
+    constexpr name _block_bytes_ = "block bytes";
+    constexpr name _allocation_bytes_ = "allocation bytes";
+    constexpr name _block_count_ = "block count";
+    constexpr name _tags_ = "tags";
+    constexpr name _count_ = "count";
+    constexpr name _bytes_ = "bytes";
+    constexpr name _peak_bytes_ = "peak bytes";
+    constexpr name _cpu_ = "cpu";
+    constexpr name _total_count_ = "total count";
+    constexpr name _arena_count_ = "arena count";
+
     // debug utils
     constexpr name _lava_block_ = "lava block";
     constexpr name _lava_gui_ = "lava gui";
@@ -294,8 +294,13 @@ namespace lava {
         max_frames = mf;
 
         for (auto i = 0u; i < max_frames; ++i) {
-            vertex_buffers.push_back(make_buffer());
-            index_buffers.push_back(make_buffer());
+            auto vertex_buffer = make_buffer();
+            vertex_buffer->set_memory_tag(memory_tag::ui);
+            vertex_buffers.push_back(vertex_buffer);
+
+            auto index_buffer = make_buffer();
+            index_buffer->set_memory_tag(memory_tag::ui);
+            index_buffers.push_back(index_buffer);
         }
 
         pipeline->set_vertex_input_binding({ 0, sizeof(ImDrawVert), VK_VERTEX_INPUT_RATE_VERTEX });
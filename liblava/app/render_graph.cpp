@@ -0,0 +1,526 @@
+// file      : liblava/app/render_graph.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/app/render_graph.hpp>
+
+namespace lava {
+
+    resource_state get_resource_state(resource_usage usage) {
+        switch (usage) {
+        case resource_usage::color_attachment:
+            return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                     VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                     VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, true };
+
+        case resource_usage::depth_attachment:
+            return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                     VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                     VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, true };
+
+        case resource_usage::depth_read:
+            return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                     VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                     VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, false };
+
+        case resource_usage::input_attachment:
+            return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                     VK_ACCESS_INPUT_ATTACHMENT_READ_BIT, false };
+
+        case resource_usage::sampled:
+            return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                     VK_ACCESS_SHADER_READ_BIT, false };
+
+        case resource_usage::storage_read:
+            return { VK_IMAGE_LAYOUT_GENERAL,
+                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                     VK_ACCESS_SHADER_READ_BIT, false };
+
+        case resource_usage::storage_write:
+            return { VK_IMAGE_LAYOUT_GENERAL,
+                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                     VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, true };
+
+        case resource_usage::transfer_src:
+            return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+                     VK_ACCESS_TRANSFER_READ_BIT, false };
+
+        case resource_usage::transfer_dst:
+            return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+                     VK_ACCESS_TRANSFER_WRITE_BIT, true };
+
+        case resource_usage::vertex_buffer:
+            return { VK_IMAGE_LAYOUT_UNDEFINED,
+                     VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                     VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, false };
+
+        case resource_usage::index_buffer:
+            return { VK_IMAGE_LAYOUT_UNDEFINED,
+                     VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                     VK_ACCESS_INDEX_READ_BIT, false };
+
+        case resource_usage::uniform_buffer:
+            return { VK_IMAGE_LAYOUT_UNDEFINED,
+                     VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                     VK_ACCESS_UNIFORM_READ_BIT, false };
+
+        case resource_usage::indirect_buffer:
+            return { VK_IMAGE_LAYOUT_UNDEFINED,
+                     VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                     VK_ACCESS_INDIRECT_COMMAND_READ_BIT, false };
+        }
+
+        return {};
+    }
+
+    VkImageUsageFlags get_image_usage(resource_usage usage) {
+        switch (usage) {
+        case resource_usage::color_attachment:
+            return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+        case resource_usage::depth_attachment:
+        case resource_usage::depth_read:
+            return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+
+        case resource_usage::input_attachment:
+            return VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+        case resource_usage::sampled:
+            return VK_IMAGE_USAGE_SAMPLED_BIT;
+
+        case resource_usage::storage_read:
+        case resource_usage::storage_write:
+            return VK_IMAGE_USAGE_STORAGE_BIT;
+
+        case resource_usage::transfer_src:
+            return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+        case resource_usage::transfer_dst:
+            return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+        default:
+            return 0;
+        }
+    }
+
+    bool render_graph::create(device_ptr d, index frame_count) {
+        device = d;
+
+        if (!pool.create(device, frame_count))
+            return false;
+
+        dirty = true;
+
+        return true;
+    }
+
+    void render_graph::destroy() {
+        if (!device)
+            return;
+
+        pool.destroy();
+
+        device = nullptr;
+    }
+
+    void render_graph::clear() {
+        resources.clear();
+        passes.clear();
+        final_barriers.clear();
+
+        dirty = true;
+    }
+
+    index render_graph::add_image(string_ref name, VkFormat format, uv2 size) {
+        resource_entry entry;
+        entry.name = name;
+        entry.transient = true;
+        entry.format = format;
+        entry.size = size;
+        entry.external_stage = 0;
+        entry.external_access = 0;
+
+        resources.push_back(entry);
+        dirty = true;
+
+        return to_index(resources.size() - 1);
+    }
+
+    index render_graph::import_image(string_ref name, image::ptr image, VkImageLayout initial_layout, VkImageLayout final_layout) {
+        resource_entry entry;
+        entry.name = name;
+        entry.image = image;
+        entry.format = image ? image->get_format() : VK_FORMAT_UNDEFINED;
+        entry.initial_layout = initial_layout;
+        entry.final_layout = final_layout == VK_IMAGE_LAYOUT_UNDEFINED ? initial_layout : final_layout;
+
+        resources.push_back(entry);
+        dirty = true;
+
+        return to_index(resources.size() - 1);
+    }
+
+    index render_graph::import_buffer(string_ref name, buffer::ptr buffer) {
+        resource_entry entry;
+        entry.name = name;
+        entry.is_image = false;
+        entry.buffer = buffer;
+
+        resources.push_back(entry);
+        dirty = true;
+
+        return to_index(resources.size() - 1);
+    }
+
+    void render_graph::set_image(index resource, image::ptr image) {
+        resources.at(resource).image = image;
+    }
+
+    void render_graph::set_external_writes(index resource, VkPipelineStageFlags stage, VkAccessFlags access) {
+        auto& entry = resources.at(resource);
+        entry.external_stage = stage;
+        entry.external_access = access;
+
+        dirty = true;
+    }
+
+    void render_graph::set_output(index resource) {
+        resources.at(resource).output = true;
+        dirty = true;
+    }
+
+    index render_graph::add_pass(string_ref name, use::list const& uses, execute_func func, bool side_effects) {
+        pass_entry entry;
+        entry.name = name;
+        entry.uses = uses;
+        entry.on_execute = func;
+        entry.side_effects = side_effects;
+
+        passes.push_back(entry);
+        dirty = true;
+
+        return to_index(passes.size() - 1);
+    }
+
+    bool render_graph::compile() {
+        for (auto& current : passes) {
+            for (auto& use : current.uses) {
+                if (use.resource >= resources.size()) {
+                    log()->error("render graph - pass {} uses unknown resource {}", current.name, use.resource);
+                    return false;
+                }
+            }
+        }
+
+        // back to front, earlier writers of a needed resource are kept
+        std::vector<bool> needed(resources.size(), false);
+        for (auto i = 0u; i < resources.size(); ++i)
+            needed[i] = resources[i].output;
+
+        for (auto p = passes.size(); p-- > 0;) {
+            auto& current = passes[p];
+
+            auto used = current.side_effects;
+            for (auto& use : current.uses)
+                if (get_resource_state(use.usage).write && needed[use.resource])
+                    used = true;
+
+            current.culled = !used;
+            current.barriers.clear();
+
+            if (!used)
+                continue;
+
+            for (auto& use : current.uses)
+                needed[use.resource] = true;
+        }
+
+        // lifetimes in order of the remaining passes
+        for (auto& resource : resources) {
+            resource.used = false;
+            resource.first_pass = 0;
+            resource.last_pass = 0;
+
+            if (resource.transient)
+                resource.usage = 0;
+        }
+
+        ui32 order = 0;
+        for (auto& current : passes) {
+            if (current.culled)
+                continue;
+
+            for (auto& use : current.uses) {
+                auto& resource = resources[use.resource];
+
+                if (!resource.used)
+                    resource.first_pass = order;
+
+                resource.used = true;
+                resource.last_pass = order;
+
+                if (resource.transient)
+                    resource.usage |= get_image_usage(use.usage);
+            }
+
+            ++order;
+        }
+
+        struct state {
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            VkPipelineStageFlags write_stage = 0;
+            VkAccessFlags write_access = 0;
+
+            VkPipelineStageFlags read_stages = 0;
+
+            // synchronized with the last write
+            VkPipelineStageFlags visible_stages = 0;
+            VkAccessFlags visible_access = 0;
+        };
+
+        std::vector<state> states(resources.size());
+        for (auto i = 0u; i < resources.size(); ++i) {
+            states[i].layout = resources[i].initial_layout;
+            states[i].write_stage = resources[i].external_stage;
+            states[i].write_access = resources[i].external_access;
+        }
+
+        // transient images past their last pass, their memory may be reused
+        VkPipelineStageFlags retired_stage = 0;
+        VkAccessFlags retired_access = 0;
+
+        order = 0;
+        for (auto& current : passes) {
+            if (current.culled)
+                continue;
+
+            for (auto& use : current.uses) {
+                auto const& resource = resources[use.resource];
+                auto& last = states[use.resource];
+
+                auto const target = get_resource_state(use.usage);
+                auto const layout = resource.is_image ? target.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+                auto const transition = resource.is_image && (layout != last.layout);
+
+                barrier result{
+                    .resource = use.resource,
+                    .old_layout = last.layout,
+                    .new_layout = layout,
+                    .dst_stage = target.stage,
+                    .dst_access = target.access,
+                };
+
+                if (target.write || transition) {
+                    // after all reads and the last write
+                    result.src_stage = last.write_stage | last.read_stages;
+                    result.src_access = last.write_access;
+
+                    if (resource.transient && (resource.first_pass == order)) {
+                        result.src_stage |= retired_stage;
+                        result.src_access |= retired_access;
+                    }
+
+                    if ((result.src_stage != 0) || transition) {
+                        if (result.src_stage == 0)
+                            result.src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+                        current.barriers.push_back(result);
+                    }
+
+                    last.layout = layout;
+
+                    // a transition is a write finished before the stages of this use
+                    last.write_stage = target.stage;
+                    last.write_access = target.write ? target.access : 0;
+                    last.read_stages = 0;
+
+                    last.visible_stages = target.stage;
+                    last.visible_access = target.access;
+                } else {
+                    // reads after reads only wait for the last write once per stage
+                    auto const visible = ((target.stage & ~last.visible_stages) == 0)
+                                         && ((target.access & ~last.visible_access) == 0);
+
+                    if (!visible && (last.write_stage != 0)) {
+                        result.src_stage = last.write_stage;
+                        result.src_access = last.write_access;
+
+                        current.barriers.push_back(result);
+                    }
+
+                    last.read_stages |= target.stage;
+                    last.visible_stages |= target.stage;
+                    last.visible_access |= target.access;
+                }
+            }
+
+            for (auto& use : current.uses) {
+                auto const& resource = resources[use.resource];
+                if (!resource.transient || (resource.last_pass != order))
+                    continue;
+
+                retired_stage |= states[use.resource].write_stage | states[use.resource].read_stages;
+                retired_access |= states[use.resource].write_access;
+            }
+
+            ++order;
+        }
+
+        final_barriers.clear();
+
+        for (auto i = 0u; i < resources.size(); ++i) {
+            auto const& resource = resources[i];
+            if (!resource.is_image || resource.transient || !resource.used)
+                continue;
+
+            auto const& last = states[i];
+            if (resource.final_layout == last.layout)
+                continue;
+
+            auto const present = resource.final_layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+            barrier result{
+                .resource = i,
+                .old_layout = last.layout,
+                .new_layout = resource.final_layout,
+                .src_stage = last.write_stage | last.read_stages,
+                .dst_stage = present ? VkPipelineStageFlags(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT)
+                                     : VkPipelineStageFlags(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT),
+                .src_access = last.write_access,
+                .dst_access = present ? VkAccessFlags(0) : VkAccessFlags(VK_ACCESS_MEMORY_READ_BIT),
+            };
+
+            if (result.src_stage == 0)
+                result.src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+            final_barriers.push_back(result);
+        }
+
+        dirty = false;
+
+        return true;
+    }
+
+    image::ptr render_graph::get_image(index resource) const {
+        auto const& entry = resources.at(resource);
+        if (!entry.transient)
+            return entry.image;
+
+        if (entry.pool_request == no_index)
+            return nullptr;
+
+        return pool.get(entry.pool_request);
+    }
+
+    buffer::ptr render_graph::get_buffer(index resource) const {
+        return resources.at(resource).buffer;
+    }
+
+    void render_graph::record_barriers(VkCommandBuffer cmd_buf, barrier::list const& barriers) const {
+        if (barriers.empty())
+            return;
+
+        std::vector<VkImageMemoryBarrier> image_barriers;
+        std::vector<VkBufferMemoryBarrier> buffer_barriers;
+
+        VkPipelineStageFlags src_stage = 0;
+        VkPipelineStageFlags dst_stage = 0;
+
+        for (auto& current : barriers) {
+            auto const& entry = resources.at(current.resource);
+
+            if (entry.is_image) {
+                auto const target = get_image(current.resource);
+                if (!target)
+                    continue;
+
+                image_barriers.push_back({
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .srcAccessMask = current.src_access,
+                    .dstAccessMask = current.dst_access,
+                    .oldLayout = current.old_layout,
+                    .newLayout = current.new_layout,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .image = target->get(),
+                    .subresourceRange = target->get_subresource_range(),
+                });
+            } else {
+                if (!entry.buffer)
+                    continue;
+
+                buffer_barriers.push_back({
+                    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                    .srcAccessMask = current.src_access,
+                    .dstAccessMask = current.dst_access,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .buffer = entry.buffer->get(),
+                    .offset = 0,
+                    .size = VK_WHOLE_SIZE,
+                });
+            }
+
+            src_stage |= current.src_stage;
+            dst_stage |= current.dst_stage;
+        }
+
+        if (image_barriers.empty() && buffer_barriers.empty())
+            return;
+
+        device->call().vkCmdPipelineBarrier(cmd_buf, src_stage, dst_stage, 0, 0, nullptr,
+                                            to_ui32(buffer_barriers.size()), buffer_barriers.data(),
+                                            to_ui32(image_barriers.size()), image_barriers.data());
+    }
+
+    bool render_graph::execute(VkCommandBuffer cmd_buf, index frame) {
+        if (!device) {
+            log()->error("render graph - execute without device");
+            return false;
+        }
+
+        if (dirty && !compile())
+            return false;
+
+        pool.begin(frame);
+
+        for (auto& resource : resources) {
+            resource.pool_request = no_index;
+
+            if (resource.transient && resource.used)
+                resource.pool_request = pool.request(resource.format, resource.size, resource.usage,
+                                                     resource.first_pass, resource.last_pass);
+        }
+
+        if (!pool.end()) {
+            log()->error("render graph - transient images");
+            return false;
+        }
+
+        for (auto& current : passes) {
+            if (current.culled)
+                continue;
+
+            record_barriers(cmd_buf, current.barriers);
+
+            if (current.on_execute)
+                current.on_execute(cmd_buf);
+        }
+
+        record_barriers(cmd_buf, final_barriers);
+
+        return true;
+    }
+
+    id render_graph::add_to(block& target) {
+        return target.add_cmd([&](VkCommandBuffer cmd_buf) {
+            execute(cmd_buf, target.get_current_frame());
+        });
+    }
+
+} // namespace lava
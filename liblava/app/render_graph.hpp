@@ -0,0 +1,197 @@
+// file      : liblava/app/render_graph.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/block/block.hpp>
+#include <liblava/resource/buffer.hpp>
+#include <liblava/resource/transient_image_pool.hpp>
+
+namespace lava {
+
+    enum class resource_usage : type {
+        color_attachment = 0,
+        depth_attachment,
+        depth_read,
+        input_attachment,
+        sampled,
+        storage_read,
+        storage_write,
+        transfer_src,
+        transfer_dst,
+        vertex_buffer,
+        index_buffer,
+        uniform_buffer,
+        indirect_buffer,
+    };
+
+    struct resource_state {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags stage = 0;
+        VkAccessFlags access = 0;
+        bool write = false;
+    };
+
+    resource_state get_resource_state(resource_usage usage);
+    VkImageUsageFlags get_image_usage(resource_usage usage);
+
+    // passes in declaration order with their resources, barriers and transient images are derived
+    struct render_graph : id_obj {
+        using ptr = std::shared_ptr<render_graph>;
+
+        using execute_func = std::function<void(VkCommandBuffer)>;
+
+        struct use {
+            using list = std::vector<use>;
+
+            index resource = 0;
+            resource_usage usage = resource_usage::sampled;
+        };
+
+        struct barrier {
+            using list = std::vector<barrier>;
+
+            index resource = 0;
+
+            VkImageLayout old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkImageLayout new_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            VkPipelineStageFlags src_stage = 0;
+            VkPipelineStageFlags dst_stage = 0;
+
+            VkAccessFlags src_access = 0;
+            VkAccessFlags dst_access = 0;
+        };
+
+        ~render_graph() {
+            destroy();
+        }
+
+        bool create(device_ptr device, index frame_count);
+        void destroy();
+
+        // removes all passes and resources
+        void clear();
+
+        // memory aliased with transient images of other passes
+        index add_image(string_ref name, VkFormat format, uv2 size);
+
+        // returned to final_layout after the graph, undefined keeps the initial layout
+        index import_image(string_ref name, image::ptr image, VkImageLayout initial_layout,
+                           VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED);
+        index import_buffer(string_ref name, buffer::ptr buffer);
+
+        // e.g. swapchain image of the frame
+        void set_image(index resource, image::ptr image);
+
+        // last writes before the graph, 0 for read only data (default all commands)
+        void set_external_writes(index resource, VkPipelineStageFlags stage, VkAccessFlags access);
+
+        // needed after the graph, passes not contributing to an output are culled
+        void set_output(index resource);
+
+        index add_pass(string_ref name, use::list const& uses, execute_func func, bool side_effects = false);
+
+        // culls passes, derives barriers and transient lifetimes
+        bool compile();
+        bool compiled() const {
+            return !dirty;
+        }
+
+        // attachments are transitioned by the graph, render passes keep their layouts
+        bool execute(VkCommandBuffer cmd_buf, index frame);
+
+        // command executing the graph in the frame of the block
+        id add_to(block& target);
+
+        // transient images are valid while executing
+        image::ptr get_image(index resource) const;
+        buffer::ptr get_buffer(index resource) const;
+
+        index get_pass_count() const {
+            return to_index(passes.size());
+        }
+        bool culled(index pass) const {
+            return passes.at(pass).culled;
+        }
+        string_ref get_pass_name(index pass) const {
+            return passes.at(pass).name;
+        }
+
+        barrier::list const& get_barriers(index pass) const {
+            return passes.at(pass).barriers;
+        }
+        barrier::list const& get_final_barriers() const {
+            return final_barriers;
+        }
+
+        // order of the first and last pass using a transient image, culled passes not counted
+        ui32 get_first_pass(index resource) const {
+            return resources.at(resource).first_pass;
+        }
+        ui32 get_last_pass(index resource) const {
+            return resources.at(resource).last_pass;
+        }
+
+        transient_image_pool& get_transient_pool() {
+            return pool;
+        }
+
+    private:
+        struct resource_entry {
+            string name;
+
+            bool is_image = true;
+            bool transient = false;
+            bool output = false;
+
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            uv2 size = uv2(0, 0);
+            VkImageUsageFlags usage = 0;
+
+            lava::image::ptr image;
+            lava::buffer::ptr buffer;
+
+            VkImageLayout initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            VkPipelineStageFlags external_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            VkAccessFlags external_access = VK_ACCESS_MEMORY_WRITE_BIT;
+
+            bool used = false;
+            ui32 first_pass = 0;
+            ui32 last_pass = 0;
+
+            index pool_request = no_index;
+        };
+
+        struct pass_entry {
+            string name;
+            use::list uses;
+            execute_func on_execute;
+
+            bool side_effects = false;
+            bool culled = false;
+
+            barrier::list barriers;
+        };
+
+        void record_barriers(VkCommandBuffer cmd_buf, barrier::list const& barriers) const;
+
+        device_ptr device = nullptr;
+
+        std::vector<resource_entry> resources;
+        std::vector<pass_entry> passes;
+        barrier::list final_barriers;
+
+        bool dirty = true;
+
+        transient_image_pool pool;
+    };
+
+    inline render_graph::ptr make_render_graph() {
+        return std::make_shared<render_graph>();
+    }
+
+} // namespace lava
@@ -5,5 +5,10 @@
 #pragma once
 
 #include <liblava/asset/image_data.hpp>
+#include <liblava/asset/ktx2.hpp>
 #include <liblava/asset/mesh_loader.hpp>
+#include <liblava/asset/texture_atlas.hpp>
+#include <liblava/asset/texture_cache.hpp>
 #include <liblava/asset/texture_loader.hpp>
+#include <liblava/asset/texture_stream.hpp>
+#include <liblava/asset/virtual_texture.hpp>
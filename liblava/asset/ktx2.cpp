@@ -0,0 +1,312 @@
+// file      : liblava/asset/ktx2.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <array>
+#include <liblava/asset/ktx2.hpp>
+#include <liblava/resource/format.hpp>
+
+#if LIBLAVA_ZSTD
+#    include <zstd.h>
+#endif
+
+#if LIBLAVA_BASISU
+#    include <basisu_transcoder.h>
+#    include <mutex>
+#endif
+
+namespace lava {
+
+    constexpr std::array<ui8, 12> const ktx2_identifier = {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+    };
+
+    // identifier + header + index
+    constexpr size_t const ktx2_level_index_offset = 80;
+    constexpr size_t const ktx2_level_index_size = 24;
+
+    // khr data format descriptor
+    constexpr ui8 const ktx2_dfd_model_uastc = 166;
+    constexpr ui8 const ktx2_dfd_transfer_srgb = 2;
+
+    template<typename T>
+    T read_ktx2(cdata const& data, size_t offset) {
+        T result;
+        memcpy(&result, data.ptr + offset, sizeof(T));
+        return result;
+    }
+
+    bool is_ktx2(cdata const& data) {
+        if (!data.ptr || (data.size < ktx2_identifier.size()))
+            return false;
+
+        return memcmp(data.ptr, ktx2_identifier.data(), ktx2_identifier.size()) == 0;
+    }
+
+    bool read_ktx2_header(cdata const& data, ktx2_header& header, ktx2_level::list& levels) {
+        if (!is_ktx2(data) || (data.size < ktx2_level_index_offset)) {
+            log()->error("ktx2 - invalid identifier");
+            return false;
+        }
+
+        header.format = VkFormat(read_ktx2<ui32>(data, 12));
+        header.type_size = read_ktx2<ui32>(data, 16);
+        header.size = { read_ktx2<ui32>(data, 20), read_ktx2<ui32>(data, 24) };
+        header.depth = read_ktx2<ui32>(data, 28);
+        header.layer_count = read_ktx2<ui32>(data, 32);
+        header.face_count = read_ktx2<ui32>(data, 36);
+        header.level_count = read_ktx2<ui32>(data, 40);
+        header.supercompression = ktx2_supercompression(read_ktx2<ui32>(data, 44));
+
+        auto const dfd_offset = read_ktx2<ui32>(data, 48);
+        auto const dfd_size = read_ktx2<ui32>(data, 52);
+
+        // total size + basic descriptor block header, no sums that could wrap
+        if ((dfd_size >= 16) && (dfd_offset <= data.size) && (dfd_size <= data.size - dfd_offset)) {
+            header.uastc = ui8(data.ptr[dfd_offset + 12]) == ktx2_dfd_model_uastc;
+            header.srgb = ui8(data.ptr[dfd_offset + 14]) == ktx2_dfd_transfer_srgb;
+        }
+
+        if ((header.size.x == 0) || (header.face_count == 0)) {
+            log()->error("ktx2 - invalid header");
+            return false;
+        }
+
+        header.size.y = std::max(header.size.y, 1u);
+
+        auto const level_count = std::max(header.level_count, 1u);
+        if ((data.size - ktx2_level_index_offset) / ktx2_level_index_size < level_count) {
+            log()->error("ktx2 - level index out of range");
+            return false;
+        }
+
+        levels.clear();
+
+        for (auto i = 0u; i < level_count; ++i) {
+            auto const offset = ktx2_level_index_offset + i * ktx2_level_index_size;
+
+            ktx2_level level;
+            level.offset = read_ktx2<ui64>(data, offset);
+            level.size = read_ktx2<ui64>(data, offset + 8);
+            level.uncompressed_size = read_ktx2<ui64>(data, offset + 16);
+
+            if ((level.offset > data.size) || (level.size > data.size - level.offset)) {
+                log()->error("ktx2 - level {} out of range", i);
+                return false;
+            }
+
+            levels.push_back(level);
+        }
+
+        return true;
+    }
+
+    texture::layer::list make_ktx2_layers(uv2 size, VkFormat format, ui32 image_count, ui32 level_count) {
+        ui32 block_width = 1;
+        ui32 block_height = 1;
+        format_block_dim(format, block_width, block_height);
+
+        auto const block_size = format_block_size(format);
+
+        texture::layer::list result(image_count);
+
+        for (auto& layer : result) {
+            for (auto m = 0u; m < level_count; ++m) {
+                texture::mip_level level;
+                level.extent = uv2(std::max(size.x >> m, 1u), std::max(size.y >> m, 1u));
+                level.size = ceil_div(level.extent.x, block_width) * ceil_div(level.extent.y, block_height) * block_size;
+
+                layer.levels.push_back(level);
+            }
+        }
+
+        return result;
+    }
+
+    bool allocate_ktx2_data(texture_data& result) {
+        size_t total = 0;
+        for (auto& layer : result.layers)
+            for (auto& level : layer.levels)
+                total += level.size;
+
+        result.data.set(total);
+        if (!result.data.ptr) {
+            log()->error("ktx2 - allocate {} bytes", total);
+            return false;
+        }
+
+        return true;
+    }
+
+#if LIBLAVA_BASISU
+
+    bool transcode_ktx2_texture(cdata const& data, ktx2_header const& header, ui32 image_count,
+                                texture_data& result, VkPhysicalDevice physical_device) {
+        static std::once_flag init_flag;
+        std::call_once(init_flag, []() { basist::basisu_transcoder_init(); });
+
+        basist::ktx2_transcoder transcoder;
+        if (!transcoder.init(data.ptr, to_ui32(data.size)) || !transcoder.start_transcoding()) {
+            log()->error("ktx2 - init basis transcoder");
+            return false;
+        }
+
+        VkFormat_optional compressed_format;
+        if (physical_device)
+            compressed_format = get_supported_compressed_format(physical_device, header.srgb);
+
+        auto target = basist::transcoder_texture_format::cTFRGBA32;
+        result.format = header.srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+
+        if (compressed_format) {
+            switch (*compressed_format) {
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+                target = basist::transcoder_texture_format::cTFBC7_RGBA;
+                break;
+
+            case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+            case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+                target = basist::transcoder_texture_format::cTFASTC_4x4_RGBA;
+                break;
+
+            default:
+                target = basist::transcoder_texture_format::cTFETC2_RGBA;
+                break;
+            }
+
+            result.format = *compressed_format;
+        }
+
+        auto const level_count = std::max(header.level_count, 1u);
+        result.layers = make_ktx2_layers(header.size, result.format, image_count, level_count);
+
+        if (!allocate_ktx2_data(result))
+            return false;
+
+        ui32 block_width = 1;
+        ui32 block_height = 1;
+        format_block_dim(result.format, block_width, block_height);
+
+        auto dst = result.data.ptr;
+
+        for (auto i = 0u; i < image_count; ++i) {
+            auto const layer = i / header.face_count;
+            auto const face = i % header.face_count;
+
+            for (auto m = 0u; m < level_count; ++m) {
+                auto const& level = result.layers[i].levels[m];
+
+                // blocks or pixels
+                auto const count = ceil_div(level.extent.x, block_width) * ceil_div(level.extent.y, block_height);
+
+                if (!transcoder.transcode_image_level(m, layer, face, dst, count, target)) {
+                    log()->error("ktx2 - transcode level {} image {}", m, i);
+                    return false;
+                }
+
+                dst += level.size;
+            }
+        }
+
+        return true;
+    }
+
+#endif
+
+} // namespace lava
+
+bool lava::load_ktx2_texture(cdata const& data, texture_data& result, VkPhysicalDevice physical_device) {
+    ktx2_header header;
+    ktx2_level::list levels;
+    if (!read_ktx2_header(data, header, levels))
+        return false;
+
+    if (header.depth > 1) {
+        log()->error("ktx2 - 3d textures not supported");
+        return false;
+    }
+
+    if ((header.face_count == 6) && (header.layer_count > 0)) {
+        log()->error("ktx2 - cube map arrays not supported");
+        return false;
+    }
+
+    result.size = header.size;
+    result.type = header.face_count == 6 ? texture_type::cube_map
+                                         : (header.layer_count > 0 ? texture_type::array : texture_type::tex_2d);
+
+    auto const image_count = std::max(header.layer_count, 1u) * header.face_count;
+
+    if ((header.format == VK_FORMAT_UNDEFINED) || (header.supercompression == ktx2_supercompression::basis_lz)) {
+#if LIBLAVA_BASISU
+        return transcode_ktx2_texture(data, header, image_count, result, physical_device);
+#else
+        log()->error("ktx2 - basis universal support not enabled (LIBLAVA_KTX2_BASISU)");
+        return false;
+#endif
+    }
+
+    result.format = header.format;
+    result.layers = make_ktx2_layers(header.size, header.format, image_count, to_ui32(levels.size()));
+
+    if (!allocate_ktx2_data(result))
+        return false;
+
+    // level major in the file, layer major for upload
+    std::vector<unique_data> level_data(levels.size());
+    std::vector<cdata> level_source(levels.size());
+
+    for (auto m = 0u; m < levels.size(); ++m) {
+        auto const& level = levels[m];
+        level_source[m] = { data.ptr + level.offset, level.size };
+
+        if (header.supercompression == ktx2_supercompression::zstd) {
+#if LIBLAVA_ZSTD
+            level_data[m].set(level.uncompressed_size);
+            if (!level_data[m].ptr)
+                return false;
+
+            auto const size = ZSTD_decompress(level_data[m].ptr, level_data[m].size, level_source[m].ptr, level_source[m].size);
+            if (ZSTD_isError(size) || (size != level.uncompressed_size)) {
+                log()->error("ktx2 - zstd decompress level {}", m);
+                return false;
+            }
+
+            level_source[m] = { level_data[m].ptr, level_data[m].size };
+#else
+            log()->error("ktx2 - zstd support not enabled (LIBLAVA_KTX2_ZSTD)");
+            return false;
+#endif
+        } else if (header.supercompression != ktx2_supercompression::none) {
+            log()->error("ktx2 - supercompression scheme {} not supported", to_ui32(header.supercompression));
+            return false;
+        }
+
+        if (level_source[m].size < size_t(result.layers.front().levels[m].size) * image_count) {
+            log()->error("ktx2 - level {} too small", m);
+            return false;
+        }
+    }
+
+    auto dst = result.data.ptr;
+
+    for (auto i = 0u; i < image_count; ++i) {
+        for (auto m = 0u; m < levels.size(); ++m) {
+            auto const size = result.layers[i].levels[m].size;
+            auto const image_size = level_source[m].size / image_count;
+
+            memcpy(dst, level_source[m].ptr + i * image_size, size);
+            dst += size;
+        }
+    }
+
+    // level count 0 asks for generation at load, 1 is a single authored level
+    ui32 block_width = 1;
+    ui32 block_height = 1;
+    format_block_dim(result.format, block_width, block_height);
+
+    result.mip_levels_generation = (header.level_count == 0) && (block_width == 1) && (block_height == 1);
+
+    return true;
+}
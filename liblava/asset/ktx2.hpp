@@ -0,0 +1,50 @@
+// file      : liblava/asset/ktx2.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/asset/texture_loader.hpp>
+
+namespace lava {
+
+    enum class ktx2_supercompression : ui32 {
+        none = 0,
+        basis_lz,
+        zstd,
+        zlib
+    };
+
+    struct ktx2_header {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        ui32 type_size = 0;
+
+        uv2 size = uv2(0, 0);
+        ui32 depth = 0;
+
+        ui32 layer_count = 0;
+        ui32 face_count = 0;
+        ui32 level_count = 0;
+
+        ktx2_supercompression supercompression = ktx2_supercompression::none;
+
+        bool srgb = false;
+        bool uastc = false;
+    };
+
+    struct ktx2_level {
+        using list = std::vector<ktx2_level>;
+
+        ui64 offset = 0;
+        ui64 size = 0;
+        ui64 uncompressed_size = 0;
+    };
+
+    bool is_ktx2(cdata const& data);
+
+    bool read_ktx2_header(cdata const& data, ktx2_header& header, ktx2_level::list& levels);
+
+    // basis (etc1s / uastc) payloads are transcoded to get_supported_compressed_format or rgba8
+    bool load_ktx2_texture(cdata const& data, texture_data& result, VkPhysicalDevice physical_device = VK_NULL_HANDLE);
+
+} // namespace lava
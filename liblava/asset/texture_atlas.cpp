@@ -0,0 +1,262 @@
+// file      : liblava/asset/texture_atlas.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/asset/image_data.hpp>
+#include <liblava/asset/texture_atlas.hpp>
+#include <liblava/resource/format.hpp>
+
+namespace lava {
+
+    void skyline_packer::reset(uv2 s) {
+        size = s;
+        used_area = 0;
+
+        nodes.clear();
+        nodes.push_back({ 0, 0, size.x });
+    }
+
+    std::optional<ui32> skyline_packer::fit(index node_index, uv2 rect) const {
+        if (nodes[node_index].x + rect.x > size.x)
+            return std::nullopt;
+
+        auto top = 0u;
+        auto remaining = rect.x;
+
+        for (auto i = node_index; remaining > 0; ++i) {
+            if (i >= nodes.size())
+                return std::nullopt;
+
+            top = std::max(top, nodes[i].y);
+            if (top + rect.y > size.y)
+                return std::nullopt;
+
+            remaining -= std::min(remaining, nodes[i].width);
+        }
+
+        return top;
+    }
+
+    std::optional<uv2> skyline_packer::insert(uv2 rect) {
+        if ((rect.x == 0) || (rect.y == 0))
+            return std::nullopt;
+
+        auto best_index = no_index;
+        auto best_top = ~0u;
+        auto best_bottom = ~0u;
+        auto best_width = ~0u;
+
+        for (auto i = 0u; i < nodes.size(); ++i) {
+            auto const top = fit(i, rect);
+            if (!top)
+                continue;
+
+            auto const bottom = *top + rect.y;
+            if ((bottom < best_bottom) || ((bottom == best_bottom) && (nodes[i].width < best_width))) {
+                best_index = i;
+                best_top = *top;
+                best_bottom = bottom;
+                best_width = nodes[i].width;
+            }
+        }
+
+        if (best_index == no_index)
+            return std::nullopt;
+
+        uv2 const position = { nodes[best_index].x, best_top };
+
+        nodes.insert(nodes.begin() + best_index, { position.x, best_bottom, rect.x });
+
+        // cut the covered part off the following nodes
+        for (auto i = best_index + 1; i < nodes.size();) {
+            auto const right = nodes[i - 1].x + nodes[i - 1].width;
+            if (nodes[i].x >= right)
+                break;
+
+            auto const shrink = right - nodes[i].x;
+            if (nodes[i].width > shrink) {
+                nodes[i].x += shrink;
+                nodes[i].width -= shrink;
+                break;
+            }
+
+            nodes.erase(nodes.begin() + i);
+        }
+
+        for (auto i = 0u; i + 1 < nodes.size();) {
+            if (nodes[i].y == nodes[i + 1].y) {
+                nodes[i].width += nodes[i + 1].width;
+                nodes.erase(nodes.begin() + i + 1);
+            } else {
+                ++i;
+            }
+        }
+
+        used_area += ui64(rect.x) * rect.y;
+
+        return position;
+    }
+
+    r32 skyline_packer::get_occupancy() const {
+        auto const area = ui64(size.x) * size.y;
+        return area > 0 ? to_r32(to_r64(used_area) / area) : 0.f;
+    }
+
+    bool texture_atlas::create(device_ptr d, staging* s, uv2 ps, ui32 lc, VkFormat f, ui32 p) {
+        device = d;
+        uploader = s;
+        page_size = ps;
+        layer_count = lc;
+        format = f;
+        padding = p;
+
+        if (!uploader) {
+            log()->error("create texture atlas - no staging");
+            return false;
+        }
+
+        ui32 block_width = 1;
+        ui32 block_height = 1;
+        format_block_dim(format, block_width, block_height);
+
+        if ((format_block_size(format) != 4) || (block_width != 1) || (block_height != 1)) {
+            log()->error("create texture atlas - format {} not supported", to_i32(format));
+            return false;
+        }
+
+        if ((layer_count == 0) || (page_size.x == 0) || (page_size.y == 0)) {
+            log()->error("create texture atlas - invalid page size");
+            return false;
+        }
+
+        return add_page();
+    }
+
+    void texture_atlas::destroy() {
+        pages.clear();
+        packers.clear();
+
+        image_count = 0;
+        image_area = 0;
+
+        uploader = nullptr;
+        device = nullptr;
+    }
+
+    bool texture_atlas::add_page() {
+        texture::layer::list layers(layer_count);
+        for (auto& layer : layers) {
+            texture::mip_level level;
+            level.extent = page_size;
+
+            layer.levels.push_back(level);
+        }
+
+        auto page = make_texture();
+        if (!page->create(device, page_size, format, layers, texture_type::array)) {
+            log()->error("create texture atlas page");
+            return false;
+        }
+
+        uploader->clear_image(page->get_image());
+        pages.push_back(page);
+
+        for (auto i = 0u; i < layer_count; ++i) {
+            skyline_packer packer;
+            packer.reset(page_size);
+
+            packers.push_back(packer);
+        }
+
+        return true;
+    }
+
+    std::optional<atlas_region> texture_atlas::add(uv2 size, void const* data) {
+        if (!uploader || !data || (size.x == 0) || (size.y == 0)) {
+            log()->error("texture atlas add - invalid image");
+            return std::nullopt;
+        }
+
+        uv2 const padded = { size.x + 2 * padding, size.y + 2 * padding };
+        if ((padded.x > page_size.x) || (padded.y > page_size.y)) {
+            log()->error("texture atlas add - image {}x{} exceeds page size", size.x, size.y);
+            return std::nullopt;
+        }
+
+        std::optional<uv2> position;
+
+        auto slot = 0u;
+        for (; slot < packers.size(); ++slot) {
+            position = packers[slot].insert(padded);
+            if (position)
+                break;
+        }
+
+        if (!position) {
+            if (!add_page())
+                return std::nullopt;
+
+            position = packers[slot].insert(padded);
+            if (!position)
+                return std::nullopt;
+        }
+
+        // clamp to edge into the padding
+        std::vector<ui8> texels(size_t(padded.x) * padded.y * 4);
+        auto const source = (ui8 const*) data;
+
+        for (auto y = 0u; y < padded.y; ++y) {
+            auto const sy = to_ui32(std::clamp(to_i32(y) - to_i32(padding), 0, to_i32(size.y) - 1));
+
+            for (auto x = 0u; x < padded.x; ++x) {
+                auto const sx = to_ui32(std::clamp(to_i32(x) - to_i32(padding), 0, to_i32(size.x) - 1));
+                memcpy(texels.data() + (size_t(y) * padded.x + x) * 4, source + (size_t(sy) * size.x + sx) * 4, 4);
+            }
+        }
+
+        atlas_region result;
+        result.page = slot / layer_count;
+        result.layer = slot % layer_count;
+        result.offset = { position->x + padding, position->y + padding };
+        result.size = size;
+        result.uv_rect = { to_r32(result.offset.x) / page_size.x, to_r32(result.offset.y) / page_size.y,
+                           to_r32(result.offset.x + size.x) / page_size.x, to_r32(result.offset.y + size.y) / page_size.y };
+
+        if (!uploader->upload(pages.at(result.page)->get_image(), result.layer, *position, padded,
+                              texels.data(), texels.size()))
+            return std::nullopt;
+
+        ++image_count;
+        image_area += ui64(size.x) * size.y;
+
+        return result;
+    }
+
+    std::optional<atlas_region> texture_atlas::add(string_ref filename) {
+        image_data image(filename);
+        if (!image.ready) {
+            log()->error("texture atlas add - load {}", filename);
+            return std::nullopt;
+        }
+
+        return add(image.size, image.data);
+    }
+
+    texture_atlas::stats texture_atlas::get_stats() const {
+        stats result;
+        result.image_count = image_count;
+        result.page_count = to_ui32(pages.size());
+        result.image_area = image_area;
+
+        for (auto& packer : packers)
+            if (packer.get_used_area() > 0)
+                ++result.layer_count;
+
+        result.layer_area = ui64(result.layer_count) * page_size.x * page_size.y;
+        if (result.layer_area > 0)
+            result.efficiency = to_r32(to_r64(image_area) / result.layer_area);
+
+        return result;
+    }
+
+} // namespace lava
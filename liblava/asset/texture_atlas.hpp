@@ -0,0 +1,111 @@
+// file      : liblava/asset/texture_atlas.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/resource/staging.hpp>
+#include <optional>
+
+namespace lava {
+
+    // bottom left skyline, cpu only
+    struct skyline_packer {
+        void reset(uv2 size);
+
+        // top left corner, nullopt when full
+        std::optional<uv2> insert(uv2 size);
+
+        uv2 get_size() const {
+            return size;
+        }
+
+        ui64 get_used_area() const {
+            return used_area;
+        }
+
+        r32 get_occupancy() const;
+
+    private:
+        struct node {
+            ui32 x = 0;
+            ui32 y = 0;
+            ui32 width = 0;
+        };
+
+        // top of the rect when placed at node, nullopt if it does not fit
+        std::optional<ui32> fit(index node_index, uv2 rect) const;
+
+        std::vector<node> nodes;
+        uv2 size = uv2(0, 0);
+        ui64 used_area = 0;
+    };
+
+    struct atlas_region {
+        index page = 0;
+        ui32 layer = 0;
+
+        uv2 offset = uv2(0, 0);
+        uv2 size = uv2(0, 0);
+
+        // u0, v0, u1, v1
+        v4 uv_rect = v4(0.f);
+    };
+
+    struct texture_atlas {
+        ~texture_atlas() {
+            destroy();
+        }
+
+        // pages are texture arrays, a new one is added when all layers are full
+        bool create(device_ptr device, staging* staging, uv2 page_size = { 1024, 1024 }, ui32 layer_count = 4,
+                    VkFormat format = VK_FORMAT_R8G8B8A8_SRGB, ui32 padding = 1);
+        void destroy();
+
+        // rgba8 texels, edges are extruded into the padding
+        std::optional<atlas_region> add(uv2 size, void const* data);
+        std::optional<atlas_region> add(string_ref filename);
+
+        texture::list const& get_pages() const {
+            return pages;
+        }
+
+        texture::ptr get_page(index page) const {
+            return pages.at(page);
+        }
+
+        struct stats {
+            ui32 image_count = 0;
+            ui32 page_count = 0;
+            ui32 layer_count = 0; // layers in use
+
+            ui64 image_area = 0;
+            ui64 layer_area = 0;
+
+            // image area of layers in use
+            r32 efficiency = 0.f;
+        };
+
+        stats get_stats() const;
+
+    private:
+        bool add_page();
+
+        device_ptr device = nullptr;
+        staging* uploader = nullptr;
+
+        uv2 page_size = uv2(0, 0);
+        ui32 layer_count = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        ui32 padding = 0;
+
+        texture::list pages;
+
+        // one per layer of all pages
+        std::vector<skyline_packer> packers;
+
+        ui32 image_count = 0;
+        ui64 image_area = 0;
+    };
+
+} // namespace lava
@@ -0,0 +1,354 @@
+// file      : liblava/asset/texture_cache.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <array>
+#include <cstring>
+#include <liblava/asset/texture_cache.hpp>
+#include <liblava/base/physical_device.hpp>
+#include <liblava/file.hpp>
+
+namespace lava {
+
+    ui64 hash_texture_file(file_format const& file_format, texture_type type, cdata const& file_data) {
+        ui64 result = 14695981039346656037ull;
+
+        auto hash = [&](void const* data, size_t size) {
+            auto const bytes = (ui8 const*) data;
+            for (size_t i = 0; i < size; ++i) {
+                result ^= bytes[i];
+                result *= 1099511628211ull;
+            }
+        };
+
+        if (file_data.ptr)
+            hash(file_data.ptr, file_data.size);
+        else
+            hash(file_format.path.data(), file_format.path.size());
+
+        hash(&file_format.format, sizeof(file_format.format));
+        hash(&type, sizeof(type));
+
+        return result;
+    }
+
+    bool same_texture_file(file_format const& file_format, texture_type type, cdata const& file_data,
+                           lava::file_format const& other, texture_type other_type) {
+        if ((file_format.format != other.format) || (type != other_type))
+            return false;
+
+        if (!file_data.ptr)
+            return file_format.path == other.path;
+
+        file other_file(str(other.path));
+        if (!other_file.opened() || (to_size_t(other_file.get_size()) != file_data.size))
+            return false;
+
+        unique_data other_data(file_data.size, false);
+        if (!other_data.allocate() || file_error(other_file.read(other_data.ptr)))
+            return false;
+
+        return memcmp(file_data.ptr, other_data.ptr, file_data.size) == 0;
+    }
+
+    VkDeviceSize get_texture_memory_size(device_ptr device, texture::ptr const& texture) {
+        auto image = texture->get_image();
+        if (!image || !image->get_allocation())
+            return 0;
+
+        VmaAllocationInfo info{};
+        vmaGetAllocationInfo(device->alloc(), image->get_allocation(), &info);
+
+        return info.size;
+    }
+
+    // loaded and only referenced by the cache
+    bool texture_cache_unused(std::shared_future<texture::ptr> const& result) {
+        if (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+
+        return result.get().use_count() == 1;
+    }
+
+    bool texture_cache::create(device_ptr d, staging* s, VkDeviceSize b) {
+        device = d;
+        uploader = s;
+        budget = b;
+
+        if (!uploader) {
+            log()->error("create texture cache - no staging");
+            return false;
+        }
+
+        frame = 0;
+
+        return true;
+    }
+
+    void texture_cache::destroy() {
+        std::unique_lock<std::mutex> lock(entry_mutex);
+
+        paths.clear();
+        hashes.clear();
+        textures.clear();
+        created.clear();
+
+        uploader = nullptr;
+        device = nullptr;
+    }
+
+    texture::ptr texture_cache::load(file_format file_format, texture_type type) {
+        std::promise<texture::ptr> promise;
+
+        auto current = std::make_shared<entry>();
+        current->result = promise.get_future().share();
+
+        {
+            std::unique_lock<std::mutex> lock(entry_mutex);
+
+            auto const it = paths.find(file_format.path);
+            if (it != paths.end()) {
+                auto target = it->second;
+                target->last_used = frame;
+
+                lock.unlock();
+                return target->result.get();
+            }
+
+            current->last_used = frame;
+            paths.emplace(file_format.path, current);
+        }
+
+        // read once for the hash and the decoder
+        file file(str(file_format.path));
+        unique_data file_data(file.get_size(), false);
+
+        auto const in_memory = file.opened() && file_data.allocate() && !file_error(file.read(file_data.ptr));
+
+        auto const content = in_memory ? cdata(file_data) : cdata();
+        auto const hash = hash_texture_file(file_format, type, content);
+
+        current->file_format = file_format;
+        current->type = type;
+
+        // entries with the same hash are compared outside of the lock
+        std::vector<entry::ptr> compared;
+
+        for (;;) {
+            std::unique_lock<std::mutex> lock(entry_mutex);
+
+            std::vector<entry::ptr> candidates;
+
+            auto const [first, last] = hashes.equal_range(hash);
+            for (auto it = first; it != last; ++it)
+                if (std::find(compared.begin(), compared.end(), it->second) == compared.end())
+                    candidates.push_back(it->second);
+
+            if (candidates.empty()) {
+                current->hash = hash;
+                hashes.emplace(hash, current);
+                break;
+            }
+
+            lock.unlock();
+
+            entry::ptr target;
+            for (auto& candidate : candidates) {
+                compared.push_back(candidate);
+
+                if (same_texture_file(file_format, type, content, candidate->file_format, candidate->type)) {
+                    target = candidate;
+                    break;
+                }
+            }
+
+            if (!target)
+                continue;
+
+            lock.lock();
+
+            // removed while compared
+            auto const kept = hashes.equal_range(hash);
+            if (std::find_if(kept.first, kept.second, [&](auto const& it) { return it.second == target; }) == kept.second)
+                continue;
+
+            // same content under another path
+            target->last_used = frame;
+            paths[file_format.path] = target;
+
+            lock.unlock();
+
+            auto result = target->result.get();
+            promise.set_value(result);
+
+            if (!result) {
+                lock.lock();
+
+                auto const path = paths.find(file_format.path);
+                if ((path != paths.end()) && (path->second == target))
+                    paths.erase(path);
+            }
+
+            return result;
+        }
+
+        texture::ptr result;
+        if (in_memory) {
+            texture_data data;
+            if (load_texture_data(file_format, type, file_data, data, device->get_vk_physical_device()))
+                result = create_texture(device, data);
+        } else {
+            result = load_texture(device, file_format, type);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(entry_mutex);
+
+            if (result) {
+                current->size = get_texture_memory_size(device, result);
+
+                textures.emplace(result.get(), current);
+                created.push_back(result);
+            } else {
+                log()->error("texture cache - load {}", str(file_format.path));
+
+                // next load tries again
+                remove(current);
+            }
+        }
+
+        promise.set_value(result);
+
+        return result;
+    }
+
+    void texture_cache::touch(texture::ptr const& texture) {
+        std::unique_lock<std::mutex> lock(entry_mutex);
+
+        auto const it = textures.find(texture.get());
+        if (it != textures.end())
+            it->second->last_used = frame;
+    }
+
+    void texture_cache::update() {
+        std::vector<entry::ptr> evicted;
+
+        {
+            std::unique_lock<std::mutex> lock(entry_mutex);
+
+            for (auto& texture : created)
+                uploader->add(texture);
+
+            created.clear();
+
+            auto pressure = get_pressure();
+            if (pressure > 0) {
+                for (auto& [texture, target] : textures) {
+                    if (target->last_used + keep_frames >= frame)
+                        continue;
+
+                    if (texture_cache_unused(target->result))
+                        evicted.push_back(target);
+                }
+
+                std::sort(evicted.begin(), evicted.end(),
+                          [](auto const& a, auto const& b) { return a->last_used < b->last_used; });
+
+                auto count = 0u;
+                for (; (count < evicted.size()) && (pressure > 0); ++count) {
+                    pressure -= std::min(pressure, evicted[count]->size);
+                    remove(evicted[count]);
+                }
+
+                evicted.resize(count);
+            }
+
+            ++frame;
+        }
+
+        // evicted textures are released on return, outside of the lock
+        if (!evicted.empty())
+            log()->debug("texture cache - evicted {} textures", evicted.size());
+    }
+
+    void texture_cache::clear() {
+        std::vector<entry::ptr> evicted;
+
+        std::unique_lock<std::mutex> lock(entry_mutex);
+
+        for (auto& [texture, target] : textures)
+            if (texture_cache_unused(target->result))
+                evicted.push_back(target);
+
+        for (auto& target : evicted)
+            remove(target);
+    }
+
+    size_t texture_cache::size() const {
+        std::unique_lock<std::mutex> lock(entry_mutex);
+        return textures.size();
+    }
+
+    VkDeviceSize texture_cache::get_used() const {
+        std::unique_lock<std::mutex> lock(entry_mutex);
+
+        VkDeviceSize result = 0;
+        for (auto& [texture, target] : textures)
+            result += target->size;
+
+        return result;
+    }
+
+    VkDeviceSize texture_cache::get_pressure() const {
+        if (budget > 0) {
+            VkDeviceSize used = 0;
+            for (auto& [texture, target] : textures)
+                used += target->size;
+
+            return used > budget ? used - budget : 0;
+        }
+
+        auto const& properties = device->get_physical_device()->get_memory_properties();
+
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> heap_budgets{};
+        vmaGetBudget(device->alloc(), heap_budgets.data());
+
+        VkDeviceSize result = 0;
+
+        for (auto i = 0u; i < properties.memoryHeapCount; ++i) {
+            if (!(properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+                continue;
+
+            auto const& heap = heap_budgets.at(i);
+            if (heap.usage > heap.budget)
+                result = std::max(result, heap.usage - heap.budget);
+        }
+
+        return result;
+    }
+
+    void texture_cache::remove(entry::ptr const& target) {
+        for (auto it = paths.begin(); it != paths.end();) {
+            if (it->second == target)
+                it = paths.erase(it);
+            else
+                ++it;
+        }
+
+        auto const [first, last] = hashes.equal_range(target->hash);
+        for (auto it = first; it != last; ++it) {
+            if (it->second == target) {
+                hashes.erase(it);
+                break;
+            }
+        }
+
+        for (auto it = textures.begin(); it != textures.end();) {
+            if (it->second == target)
+                it = textures.erase(it);
+            else
+                ++it;
+        }
+    }
+
+} // namespace lava
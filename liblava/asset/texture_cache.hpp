@@ -0,0 +1,99 @@
+// file      : liblava/asset/texture_cache.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <future>
+#include <liblava/asset/texture_loader.hpp>
+#include <liblava/resource/staging.hpp>
+
+namespace lava {
+
+    // fnv-1a over the file content (path if not read), format and type
+    ui64 hash_texture_file(file_format const& file_format, texture_type type, cdata const& file_data);
+
+    // same format, type and content (path if not read) as the other file, resolves hash collisions
+    bool same_texture_file(file_format const& file_format, texture_type type, cdata const& file_data,
+                           lava::file_format const& other, texture_type other_type);
+
+    struct texture_cache {
+        ~texture_cache() {
+            destroy();
+        }
+
+        // budget 0 follows the vma budget of the device local heaps
+        bool create(device_ptr device, staging* staging, VkDeviceSize budget = 0);
+        void destroy();
+
+        // thread safe, waits on a load of the same path or content in flight
+        texture::ptr load(file_format file_format, texture_type type = texture_type::tex_2d);
+
+        texture::ptr load(string_ref filename, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB,
+                          texture_type type = texture_type::tex_2d) {
+            return load({ filename, format }, type);
+        }
+
+        // usage mark for the current frame
+        void touch(texture::ptr const& texture);
+
+        // main thread, once per frame (before staging)
+        void update();
+
+        // drop all textures without outside references
+        void clear();
+
+        size_t size() const;
+
+        VkDeviceSize get_used() const;
+
+        void set_budget(VkDeviceSize value) {
+            budget = value;
+        }
+        VkDeviceSize get_budget() const {
+            return budget;
+        }
+
+        // textures stay resident at least this many frames after their last use
+        void set_keep_frames(ui32 value) {
+            keep_frames = value;
+        }
+        ui32 get_keep_frames() const {
+            return keep_frames;
+        }
+
+    private:
+        struct entry {
+            using ptr = std::shared_ptr<entry>;
+
+            ui64 hash = 0;
+            lava::file_format file_format;
+            texture_type type = texture_type::tex_2d;
+
+            std::shared_future<texture::ptr> result;
+
+            VkDeviceSize size = 0;
+            ui64 last_used = 0;
+        };
+
+        VkDeviceSize get_pressure() const;
+
+        void remove(entry::ptr const& target);
+
+        device_ptr device = nullptr;
+        staging* uploader = nullptr;
+
+        VkDeviceSize budget = 0;
+        ui32 keep_frames = 3;
+        ui64 frame = 0;
+
+        mutable std::mutex entry_mutex;
+
+        std::map<string, entry::ptr> paths;
+        std::multimap<ui64, entry::ptr> hashes;
+        std::map<texture const*, entry::ptr> textures;
+
+        texture::list created;
+    };
+
+} // namespace lava
@@ -2,9 +2,12 @@
 // copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
 // license   : MIT; see accompanying LICENSE file
 
+#include <liblava/asset/ktx2.hpp>
 #include <liblava/asset/texture_loader.hpp>
 #include <liblava/file.hpp>
 #include <liblava/resource/format.hpp>
+#include <liblava/resource/mip_map.hpp>
+#include <liblava/util/thread.hpp>
 
 #ifdef _WIN32
 #    pragma warning(push, 4)
@@ -34,38 +37,52 @@
 
 namespace lava {
 
-    texture::ptr create_gli_texture_2d(device_ptr device, file const& file, VkFormat format, unique_data const& temp_data) {
-        gli::texture2d tex(file.opened() ? gli::load(temp_data.ptr, temp_data.size)
-                                         : gli::load(file.get_path()));
-        assert(!tex.empty());
-        if (tex.empty())
-            return nullptr;
+    bool stbi_file(string_ref path) {
+        return extension(str(path), { "JPG", "PNG", "TGA", "BMP", "PSD", "GIF", "HDR", "PIC" });
+    }
 
-        auto mip_levels = to_ui32(tex.levels());
+    // empty when the file system can not open it, decoders read the path then
+    bool read_texture_file(string_ref path, unique_data& result) {
+        file file(str(path));
+        if (!file.opened())
+            return true;
 
-        texture::layer layer;
+        result.set(file.get_size(), false);
+        if (!result.allocate())
+            return false;
 
-        for (auto m = 0u; m < mip_levels; ++m) {
-            texture::mip_level level;
-            level.extent = { tex[m].extent().x, tex[m].extent().y };
-            level.size = to_ui32(tex[m].size());
+        return !file_error(file.read(result.ptr));
+    }
 
-            layer.levels.push_back(level);
-        }
+    // rgba8, free with stbi_image_free
+    stbi_uc* decode_stbi(string_ref path, cdata const& file_data, uv2& size) {
+        i32 tex_width = 0, tex_height = 0;
+        stbi_uc* data = nullptr;
 
-        texture::layer::list layers;
-        layers.push_back(layer);
+        if (file_data.ptr)
+            data = stbi_load_from_memory((stbi_uc const*) file_data.ptr, to_i32(file_data.size),
+                                         &tex_width, &tex_height, nullptr, STBI_rgb_alpha);
+        else
+            data = stbi_load(str(path), &tex_width, &tex_height, nullptr, STBI_rgb_alpha);
 
-        auto texture = make_texture();
+        size = { tex_width, tex_height };
 
-        uv2 const size = { tex[0].extent().x, tex[0].extent().y };
-        if (!texture->create(device, size, format, layers, texture_type::tex_2d))
-            return nullptr;
+        return data;
+    }
 
-        if (!texture->upload(tex.data(), tex.size()))
-            return nullptr;
+    template<typename T>
+    bool set_gli_texture_data(T const& tex, texture_data& result) {
+        result.size = { tex.extent().x, tex.extent().y };
 
-        return texture;
+        // levels as authored, a single level (e.g. lookup tables or fonts) stays single
+        result.mip_levels_generation = false;
+
+        result.data.set(tex.size());
+        if (!result.data.ptr)
+            return false;
+
+        memcpy(result.data.ptr, tex.data(), tex.size());
+        return true;
     }
 
     template<typename T>
@@ -91,70 +108,92 @@ namespace lava {
         return layers;
     }
 
-    texture::ptr create_gli_texture_array(device_ptr device, file const& file, VkFormat format, unique_data const& temp_data) {
-        gli::texture2d_array tex(file.opened() ? gli::load(temp_data.ptr, temp_data.size)
-                                               : gli::load(file.get_path()));
+    // file content or path when not in memory
+    bool load_gli_texture_2d(string_ref path, cdata const& file_data, texture_data& result) {
+        gli::texture2d tex(file_data.ptr ? gli::load(file_data.ptr, file_data.size)
+                                         : gli::load(path));
         assert(!tex.empty());
         if (tex.empty())
-            return nullptr;
+            return false;
 
-        auto layers = create_layer_list(tex, to_ui32(tex.layers()));
+        auto mip_levels = to_ui32(tex.levels());
 
-        auto texture = make_texture();
+        texture::layer layer;
 
-        uv2 const size = { tex[0].extent().x, tex[0].extent().y };
-        if (!texture->create(device, size, format, layers, texture_type::array))
-            return nullptr;
+        for (auto m = 0u; m < mip_levels; ++m) {
+            texture::mip_level level;
+            level.extent = { tex[m].extent().x, tex[m].extent().y };
+            level.size = to_ui32(tex[m].size());
 
-        if (!texture->upload(tex.data(), tex.size()))
-            return nullptr;
+            layer.levels.push_back(level);
+        }
 
-        return texture;
+        result.layers.push_back(layer);
+
+        return set_gli_texture_data(tex, result);
     }
 
-    texture::ptr create_gli_texture_cube_map(device_ptr device, file const& file, VkFormat format, unique_data const& temp_data) {
-        gli::texture_cube tex(file.opened() ? gli::load(temp_data.ptr, temp_data.size)
-                                            : gli::load(file.get_path()));
+    bool load_gli_texture_array(string_ref path, cdata const& file_data, texture_data& result) {
+        gli::texture2d_array tex(file_data.ptr ? gli::load(file_data.ptr, file_data.size)
+                                               : gli::load(path));
         assert(!tex.empty());
         if (tex.empty())
-            return nullptr;
+            return false;
 
-        auto layers = create_layer_list(tex, to_ui32(tex.faces()));
+        result.layers = create_layer_list(tex, to_ui32(tex.layers()));
 
-        auto texture = make_texture();
+        return set_gli_texture_data(tex, result);
+    }
 
-        uv2 const size = { tex[0].extent().x, tex[0].extent().y };
-        if (!texture->create(device, size, format, layers, texture_type::cube_map))
-            return nullptr;
+    bool load_gli_texture_cube_map(string_ref path, cdata const& file_data, texture_data& result) {
+        gli::texture_cube tex(file_data.ptr ? gli::load(file_data.ptr, file_data.size)
+                                            : gli::load(path));
+        assert(!tex.empty());
+        if (tex.empty())
+            return false;
 
-        if (!texture->upload(tex.data(), tex.size()))
-            return nullptr;
+        result.layers = create_layer_list(tex, to_ui32(tex.faces()));
 
-        return texture;
+        return set_gli_texture_data(tex, result);
     }
 
-    texture::ptr create_stbi_texture(device_ptr device, file const& file, unique_data const& temp_data) {
-        i32 tex_width = 0, tex_height = 0;
-        stbi_uc* data = nullptr;
+    bool load_stbi_texture(string_ref path, cdata const& file_data, texture_data& result) {
+        uv2 size;
+        auto data = decode_stbi(path, file_data, size);
+        if (!data)
+            return false;
 
-        if (file.opened())
-            data = stbi_load_from_memory((stbi_uc const*) temp_data.ptr, to_i32(temp_data.size),
-                                         &tex_width, &tex_height, nullptr, STBI_rgb_alpha);
-        else
-            data = stbi_load(str(file.get_path()), &tex_width, &tex_height, nullptr, STBI_rgb_alpha);
+        result.size = size;
+        result.format = VK_FORMAT_R8G8B8A8_SRGB;
+        result.type = texture_type::tex_2d;
+        result.mip_levels_generation = true;
+
+        result.data.set(size_t(size.x) * size.y * format_block_size(result.format));
+        if (result.data.ptr)
+            memcpy(result.data.ptr, data, result.data.size);
+
+        stbi_image_free(data);
 
+        return result.data.ptr != nullptr;
+    }
+
+    // texture created from the stbi pixels, skips the texture_data copy (upload still copies)
+    texture::ptr create_stbi_texture(device_ptr device, file_format const& file_format) {
+        unique_data file_data;
+        if (!read_texture_file(file_format.path, file_data))
+            return nullptr;
+
+        uv2 size;
+        auto data = decode_stbi(file_format.path, file_data, size);
         if (!data)
             return nullptr;
 
         auto texture = make_texture();
 
-        uv2 const size = { tex_width, tex_height };
-        auto const font_format = VK_FORMAT_R8G8B8A8_SRGB;
-        if (!texture->create(device, size, font_format))
-            return nullptr;
+        auto const format = VK_FORMAT_R8G8B8A8_SRGB;
 
-        auto const uploadSize = tex_width * tex_height * format_block_size(font_format);
-        auto result = texture->upload(data, uploadSize);
+        auto result = texture->create(device, size, format, {}, texture_type::tex_2d, true)
+                      && texture->upload(data, size_t(size.x) * size.y * format_block_size(format));
 
         stbi_image_free(data);
 
@@ -166,48 +205,188 @@ namespace lava {
 
 } // namespace lava
 
-lava::texture::ptr lava::load_texture(device_ptr device, file_format file_format, texture_type type) {
-    auto use_gli = extension(str(file_format.path), { "DDS", "KTX", "KMG" });
-    auto use_stbi = false;
+bool lava::load_texture_data(file_format file_format, texture_type type, texture_data& result, VkPhysicalDevice physical_device) {
+    if (!extension(str(file_format.path), { "KTX2", "DDS", "KTX", "KMG" }) && !stbi_file(file_format.path))
+        return false;
 
-    if (!use_gli)
-        use_stbi = extension(str(file_format.path), { "JPG", "PNG", "TGA", "BMP", "PSD", "GIF", "HDR", "PIC" });
+    unique_data file_data;
+    if (!read_texture_file(file_format.path, file_data))
+        return false;
 
-    if (!use_gli && !use_stbi)
-        return nullptr;
+    return load_texture_data(file_format, type, file_data, result, physical_device);
+}
 
-    file file(str(file_format.path));
-    unique_data temp_data(file.get_size(), false);
+bool lava::load_texture_data(file_format file_format, texture_type type, cdata const& file_data, texture_data& result,
+                             VkPhysicalDevice physical_device) {
+    if (extension(str(file_format.path), "KTX2")) {
+        if (!file_data.ptr) {
+            log()->error("load ktx2 texture - open {}", str(file_format.path));
+            return false;
+        }
 
-    if (file.opened()) {
-        if (!temp_data.allocate())
-            return nullptr;
+        return load_ktx2_texture(file_data, result, physical_device);
+    }
 
-        if (file_error(file.read(temp_data.ptr)))
-            return nullptr;
+    if (stbi_file(file_format.path))
+        return load_stbi_texture(file_format.path, file_data, result);
+
+    if (!extension(str(file_format.path), { "DDS", "KTX", "KMG" }))
+        return false;
+
+    result.format = file_format.format;
+    result.type = type;
+
+    switch (type) {
+    case texture_type::tex_2d: {
+        return load_gli_texture_2d(file_format.path, file_data, result);
     }
 
-    if (use_gli) {
-        texture::layer::list layers;
+    case texture_type::array: {
+        return load_gli_texture_array(file_format.path, file_data, result);
+    }
 
-        switch (type) {
-        case texture_type::tex_2d: {
-            return create_gli_texture_2d(device, file, file_format.format, temp_data);
-        }
+    case texture_type::cube_map: {
+        return load_gli_texture_cube_map(file_format.path, file_data, result);
+    }
+
+    default:
+        break;
+    }
+
+    return false;
+}
 
-        case texture_type::array: {
-            return create_gli_texture_array(device, file, file_format.format, temp_data);
+bool lava::compress_texture_data(texture_data& data, block_format format, thread_pool* pool, ui32 task_count) {
+    auto const srgb = data.format == VK_FORMAT_R8G8B8A8_SRGB;
+    if (!srgb && (data.format != VK_FORMAT_R8G8B8A8_UNORM)) {
+        log()->error("compress texture data - format {} not supported", to_i32(data.format));
+        return false;
+    }
+
+    if (data.layers.empty()) {
+        texture::mip_level level;
+        level.extent = data.size;
+        level.size = to_ui32(data.data.size);
+
+        texture::layer layer;
+        layer.levels.push_back(level);
+        data.layers.push_back(layer);
+    }
+
+    auto const layer_count = data.layers.size();
+
+    texture::layer::list layers(layer_count);
+    std::vector<unique_data> chains(layer_count);
+    std::vector<cdata> sources(layer_count);
+
+    size_t offset = 0;
+    size_t total = 0;
+
+    for (auto i = 0u; i < layer_count; ++i) {
+        auto const& source_layer = data.layers[i];
+        auto const& first = source_layer.levels.front();
+
+        sources[i] = { data.data.ptr + offset, size_t(first.extent.x) * first.extent.y * 4 };
+
+        for (auto& level : source_layer.levels)
+            offset += size_t(level.extent.x) * level.extent.y * 4;
+
+        if (offset > data.data.size) {
+            log()->error("compress texture data - layer {} out of range", i);
+            return false;
         }
 
-        case texture_type::cube_map: {
-            return create_gli_texture_cube_map(device, file, file_format.format, temp_data);
+        if (data.mip_levels_generation) {
+            if (!compute_mip_levels(sources[i], first.extent, 4, chains[i], layers[i].levels, mip_filter::kaiser, srgb))
+                return false;
+
+            sources[i] = chains[i];
+        } else {
+            layers[i] = source_layer;
         }
+
+        for (auto& level : layers[i].levels)
+            total += get_block_compressed_size(level.extent, format);
+    }
+
+    unique_data compressed(total);
+    if (!compressed.ptr) {
+        log()->error("compress texture data - allocate {} bytes", total);
+        return false;
+    }
+
+    auto dst = compressed.ptr;
+
+    for (auto i = 0u; i < layer_count; ++i) {
+        auto src = sources[i].ptr;
+
+        for (auto& level : layers[i].levels) {
+            auto const level_size = size_t(level.extent.x) * level.extent.y * 4;
+
+            unique_data blocks;
+            auto const compressed_level = pool ? compress_blocks({ src, level_size }, level.extent, format, blocks, *pool, task_count)
+                                               : compress_blocks({ src, level_size }, level.extent, format, blocks);
+            if (!compressed_level)
+                return false;
+
+            memcpy(dst, blocks.ptr, blocks.size);
+            level.size = to_ui32(blocks.size);
+
+            dst += blocks.size;
+            src += level_size;
         }
-    } else {
-        return create_stbi_texture(device, file, temp_data);
     }
 
-    return nullptr;
+    // unique_data has no move, hand over the buffers
+    std::swap(data.data.ptr, compressed.ptr);
+    std::swap(data.data.size, compressed.size);
+
+    data.format = get_block_format(format, srgb);
+    data.layers = layers;
+    data.mip_levels_generation = false;
+
+    return true;
+}
+
+lava::texture::ptr lava::create_texture(device_ptr device, texture_data const& data) {
+    auto texture = make_texture();
+
+    if (!texture->create(device, data.size, data.format, data.layers, data.type, data.mip_levels_generation))
+        return nullptr;
+
+    if (!texture->upload(data.data.ptr, data.data.size))
+        return nullptr;
+
+    return texture;
+}
+
+lava::texture::ptr lava::load_texture(device_ptr device, file_format file_format, texture_type type) {
+    texture_data data;
+    if (!load_texture_data(file_format, type, data, device->get_vk_physical_device()))
+        return nullptr;
+
+    return create_texture(device, data);
+}
+
+lava::texture::list lava::load_textures(device_ptr device, file_format::list const& files, thread_pool& pool) {
+    texture::list result(files.size());
+
+    pool.parallel_for(to_ui32(files.size()), [&](index i) {
+        auto const& file_format = files.at(i);
+
+        // device object creation is thread safe, no queue access here
+        if (stbi_file(file_format.path))
+            result[i] = create_stbi_texture(device, file_format);
+        else
+            result[i] = load_texture(device, file_format);
+
+        if (!result[i])
+            log()->error("load texture {}", str(file_format.path));
+
+        return result[i] != nullptr;
+    });
+
+    return result;
 }
 
 lava::texture::ptr lava::create_default_texture(device_ptr device, uv2 size, v3 color, r32 alpha) {
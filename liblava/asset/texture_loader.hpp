@@ -4,10 +4,41 @@
 
 #pragma once
 
+#include <liblava/resource/block_compression.hpp>
 #include <liblava/resource/texture.hpp>
+#include <liblava/util/thread.hpp>
 
 namespace lava {
 
+    struct texture_data {
+        using ptr = std::shared_ptr<texture_data>;
+
+        uv2 size = uv2(0, 0);
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        texture_type type = texture_type::none;
+
+        texture::layer::list layers;
+        unique_data data;
+
+        // data holds level 0 only
+        bool mip_levels_generation = false;
+    };
+
+    // read and decode only, safe to call from worker threads
+    // physical device picks the transcode target for basis textures
+    bool load_texture_data(file_format file_format, texture_type type, texture_data& result,
+                           VkPhysicalDevice physical_device = VK_NULL_HANDLE);
+
+    // file content already in memory, the path extension picks the decoder
+    bool load_texture_data(file_format file_format, texture_type type, cdata const& file_data, texture_data& result,
+                           VkPhysicalDevice physical_device = VK_NULL_HANDLE);
+
+    // rgba8 only, mip levels are filtered on the cpu before encoding (block formats can not be blitted)
+    // blocks of each level are split into task_count tasks on pool (if set) and the calling thread
+    bool compress_texture_data(texture_data& data, block_format format, thread_pool* pool = nullptr, ui32 task_count = 1);
+
+    texture::ptr create_texture(device_ptr device, texture_data const& data);
+
     texture::ptr load_texture(device_ptr device, file_format file_format, texture_type type = texture_type::tex_2d);
 
     inline texture::ptr load_texture(device_ptr device, string_ref filename,
@@ -15,6 +46,9 @@ namespace lava {
         return load_texture(device, { filename, format }, type);
     }
 
+    // read and decode concurrently on the calling thread and pool, result in input order (nullptr on failure)
+    texture::list load_textures(device_ptr device, file_format::list const& files, thread_pool& pool);
+
     texture::ptr create_default_texture(device_ptr device, uv2 size = { 512, 512 }, v3 color = v3(1.f), r32 alpha = 0.7529f);
 
 } // namespace lava
@@ -0,0 +1,182 @@
+// file      : liblava/asset/texture_stream.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/asset/texture_stream.hpp>
+
+namespace lava {
+
+    void streamed_texture::add_update(update_func func) {
+        if (ready()) {
+            func(current);
+            return;
+        }
+
+        updates.push_back(func);
+    }
+
+    void streamed_texture::swap(texture::ptr texture) {
+        current = texture;
+
+        for (auto& func : updates)
+            func(current);
+
+        updates.clear();
+    }
+
+    texture_stream_queue::request::ptr texture_stream_queue::add(file_format file_format, texture_type type,
+                                                                 texture::ptr placeholder) {
+        auto result = std::make_shared<request>();
+
+        result->target = std::make_shared<streamed_texture>();
+        result->target->file = file_format;
+        result->target->type = type;
+        result->target->current = placeholder;
+
+        ++pending;
+
+        return result;
+    }
+
+    void texture_stream_queue::push_decoded(request::ptr const& request) {
+        std::unique_lock<std::mutex> lock(decoded_mutex);
+        decoded.push_back(request);
+    }
+
+    std::vector<texture_stream_queue::request::ptr> texture_stream_queue::take_decoded() {
+        std::vector<request::ptr> result;
+
+        std::unique_lock<std::mutex> lock(decoded_mutex);
+        result.swap(decoded);
+
+        return result;
+    }
+
+    staging::staged_func texture_stream_queue::upload(streamed_texture::ptr const& target, texture::ptr const& loaded) {
+        target->loaded = loaded;
+        target->current_state = streamed_texture::state::uploading;
+
+        uploading.push_back(target);
+
+        return [target](bool result) {
+            target->staged = true;
+            target->staged_result = result;
+        };
+    }
+
+    void texture_stream_queue::fail(streamed_texture::ptr const& target) {
+        target->current_state = streamed_texture::state::failed;
+        target->loaded = nullptr;
+
+        --pending;
+    }
+
+    streamed_texture::list texture_stream_queue::swap_staged() {
+        streamed_texture::list result;
+
+        for (auto& target : uploading) {
+            if (!target->staged)
+                continue;
+
+            if (target->staged_result) {
+                target->current_state = streamed_texture::state::ready;
+                target->swap(target->loaded);
+
+                --pending;
+            } else {
+                fail(target);
+            }
+
+            result.push_back(target);
+        }
+
+        uploading.erase(std::remove_if(uploading.begin(), uploading.end(),
+                                       [](auto const& target) { return target->staged; }),
+                        uploading.end());
+
+        return result;
+    }
+
+    void texture_stream_queue::clear() {
+        {
+            std::unique_lock<std::mutex> lock(decoded_mutex);
+            decoded.clear();
+        }
+
+        uploading.clear();
+        pending = 0;
+    }
+
+    bool texture_stream::create(device_ptr d, staging* s, ui32 thread_count) {
+        device = d;
+        uploader = s;
+
+        if (!uploader) {
+            log()->error("create texture stream - no staging");
+            return false;
+        }
+
+        placeholder = create_default_texture(device);
+        if (!placeholder)
+            return false;
+
+        uploader->add(placeholder);
+
+        pool.setup(thread_count);
+        pool_active = true;
+
+        return true;
+    }
+
+    void texture_stream::destroy() {
+        if (pool_active) {
+            pool.teardown();
+            pool_active = false;
+        }
+
+        queue.clear();
+
+        placeholder = nullptr;
+        uploader = nullptr;
+        device = nullptr;
+    }
+
+    streamed_texture::ptr texture_stream::load(file_format file_format, texture_type type) {
+        auto current = queue.add(file_format, type, placeholder);
+        current->physical_device = device->get_vk_physical_device();
+
+        pool.enqueue([&, current, file_format, type](id::ref) {
+            current->result = load_texture_data(file_format, type, current->data, current->physical_device);
+
+            queue.push_decoded(current);
+        });
+
+        return current->target;
+    }
+
+    void texture_stream::update() {
+        // swap in before new uploads, staged textures are recorded ahead of this frame
+        for (auto& target : queue.swap_staged())
+            if (target->get_state() == streamed_texture::state::failed)
+                log()->error("stream texture {} - upload failed", str(target->get_file_format().path));
+
+        for (auto& current : queue.take_decoded()) {
+            auto& target = current->target;
+
+            texture::ptr texture;
+            if (current->result)
+                texture = create_texture(device, current->data);
+
+            if (!texture) {
+                log()->error("stream texture {}", str(target->get_file_format().path));
+
+                // keeps the placeholder
+                queue.fail(target);
+                continue;
+            }
+
+            uploader->add(texture, queue.upload(target, texture));
+        }
+    }
+
+} // namespace lava
@@ -0,0 +1,148 @@
+// file      : liblava/asset/texture_stream.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/asset/texture_loader.hpp>
+#include <liblava/resource/staging.hpp>
+#include <liblava/util/thread.hpp>
+
+namespace lava {
+
+    struct streamed_texture : id_obj {
+        using ptr = std::shared_ptr<streamed_texture>;
+        using list = std::vector<ptr>;
+
+        enum class state : type {
+            loading = 0,
+            uploading,
+            ready,
+            failed
+        };
+
+        // placeholder until the loaded texture is swapped in
+        texture::ptr get() const {
+            return current;
+        }
+
+        VkDescriptorImageInfo const* get_descriptor_info() const {
+            return current->get_descriptor_info();
+        }
+
+        state get_state() const {
+            return current_state;
+        }
+
+        bool ready() const {
+            return current_state == state::ready;
+        }
+
+        file_format const& get_file_format() const {
+            return file;
+        }
+
+        // called on swap-in, update descriptors here
+        using update_func = std::function<void(texture::ptr)>;
+        void add_update(update_func func);
+
+    private:
+        friend struct texture_stream_queue;
+
+        void swap(texture::ptr texture);
+
+        texture::ptr current;
+        texture::ptr loaded;
+
+        // reported by staging
+        bool staged = false;
+        bool staged_result = false;
+
+        file_format file;
+        texture_type type = texture_type::tex_2d;
+        state current_state = state::loading;
+
+        std::vector<update_func> updates;
+    };
+
+    // streamed textures from request to swap-in, no device
+    struct texture_stream_queue {
+        struct request {
+            using ptr = std::shared_ptr<request>;
+
+            streamed_texture::ptr target;
+            VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+
+            texture_data data;
+            bool result = false;
+        };
+
+        // target shows the placeholder, pending until swapped in or failed
+        request::ptr add(file_format file_format, texture_type type, texture::ptr placeholder);
+
+        // worker threads, after decoding
+        void push_decoded(request::ptr const& request);
+        std::vector<request::ptr> take_decoded();
+
+        // loaded texture waits for staging, the returned function reports the upload
+        staging::staged_func upload(streamed_texture::ptr const& target, texture::ptr const& loaded);
+
+        // decode or create failed, keeps the placeholder
+        void fail(streamed_texture::ptr const& target);
+
+        // swaps in or fails staged textures, returns them
+        streamed_texture::list swap_staged();
+
+        void clear();
+
+        ui32 get_pending() const {
+            return pending;
+        }
+
+    private:
+        std::mutex decoded_mutex;
+        std::vector<request::ptr> decoded;
+
+        streamed_texture::list uploading;
+        ui32 pending = 0;
+    };
+
+    struct texture_stream {
+        ~texture_stream() {
+            destroy();
+        }
+
+        bool create(device_ptr device, staging* staging, ui32 thread_count = 2);
+        void destroy();
+
+        streamed_texture::ptr load(file_format file_format, texture_type type = texture_type::tex_2d);
+
+        streamed_texture::ptr load(string_ref filename, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB,
+                                   texture_type type = texture_type::tex_2d) {
+            return load({ filename, format }, type);
+        }
+
+        // main thread, once per frame (before staging)
+        void update();
+
+        bool busy() const {
+            return queue.get_pending() > 0;
+        }
+
+        texture::ptr get_placeholder() const {
+            return placeholder;
+        }
+
+    private:
+        device_ptr device = nullptr;
+        staging* uploader = nullptr;
+
+        texture::ptr placeholder;
+
+        thread_pool pool;
+        bool pool_active = false;
+
+        texture_stream_queue queue;
+    };
+
+} // namespace lava
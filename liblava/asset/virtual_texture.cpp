@@ -0,0 +1,927 @@
+// file      : liblava/asset/virtual_texture.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <array>
+#include <liblava/asset/virtual_texture.hpp>
+#include <liblava/file.hpp>
+#include <liblava/resource/format.hpp>
+#include <liblava/resource/mip_map.hpp>
+
+namespace lava {
+
+    bool virtual_page_table::create(uv2 s, ui32 ts, ui32 lc, ui32 sc) {
+        size = s;
+        tile_size = ts;
+        level_count = lc;
+        slot_count = sc;
+
+        if ((size.x == 0) || (size.y == 0) || (tile_size == 0) || (slot_count == 0)) {
+            log()->error("create virtual page table - invalid size");
+            return false;
+        }
+
+        if ((level_count == 0) || (level_count > 16)) {
+            log()->error("create virtual page table - {} levels not supported", level_count);
+            return false;
+        }
+
+        auto const page_count = get_page_count();
+        if ((page_count.x > 0x4000) || (page_count.y > 0x4000)) {
+            log()->error("create virtual page table - {}x{} pages exceed the feedback encoding", page_count.x, page_count.y);
+            return false;
+        }
+
+        clear();
+
+        return true;
+    }
+
+    void virtual_page_table::clear() {
+        pages.clear();
+        requested.clear();
+
+        // slot 0 is taken first
+        free_slots.clear();
+        for (auto i = slot_count; i > 0; --i)
+            free_slots.push_back(i - 1);
+
+        frame = 0;
+    }
+
+    uv2 virtual_page_table::get_page_count(ui32 level) const {
+        if (tile_size == 0)
+            return { 0, 0 };
+
+        uv2 const extent = { std::max(size.x >> level, 1u), std::max(size.y >> level, 1u) };
+        return { ceil_div(extent.x, tile_size), ceil_div(extent.y, tile_size) };
+    }
+
+    bool virtual_page_table::valid(virtual_page const& page) const {
+        if (page.level >= level_count)
+            return false;
+
+        auto const page_count = get_page_count(page.level);
+        return (page.x < page_count.x) && (page.y < page_count.y);
+    }
+
+    virtual_page::list virtual_page_table::process_feedback(ui32 const* ids, size_t count, ui32 max_count) {
+        ++frame;
+
+        std::map<ui32, ui32> hits;
+        for (size_t i = 0; i < count; ++i) {
+            auto const page = virtual_page::unpack(ids[i]);
+            if (valid(page))
+                ++hits[page.pack()];
+        }
+
+        // parents are the fallback while a page streams in
+        std::map<ui32, ui32> missing;
+        for (auto& [id, hit] : hits) {
+            for (auto page = virtual_page::unpack(id); page.level < level_count; ++page.level, page.x >>= 1, page.y >>= 1) {
+                auto const current = page.pack();
+
+                auto const it = pages.find(current);
+                if (it != pages.end())
+                    it->second.last_used = frame;
+                else if (!requested.count(current))
+                    missing[current] += hit;
+            }
+        }
+
+        std::vector<std::pair<virtual_page, ui32>> candidates;
+        for (auto& [id, hit] : missing)
+            candidates.push_back({ virtual_page::unpack(id), hit });
+
+        std::sort(candidates.begin(), candidates.end(), [](auto const& a, auto const& b) {
+            if (a.first.level != b.first.level)
+                return a.first.level > b.first.level;
+
+            return a.second > b.second;
+        });
+
+        if (candidates.size() > max_count)
+            candidates.resize(max_count);
+
+        virtual_page::list result;
+        for (auto& [page, hit] : candidates) {
+            requested.insert(page.pack());
+            result.push_back(page);
+        }
+
+        return result;
+    }
+
+    std::optional<ui32> virtual_page_table::make_resident(virtual_page const& page, std::optional<virtual_page>& evicted) {
+        evicted.reset();
+
+        auto const id = page.pack();
+        requested.erase(id);
+
+        if (!valid(page))
+            return std::nullopt;
+
+        auto const it = pages.find(id);
+        if (it != pages.end()) {
+            it->second.last_used = frame;
+            return it->second.slot;
+        }
+
+        auto slot = 0u;
+
+        if (!free_slots.empty()) {
+            slot = free_slots.back();
+            free_slots.pop_back();
+        } else {
+            auto lru = pages.end();
+
+            for (auto current = pages.begin(); current != pages.end(); ++current) {
+                if (current->second.pinned || (current->second.last_used + keep_frames >= frame))
+                    continue;
+
+                if ((lru == pages.end()) || (current->second.last_used < lru->second.last_used))
+                    lru = current;
+            }
+
+            if (lru == pages.end())
+                return std::nullopt;
+
+            slot = lru->second.slot;
+            evicted = virtual_page::unpack(lru->first);
+
+            pages.erase(lru);
+        }
+
+        pages.emplace(id, entry{ slot, frame, false });
+
+        return slot;
+    }
+
+    void virtual_page_table::cancel(virtual_page const& page) {
+        requested.erase(page.pack());
+    }
+
+    void virtual_page_table::pin(virtual_page const& page) {
+        auto const it = pages.find(page.pack());
+        if (it != pages.end())
+            it->second.pinned = true;
+    }
+
+    std::optional<ui32> virtual_page_table::get_slot(virtual_page const& page) const {
+        auto const it = pages.find(page.pack());
+        if (it == pages.end())
+            return std::nullopt;
+
+        return it->second.slot;
+    }
+
+    std::optional<virtual_page> virtual_page_table::find_resident(ui32 x, ui32 y) const {
+        for (auto level = 0u; level < level_count; ++level) {
+            virtual_page const page{ level, x >> level, y >> level };
+            if (resident(page))
+                return page;
+        }
+
+        return std::nullopt;
+    }
+
+    constexpr ui32 const virtual_texture_file_magic = 0x3154564c; // LVT1
+    constexpr ui64 const virtual_texture_file_header_size = 4 * sizeof(ui32);
+
+    ui64 virtual_texture_file_level_offset(uv2 size, ui32 level) {
+        auto result = virtual_texture_file_header_size;
+
+        for (auto i = 0u; i < level; ++i)
+            result += ui64(std::max(size.x >> i, 1u)) * std::max(size.y >> i, 1u) * 4;
+
+        return result;
+    }
+
+    bool virtual_texture_file::open(string_ref p) {
+        path = p;
+
+        file file(str(path));
+        if (!file.opened()) {
+            log()->error("virtual texture file - open {}", str(path));
+            return false;
+        }
+
+        std::array<ui32, 4> header{};
+        if (file_error(file.read((data_ptr) header.data(), sizeof(header)))
+            || (header[0] != virtual_texture_file_magic)) {
+            log()->error("virtual texture file - invalid header {}", str(path));
+            return false;
+        }
+
+        size = { header[1], header[2] };
+        level_count = header[3];
+
+        if ((size.x == 0) || (size.y == 0) || (level_count == 0) || (level_count > mip_level_count(size))) {
+            log()->error("virtual texture file - invalid size {}", str(path));
+            return false;
+        }
+
+        if (to_ui64(file.get_size()) < virtual_texture_file_level_offset(size, level_count)) {
+            log()->error("virtual texture file - truncated {}", str(path));
+            return false;
+        }
+
+        return true;
+    }
+
+    bool virtual_texture_file::read(ui32 level, uv2 offset, uv2 rect, unique_data& texels) const {
+        if (level >= level_count)
+            return false;
+
+        uv2 const extent = { std::max(size.x >> level, 1u), std::max(size.y >> level, 1u) };
+        if ((offset.x + rect.x > extent.x) || (offset.y + rect.y > extent.y))
+            return false;
+
+        // own handle per call, workers read in parallel
+        file file(str(path));
+        if (!file.opened())
+            return false;
+
+        texels.free();
+        texels.set(size_t(rect.x) * rect.y * 4);
+        if (!texels.ptr)
+            return false;
+
+        auto const level_offset = virtual_texture_file_level_offset(size, level);
+        auto const row_size = ui64(rect.x) * 4;
+
+        for (auto y = 0u; y < rect.y; ++y) {
+            auto const position = level_offset + (ui64(offset.y + y) * extent.x + offset.x) * 4;
+
+            if (file_error(file.seek(position))
+                || (file.read(texels.ptr + y * row_size, row_size) != to_i64(row_size)))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool virtual_texture_file::write(string_ref path, cdata const& texels, uv2 size, bool srgb) {
+        unique_data levels_data;
+        texture::mip_level::list levels;
+
+        if (!compute_mip_levels(texels, size, 4, levels_data, levels, mip_filter::box, srgb)) {
+            log()->error("virtual texture file - compute levels {}", str(path));
+            return false;
+        }
+
+        std::array<ui32, 4> const header{ virtual_texture_file_magic, size.x, size.y, to_ui32(levels.size()) };
+
+        file file(str(path), true);
+        if (!file.opened()
+            || file_error(file.write((data_cptr) header.data(), sizeof(header)))
+            || file_error(file.write(levels_data.ptr, levels_data.size))) {
+            log()->error("virtual texture file - write {}", str(path));
+            return false;
+        }
+
+        return true;
+    }
+
+    bool virtual_texture::create(device_ptr d, staging* s, uv2 sz, ui32 lc, tile_loader l,
+                                 ui32 ts, ui32 cache_size, ui32 thread_count, bool use_sparse) {
+        device = d;
+        uploader = s;
+        size = sz;
+        loader = l;
+        tile_size = ts;
+
+        if (!uploader || !loader) {
+            log()->error("create virtual texture - no staging or loader");
+            return false;
+        }
+
+        if ((size.x == 0) || (size.y == 0) || (lc == 0) || (tile_size == 0) || (cache_size == 0)) {
+            log()->error("create virtual texture - invalid size");
+            return false;
+        }
+
+        if ((format_block_size(format) != 4) || format_depth_stencil(format)) {
+            log()->error("create virtual texture - format {} not supported", to_i32(format));
+            return false;
+        }
+
+        level_count = std::min(lc, mip_level_count(size));
+
+        auto const& features = device->get_features();
+        if (use_sparse && features.sparseBinding && features.sparseResidencyImage2D) {
+            for (auto& queue : device->get_queues()) {
+                if (queue.flags & VK_QUEUE_SPARSE_BINDING_BIT) {
+                    sparse_queue = queue;
+                    break;
+                }
+            }
+        }
+
+        auto result = false;
+
+        if (sparse_queue.valid()) {
+            result = create_sparse(cache_size);
+            if (!result) {
+                log()->warn("create virtual texture - sparse residency not available, using indirection");
+                destroy_sparse();
+
+                tile_size = ts;
+            }
+        }
+
+        if (!result && !create_cache(cache_size))
+            return false;
+
+        pool.setup(thread_count);
+        pool_active = true;
+
+        // indirection: coarsest level stays resident, sparse: mip tail
+        if (sparse()) {
+            for (auto level = tail_first_level; level < level_count; ++level)
+                request({ level, 0, 0 }, true);
+        } else {
+            auto const top = table.get_level_count() - 1;
+            auto const page_count = table.get_page_count(top);
+
+            for (auto y = 0u; y < page_count.y; ++y)
+                for (auto x = 0u; x < page_count.x; ++x)
+                    request({ top, x, y });
+        }
+
+        return true;
+    }
+
+    bool virtual_texture::create(device_ptr d, staging* s, virtual_texture_file::ptr file,
+                                 ui32 ts, ui32 cache_size, ui32 thread_count, bool use_sparse) {
+        if (!file) {
+            log()->error("create virtual texture - no file");
+            return false;
+        }
+
+        auto loader = [file](ui32 level, uv2 offset, uv2 size, unique_data& texels) {
+            return file->read(level, offset, size, texels);
+        };
+
+        return create(d, s, file->get_size(), file->get_level_count(), loader, ts, cache_size, thread_count, use_sparse);
+    }
+
+    bool virtual_texture::create_cache(ui32 cache_size) {
+        sparse_queue = {};
+        border = 4;
+        cache_tiles = cache_size;
+
+        auto const slot_size = tile_size + 2 * border;
+        auto const cache_extent = cache_tiles * slot_size;
+
+        if ((cache_tiles > 256) || (cache_extent > device->get_properties().limits.maxImageDimension2D)) {
+            log()->error("create virtual texture - cache of {}x{} tiles too large", cache_tiles, cache_tiles);
+            return false;
+        }
+
+        // levels until one page covers the whole level
+        auto table_levels = 1u;
+        while ((table_levels < level_count) && (std::max(size.x >> (table_levels - 1), size.y >> (table_levels - 1)) > tile_size))
+            ++table_levels;
+
+        if (!table.create(size, tile_size, table_levels, cache_tiles * cache_tiles))
+            return false;
+
+        auto const top = table.get_page_count(table_levels - 1);
+        if (top.x * top.y >= table.get_slot_count()) {
+            log()->error("create virtual texture - {} coarsest pages exceed the cache", top.x * top.y);
+            return false;
+        }
+
+        cache = make_texture();
+        if (!cache->create(device, { cache_extent, cache_extent }, format)) {
+            log()->error("create virtual texture cache");
+            return false;
+        }
+
+        indirection = make_texture();
+        if (!indirection->create(device, table.get_page_count(), VK_FORMAT_R8G8B8A8_UNORM)) {
+            log()->error("create virtual texture indirection");
+            return false;
+        }
+
+        uploader->clear_image(cache->get_image());
+        uploader->clear_image(indirection->get_image());
+
+        return true;
+    }
+
+    bool virtual_texture::create_sparse(ui32 cache_size) {
+        auto const& limits = device->get_properties().limits;
+        if ((size.x > limits.maxImageDimension2D) || (size.y > limits.maxImageDimension2D))
+            return false;
+
+        VkImageCreateInfo const create_info{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .flags = VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = format,
+            .extent = { size.x, size.y, 1 },
+            .mipLevels = level_count,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+
+        VkImage vk_image = VK_NULL_HANDLE;
+        if (failed(device->call().vkCreateImage(device->get(), &create_info, memory::alloc(), &vk_image)))
+            return false;
+
+        // owns the vk image from here on
+        sparse_image = make_image(format, vk_image);
+        sparse_image->set_level_count(level_count);
+
+        if (!sparse_image->create(device, size))
+            return false;
+
+        auto requirement_count = 0u;
+        device->call().vkGetImageSparseMemoryRequirements(device->get(), vk_image, &requirement_count, nullptr);
+
+        std::vector<VkSparseImageMemoryRequirements> requirements(requirement_count);
+        device->call().vkGetImageSparseMemoryRequirements(device->get(), vk_image, &requirement_count, requirements.data());
+
+        auto const color = std::find_if(requirements.begin(), requirements.end(), [](auto const& requirement) {
+            return requirement.formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT;
+        });
+
+        if (color == requirements.end())
+            return false;
+
+        auto const granularity = color->formatProperties.imageGranularity;
+        if ((granularity.width != granularity.height) || (granularity.depth != 1))
+            return false;
+
+        tile_size = granularity.width;
+        border = 0;
+        tail_first_level = std::min(color->imageMipTailFirstLod, level_count);
+
+        // everything in the tail, nothing to stream
+        if (tail_first_level == 0)
+            return false;
+
+        if (!table.create(size, tile_size, tail_first_level, cache_size * cache_size))
+            return false;
+
+        VkMemoryRequirements memory_requirements{};
+        device->call().vkGetImageMemoryRequirements(device->get(), vk_image, &memory_requirements);
+
+        // sparse block size
+        page_bytes = memory_requirements.alignment;
+
+        VmaAllocationCreateInfo const alloc_info{
+            .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+        };
+
+        auto slot_requirements = memory_requirements;
+        slot_requirements.size = page_bytes * table.get_slot_count();
+
+        if (failed(vmaAllocateMemory(device->alloc(), &slot_requirements, &alloc_info, &slot_memory, nullptr))) {
+            log()->error("create virtual texture - allocate {} pages", table.get_slot_count());
+            return false;
+        }
+
+        if ((tail_first_level < level_count) && (color->imageMipTailSize > 0)) {
+            auto tail_requirements = memory_requirements;
+            tail_requirements.size = color->imageMipTailSize;
+
+            if (failed(vmaAllocateMemory(device->alloc(), &tail_requirements, &alloc_info, &tail_memory, nullptr))) {
+                log()->error("create virtual texture - allocate mip tail");
+                return false;
+            }
+
+            VmaAllocationInfo tail_info{};
+            vmaGetAllocationInfo(device->alloc(), tail_memory, &tail_info);
+
+            VkSparseMemoryBind const tail_bind{
+                .resourceOffset = color->imageMipTailOffset,
+                .size = color->imageMipTailSize,
+                .memory = tail_info.deviceMemory,
+                .memoryOffset = tail_info.offset,
+            };
+
+            VkSparseImageOpaqueMemoryBindInfo const opaque_bind{
+                .image = vk_image,
+                .bindCount = 1,
+                .pBinds = &tail_bind,
+            };
+
+            VkBindSparseInfo const bind_info{
+                .sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO,
+                .imageOpaqueBindCount = 1,
+                .pImageOpaqueBinds = &opaque_bind,
+            };
+
+            // once, the tail stays bound
+            if (failed(device->call().vkQueueBindSparse(sparse_queue.vk_queue, 1, &bind_info, VK_NULL_HANDLE))
+                || failed(device->call().vkQueueWaitIdle(sparse_queue.vk_queue))) {
+                log()->error("create virtual texture - bind mip tail");
+                return false;
+            }
+        }
+
+        VkSamplerCreateInfo const sampler_info{
+            .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+            .magFilter = VK_FILTER_LINEAR,
+            .minFilter = VK_FILTER_LINEAR,
+            .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+            .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+            .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+            .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+            .mipLodBias = 0.f,
+            .anisotropyEnable = device->get_features().samplerAnisotropy,
+            .maxAnisotropy = limits.maxSamplerAnisotropy,
+            .compareEnable = VK_FALSE,
+            .compareOp = VK_COMPARE_OP_NEVER,
+            .minLod = 0.f,
+            .maxLod = to_r32(level_count),
+            .borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+            .unnormalizedCoordinates = VK_FALSE,
+        };
+
+        sparse_sampler = device->get_sampler_cache().acquire(sampler_info);
+        if (!sparse_sampler)
+            return false;
+
+        sparse_descriptor.sampler = sparse_sampler;
+        sparse_descriptor.imageView = sparse_image->get_view();
+        sparse_descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        // writes to unbound pages are discarded
+        uploader->clear_image(sparse_image);
+
+        return true;
+    }
+
+    void virtual_texture::destroy_sparse() {
+        if (sparse_sampler) {
+            device->get_sampler_cache().release(sparse_sampler);
+            sparse_sampler = VK_NULL_HANDLE;
+        }
+
+        sparse_descriptor = {};
+
+        if (sparse_image) {
+            sparse_image->destroy();
+            sparse_image = nullptr;
+        }
+
+        if (slot_memory) {
+            vmaFreeMemory(device->alloc(), slot_memory);
+            slot_memory = nullptr;
+        }
+
+        if (tail_memory) {
+            vmaFreeMemory(device->alloc(), tail_memory);
+            tail_memory = nullptr;
+        }
+
+        for (auto& [frame, semaphore] : bind_semaphores)
+            device->vkDestroySemaphore(semaphore);
+
+        bind_semaphores.clear();
+
+        if (bind_timeline) {
+            bind_timeline->destroy();
+            bind_timeline = nullptr;
+        }
+
+        bind_point = {};
+
+        binds.clear();
+        sparse_queue = {};
+        tail_first_level = 0;
+        page_bytes = 0;
+    }
+
+    void virtual_texture::destroy() {
+        if (pool_active) {
+            pool.teardown();
+            pool_active = false;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(loaded_mutex);
+            loaded.clear();
+        }
+
+        if (!device)
+            return;
+
+        destroy_sparse();
+
+        feedback_buffers.clear();
+
+        cache = nullptr;
+        indirection = nullptr;
+        dirty.reset();
+
+        table.clear();
+
+        loader = nullptr;
+        uploader = nullptr;
+        device = nullptr;
+    }
+
+    buffer::ptr virtual_texture::get_feedback_buffer(index frame) {
+        auto const it = feedback_buffers.find(frame);
+        if (it != feedback_buffers.end())
+            return it->second;
+
+        std::vector<ui32> const empty(1 + feedback_capacity, 0);
+
+        auto result = make_buffer();
+        if (!result->create_mapped(device, empty.data(), empty.size() * sizeof(ui32),
+                                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU)) {
+            log()->error("create virtual texture feedback buffer");
+            return nullptr;
+        }
+
+        feedback_buffers.emplace(frame, result);
+        return result;
+    }
+
+    uv2 virtual_texture::get_level_size(ui32 level) const {
+        return { std::max(size.x >> level, 1u), std::max(size.y >> level, 1u) };
+    }
+
+    void virtual_texture::request(virtual_page const& page, bool tail) {
+        auto current = std::make_shared<tile>();
+        current->page = page;
+        current->tail = tail;
+
+        pool.enqueue([&, current](id::ref) {
+            load(*current);
+
+            std::unique_lock<std::mutex> lock(loaded_mutex);
+            loaded.push_back(current);
+        });
+    }
+
+    void virtual_texture::load(tile& target) {
+        auto const level = target.page.level;
+        auto const extent = get_level_size(level);
+
+        if (target.tail) {
+            target.size = extent;
+            target.result = loader(level, { 0, 0 }, extent, target.texels);
+            return;
+        }
+
+        uv2 const origin = { target.page.x * tile_size, target.page.y * tile_size };
+
+        if (border == 0) {
+            target.size = { std::min(tile_size, extent.x - origin.x), std::min(tile_size, extent.y - origin.y) };
+            target.result = loader(level, origin, target.size, target.texels);
+            return;
+        }
+
+        // neighbour texels for filtering, clamped to the level
+        uv2 const first = { origin.x - std::min(origin.x, border), origin.y - std::min(origin.y, border) };
+        uv2 const last = { std::min(origin.x + tile_size + border, extent.x), std::min(origin.y + tile_size + border, extent.y) };
+        uv2 const read_size = last - first;
+
+        unique_data source;
+        if (!loader(level, first, read_size, source) || (source.size < size_t(read_size.x) * read_size.y * 4))
+            return;
+
+        auto const slot_size = tile_size + 2 * border;
+        target.size = { slot_size, slot_size };
+
+        target.texels.set(size_t(slot_size) * slot_size * 4);
+        if (!target.texels.ptr)
+            return;
+
+        // extrude past the level edge
+        for (auto y = 0u; y < slot_size; ++y) {
+            auto const sy = std::clamp(to_i32(origin.y + y) - to_i32(border), to_i32(first.y), to_i32(last.y) - 1) - to_i32(first.y);
+
+            for (auto x = 0u; x < slot_size; ++x) {
+                auto const sx = std::clamp(to_i32(origin.x + x) - to_i32(border), to_i32(first.x), to_i32(last.x) - 1) - to_i32(first.x);
+                memcpy(target.texels.ptr + (size_t(y) * slot_size + x) * 4, source.ptr + (size_t(sy) * read_size.x + sx) * 4, 4);
+            }
+        }
+
+        target.result = true;
+    }
+
+    void virtual_texture::mark_dirty(virtual_page const& page) {
+        auto const page_count = table.get_page_count();
+
+        uv2 const first = { page.x << page.level, page.y << page.level };
+        uv2 const last = { std::min((page.x + 1) << page.level, page_count.x), std::min((page.y + 1) << page.level, page_count.y) };
+
+        if (!dirty)
+            dirty = { first, last };
+        else
+            dirty = { glm::min(dirty->first, first), glm::max(dirty->second, last) };
+    }
+
+    void virtual_texture::update_indirection() {
+        if (!dirty)
+            return;
+
+        auto const [first, last] = *dirty;
+        dirty.reset();
+
+        uv2 const extent = last - first;
+        std::vector<ui32> texels(size_t(extent.x) * extent.y, 0);
+
+        for (auto y = 0u; y < extent.y; ++y) {
+            for (auto x = 0u; x < extent.x; ++x) {
+                auto const page = table.find_resident(first.x + x, first.y + y);
+                if (!page)
+                    continue;
+
+                auto const slot = *table.get_slot(*page);
+                texels[size_t(y) * extent.x + x] = (slot % cache_tiles) | ((slot / cache_tiles) << 8) | (page->level << 16) | (255u << 24);
+            }
+        }
+
+        uploader->update(indirection->get_image(), { { first, extent, 0, 0 } }, texels.data(), texels.size() * sizeof(ui32));
+    }
+
+    VkSparseImageMemoryBind virtual_texture::get_sparse_bind(virtual_page const& page, std::optional<ui32> slot) const {
+        auto const extent = get_level_size(page.level);
+        uv2 const origin = { page.x * tile_size, page.y * tile_size };
+
+        VkSparseImageMemoryBind result{
+            .subresource = { VK_IMAGE_ASPECT_COLOR_BIT, page.level, 0 },
+            .offset = { to_i32(origin.x), to_i32(origin.y), 0 },
+            .extent = { std::min(tile_size, extent.x - origin.x), std::min(tile_size, extent.y - origin.y), 1 },
+        };
+
+        // no slot unbinds
+        if (slot) {
+            VmaAllocationInfo info{};
+            vmaGetAllocationInfo(device->alloc(), slot_memory, &info);
+
+            result.memory = info.deviceMemory;
+            result.memoryOffset = info.offset + *slot * page_bytes;
+        }
+
+        return result;
+    }
+
+    bool virtual_texture::bind_sparse(index frame) {
+        bind_point = {};
+
+        if (binds.empty())
+            return true;
+
+        sync_point point;
+        if (device->timeline_semaphore_supported()) {
+            if (!bind_timeline) {
+                bind_timeline = make_timeline_semaphore();
+                if (!bind_timeline->create(device)) {
+                    log()->error("create virtual texture bind timeline");
+                    bind_timeline = nullptr;
+                    return false;
+                }
+            }
+
+            point = bind_timeline->get_point(bind_timeline->next());
+        } else {
+            auto& semaphore = bind_semaphores[frame];
+            if (!semaphore) {
+                VkSemaphoreCreateInfo const create_info{
+                    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                };
+
+                if (!device->vkCreateSemaphore(&create_info, &semaphore)) {
+                    log()->error("create virtual texture bind semaphore");
+                    return false;
+                }
+            }
+
+            point.semaphore = semaphore;
+        }
+
+        VkSparseImageMemoryBindInfo const image_bind{
+            .image = sparse_image->get(),
+            .bindCount = to_ui32(binds.size()),
+            .pBinds = binds.data(),
+        };
+
+        VkTimelineSemaphoreSubmitInfo const timeline_info{
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .signalSemaphoreValueCount = 1,
+            .pSignalSemaphoreValues = &point.value,
+        };
+
+        VkBindSparseInfo const bind_info{
+            .sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO,
+            .pNext = bind_timeline ? &timeline_info : nullptr,
+            .imageBindCount = 1,
+            .pImageBinds = &image_bind,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &point.semaphore,
+        };
+
+        binds.clear();
+
+        if (failed(device->call().vkQueueBindSparse(sparse_queue.vk_queue, 1, &bind_info, VK_NULL_HANDLE))) {
+            log()->error("virtual texture - bind sparse pages");
+            return false;
+        }
+
+        bind_point = point;
+        return true;
+    }
+
+    void virtual_texture::update(index frame) {
+        if (!device)
+            return;
+
+        auto const pending = to_ui32(table.get_pending_count());
+        auto const request_count = max_requests > pending ? max_requests - pending : 0;
+
+        virtual_page::list requests;
+
+        auto const feedback = feedback_buffers.find(frame);
+        if (feedback != feedback_buffers.end()) {
+            auto& target = feedback->second;
+            target->invalidate();
+
+            auto ids = (ui32*) target->get_mapped_data();
+            auto const count = std::min(ids[0], feedback_capacity);
+
+            requests = table.process_feedback(ids + 1, count, request_count);
+
+            ids[0] = 0;
+            target->flush(0, sizeof(ui32));
+        } else {
+            requests = table.process_feedback(nullptr, 0, request_count);
+        }
+
+        for (auto& page : requests)
+            request(page);
+
+        std::vector<tile::ptr> ready;
+        {
+            std::unique_lock<std::mutex> lock(loaded_mutex);
+            ready.swap(loaded);
+        }
+
+        for (auto& current : ready) {
+            auto const& page = current->page;
+
+            if (!current->result) {
+                log()->error("virtual texture - load tile {} {} {}", page.level, page.x, page.y);
+
+                // feedback requests it again
+                table.cancel(page);
+                continue;
+            }
+
+            if (current->tail) {
+                uploader->update(sparse_image, { { { 0, 0 }, current->size, page.level, 0 } },
+                                 current->texels.ptr, current->texels.size);
+                continue;
+            }
+
+            std::optional<virtual_page> evicted;
+            auto const slot = table.make_resident(page, evicted);
+            if (!slot)
+                continue;
+
+            if (sparse()) {
+                // unused for keep frames, sampling falls back to coarser levels
+                if (evicted)
+                    binds.push_back(get_sparse_bind(*evicted, std::nullopt));
+
+                binds.push_back(get_sparse_bind(page, slot));
+
+                uv2 const origin = { page.x * tile_size, page.y * tile_size };
+                uploader->update(sparse_image, { { origin, current->size, page.level, 0 } },
+                                 current->texels.ptr, current->texels.size);
+            } else {
+                if (evicted)
+                    mark_dirty(*evicted);
+
+                if (page.level + 1 == table.get_level_count())
+                    table.pin(page);
+
+                auto const slot_size = tile_size + 2 * border;
+                uv2 const slot_offset = { (*slot % cache_tiles) * slot_size, (*slot / cache_tiles) * slot_size };
+
+                uploader->update(cache->get_image(), { { slot_offset, current->size, 0, 0 } },
+                                 current->texels.ptr, current->texels.size);
+                mark_dirty(page);
+            }
+        }
+
+        if (sparse())
+            bind_sparse(frame);
+        else
+            update_indirection();
+    }
+
+} // namespace lava
@@ -0,0 +1,278 @@
+// file      : liblava/asset/virtual_texture.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/base/timeline_semaphore.hpp>
+#include <liblava/resource/staging.hpp>
+#include <liblava/util/thread.hpp>
+#include <optional>
+#include <set>
+
+namespace lava {
+
+    struct virtual_page {
+        using list = std::vector<virtual_page>;
+
+        ui32 level = 0;
+        ui32 x = 0;
+        ui32 y = 0;
+
+        // level 4 bits, x and y 14 bits each (feedback buffer encoding)
+        ui32 pack() const {
+            return (level << 28) | ((x & 0x3fff) << 14) | (y & 0x3fff);
+        }
+
+        static virtual_page unpack(ui32 id) {
+            return { id >> 28, (id >> 14) & 0x3fff, id & 0x3fff };
+        }
+
+        bool operator==(virtual_page const& other) const {
+            return pack() == other.pack();
+        }
+    };
+
+    // cpu side residency of a virtual texture, no device needed
+    struct virtual_page_table {
+        bool create(uv2 size, ui32 tile_size, ui32 level_count, ui32 slot_count);
+        void clear();
+
+        // feedback ids of one frame, resident pages (and their parents) are marked used
+        // returns missing pages not yet pending, coarse levels first
+        virtual_page::list process_feedback(ui32 const* ids, size_t count, ui32 max_count);
+
+        // slot for a loaded page, evicts the least recently used page when all slots are taken
+        // nullopt when every slot was used within the last keep frames
+        std::optional<ui32> make_resident(virtual_page const& page, std::optional<virtual_page>& evicted);
+
+        // pending load failed or was dropped
+        void cancel(virtual_page const& page);
+
+        // resident page is never evicted
+        void pin(virtual_page const& page);
+
+        std::optional<ui32> get_slot(virtual_page const& page) const;
+
+        bool resident(virtual_page const& page) const {
+            return pages.count(page.pack()) > 0;
+        }
+        bool pending(virtual_page const& page) const {
+            return requested.count(page.pack()) > 0;
+        }
+
+        // finest resident page covering the level 0 page
+        std::optional<virtual_page> find_resident(ui32 x, ui32 y) const;
+
+        uv2 get_page_count(ui32 level = 0) const;
+
+        ui32 get_level_count() const {
+            return level_count;
+        }
+        ui32 get_slot_count() const {
+            return slot_count;
+        }
+        size_t get_resident_count() const {
+            return pages.size();
+        }
+        size_t get_pending_count() const {
+            return requested.size();
+        }
+
+        void set_keep_frames(ui32 value) {
+            keep_frames = value;
+        }
+
+    private:
+        bool valid(virtual_page const& page) const;
+
+        struct entry {
+            ui32 slot = 0;
+            ui64 last_used = 0;
+            bool pinned = false;
+        };
+
+        uv2 size = uv2(0, 0);
+        ui32 tile_size = 0;
+        ui32 level_count = 0;
+        ui32 slot_count = 0;
+        ui32 keep_frames = 3;
+
+        std::map<ui32, entry> pages;
+        std::set<ui32> requested;
+        std::vector<ui32> free_slots;
+
+        ui64 frame = 0;
+    };
+
+    // header + raw rgba8 levels (level 0 first)
+    struct virtual_texture_file {
+        using ptr = std::shared_ptr<virtual_texture_file>;
+
+        bool open(string_ref path);
+
+        // thread safe, reads rows of one level
+        bool read(ui32 level, uv2 offset, uv2 size, unique_data& texels) const;
+
+        uv2 get_size() const {
+            return size;
+        }
+        ui32 get_level_count() const {
+            return level_count;
+        }
+
+        // offline cook, builds the mip chain
+        static bool write(string_ref path, cdata const& texels, uv2 size, bool srgb = true);
+
+    private:
+        string path;
+        uv2 size = uv2(0, 0);
+        ui32 level_count = 0;
+    };
+
+    // shader contract:
+    // - feedback buffer: ui32 count followed by packed virtual_page ids (atomic append)
+    // - indirection texel of a level 0 page: slot x, slot y, level, 255 when resident (texelFetch)
+    // - cache slots are tile size + 2 * border wide, the tile starts at border
+    // - sparse: sample the virtual image with sparseTexture and fall back to coarser levels
+    struct virtual_texture {
+        ~virtual_texture() {
+            destroy();
+        }
+
+        // texels of a level rect, tightly packed rgba8 (worker threads)
+        using tile_loader = std::function<bool(ui32 level, uv2 offset, uv2 size, unique_data& texels)>;
+
+        bool create(device_ptr device, staging* staging, uv2 size, ui32 level_count, tile_loader loader,
+                    ui32 tile_size = 128, ui32 cache_size = 16, ui32 thread_count = 2, bool use_sparse = true);
+
+        bool create(device_ptr device, staging* staging, virtual_texture_file::ptr file,
+                    ui32 tile_size = 128, ui32 cache_size = 16, ui32 thread_count = 2, bool use_sparse = true);
+
+        void destroy();
+
+        // main thread, once per frame after its fence and before staging
+        void update(index frame);
+
+        bool sparse() const {
+            return sparse_image != nullptr;
+        }
+
+        // physical cache (indirection) or virtual image (sparse)
+        image::ptr get_image() const {
+            return sparse() ? sparse_image : cache->get_image();
+        }
+
+        VkDescriptorImageInfo const* get_descriptor_info() const {
+            return sparse() ? &sparse_descriptor : cache->get_descriptor_info();
+        }
+
+        texture::ptr get_indirection() const {
+            return indirection;
+        }
+
+        buffer::ptr get_feedback_buffer(index frame);
+
+        // sparse binds of the last update, the frame must wait on it at the transfer stage
+        // timeline point if supported, otherwise a binary semaphore with value 0
+        sync_point get_bind_sync() const {
+            return bind_point;
+        }
+
+        virtual_page_table const& get_page_table() const {
+            return table;
+        }
+
+        ui32 get_tile_size() const {
+            return tile_size;
+        }
+        ui32 get_border() const {
+            return border;
+        }
+
+        void set_feedback_capacity(ui32 value) {
+            feedback_capacity = value;
+        }
+
+        // rgba8 format of the tiles, before create
+        void set_format(VkFormat value) {
+            format = value;
+        }
+
+        // loads in flight
+        void set_max_requests(ui32 value) {
+            max_requests = value;
+        }
+
+    private:
+        struct tile {
+            using ptr = std::shared_ptr<tile>;
+
+            virtual_page page;
+            uv2 size = uv2(0, 0);
+            bool tail = false;
+
+            unique_data texels;
+            bool result = false;
+        };
+
+        bool create_sparse(ui32 cache_size);
+        bool create_cache(ui32 cache_size);
+        void destroy_sparse();
+
+        void request(virtual_page const& page, bool tail = false);
+        void load(tile& target);
+
+        uv2 get_level_size(ui32 level) const;
+        void mark_dirty(virtual_page const& page);
+        void update_indirection();
+
+        VkSparseImageMemoryBind get_sparse_bind(virtual_page const& page, std::optional<ui32> slot) const;
+        bool bind_sparse(index frame);
+
+        device_ptr device = nullptr;
+        staging* uploader = nullptr;
+        tile_loader loader;
+
+        uv2 size = uv2(0, 0);
+        ui32 level_count = 0;
+        ui32 tile_size = 0;
+        ui32 border = 4;
+        ui32 cache_tiles = 0; // per side
+
+        VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+
+        virtual_page_table table;
+
+        texture::ptr cache;
+        texture::ptr indirection;
+        std::optional<std::pair<uv2, uv2>> dirty; // min, max (exclusive)
+
+        std::map<index, buffer::ptr> feedback_buffers;
+        ui32 feedback_capacity = 4096;
+        ui32 max_requests = 32;
+
+        thread_pool pool;
+        bool pool_active = false;
+
+        std::mutex loaded_mutex;
+        std::vector<tile::ptr> loaded;
+
+        // sparse residency
+        image::ptr sparse_image;
+        VkSampler sparse_sampler = VK_NULL_HANDLE;
+        VkDescriptorImageInfo sparse_descriptor = {};
+        queue sparse_queue;
+        ui32 tail_first_level = 0;
+
+        VmaAllocation slot_memory = nullptr;
+        VmaAllocation tail_memory = nullptr;
+        VkDeviceSize page_bytes = 0;
+
+        std::vector<VkSparseImageMemoryBind> binds;
+        timeline_semaphore::ptr bind_timeline;
+        std::map<index, VkSemaphore> bind_semaphores;
+        sync_point bind_point;
+    };
+
+} // namespace lava
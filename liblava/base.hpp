@@ -8,7 +8,10 @@
 #include <liblava/base/debug_utils.hpp>
 #include <liblava/base/device.hpp>
 #include <liblava/base/device_table.hpp>
+#include <liblava/base/immediate_submit.hpp>
 #include <liblava/base/instance.hpp>
 #include <liblava/base/memory.hpp>
 #include <liblava/base/physical_device.hpp>
 #include <liblava/base/queue.hpp>
+#include <liblava/base/sampler_cache.hpp>
+#include <liblava/base/timeline_semaphore.hpp>
@@ -86,9 +86,41 @@ namespace lava {
             queue_create_info_list[i].pQueuePriorities = priorities.at(i).data();
         }
 
+        VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+            .pNext = const_cast<void*>(param.next), // only read by vkCreateDevice
+            .timelineSemaphore = VK_TRUE,
+        };
+
+        timeline_semaphore = param.timeline_semaphore && physical_device->timeline_semaphore_supported();
+        timeline_semaphore_khr = timeline_semaphore && !physical_device->timeline_semaphore_core();
+
+        // vulkan 1.2 features must not be chained next to the separate struct,
+        // the caller's structs are not changed
+        auto chain_timeline_features = timeline_semaphore;
+        if (timeline_semaphore) {
+            for (auto next = static_cast<VkBaseInStructure const*>(param.next); next; next = next->pNext) {
+                auto enabled = VK_TRUE;
+
+                if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES)
+                    enabled = reinterpret_cast<VkPhysicalDeviceVulkan12Features const*>(next)->timelineSemaphore;
+                else if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES)
+                    enabled = reinterpret_cast<VkPhysicalDeviceTimelineSemaphoreFeatures const*>(next)->timelineSemaphore;
+                else
+                    continue;
+
+                if (!enabled) {
+                    log()->error("create device - chained features disable timeline semaphores, enable them or clear create_param::timeline_semaphore");
+                    return false;
+                }
+
+                chain_timeline_features = false;
+            }
+        }
+
         VkDeviceCreateInfo create_info{
             .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-            .pNext = param.next,
+            .pNext = chain_timeline_features ? &timeline_features : param.next,
             .queueCreateInfoCount = to_ui32(queue_create_info_list.size()),
             .pQueueCreateInfos = queue_create_info_list.data(),
             .enabledLayerCount = 0,
@@ -107,6 +139,8 @@ namespace lava {
 
         load_table();
 
+        samplers.set_max_count(get_properties().limits.maxSamplerAllocationCount);
+
         graphics_queue_list.clear();
         compute_queue_list.clear();
         transfer_queue_list.clear();
@@ -150,6 +184,8 @@ namespace lava {
         transfer_queue_list.clear();
         queue_list.clear();
 
+        samplers.clear();
+
         if (mem_allocator) {
             mem_allocator->destroy();
             mem_allocator = nullptr;
@@ -159,6 +195,9 @@ namespace lava {
         vk_device = nullptr;
 
         table = {};
+
+        timeline_semaphore = false;
+        timeline_semaphore_khr = false;
     }
 
     bool device::surface_supported(VkSurfaceKHR surface) const {
@@ -170,6 +209,36 @@ namespace lava {
         return false;
     }
 
+    vk_result device::wait_semaphores(VkSemaphoreWaitInfo const& wait_info, ui64 timeout) const {
+        if (!timeline_semaphore)
+            return { false, VK_ERROR_FEATURE_NOT_PRESENT };
+
+        auto result = timeline_semaphore_khr ? call().vkWaitSemaphoresKHR(vk_device, &wait_info, timeout)
+                                             : call().vkWaitSemaphores(vk_device, &wait_info, timeout);
+        if ((result == VK_TIMEOUT) && (timeout != UINT64_MAX))
+            return { false, result };
+
+        return { check(result), result };
+    }
+
+    vk_result device::signal_semaphore(VkSemaphoreSignalInfo const& signal_info) const {
+        if (!timeline_semaphore)
+            return { false, VK_ERROR_FEATURE_NOT_PRESENT };
+
+        auto result = timeline_semaphore_khr ? call().vkSignalSemaphoreKHR(vk_device, &signal_info)
+                                             : call().vkSignalSemaphore(vk_device, &signal_info);
+        return { check(result), result };
+    }
+
+    vk_result device::get_semaphore_counter_value(VkSemaphore semaphore, ui64& value) const {
+        if (!timeline_semaphore)
+            return { false, VK_ERROR_FEATURE_NOT_PRESENT };
+
+        auto result = timeline_semaphore_khr ? call().vkGetSemaphoreCounterValueKHR(vk_device, semaphore, &value)
+                                             : call().vkGetSemaphoreCounterValue(vk_device, semaphore, &value);
+        return { check(result), result };
+    }
+
     VkPhysicalDevice device::get_vk_physical_device() const {
         return physical_device->get();
     }
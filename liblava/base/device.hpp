@@ -6,6 +6,7 @@
 
 #include <liblava/base/device_table.hpp>
 #include <liblava/base/queue.hpp>
+#include <liblava/base/sampler_cache.hpp>
 #include <liblava/core/data.hpp>
 
 namespace lava {
@@ -26,7 +27,10 @@ namespace lava {
 
             names extensions;
             VkPhysicalDeviceFeatures features{};
-            void const* next = nullptr; // pNext
+            void const* next = nullptr; // pNext, chained feature structs must enable timeline semaphores if requested
+
+            // enables the timeline semaphore feature, extension added by the physical device
+            bool timeline_semaphore = false;
 
             queue_family_info::list queue_family_infos;
 
@@ -128,6 +132,15 @@ namespace lava {
 
         bool surface_supported(VkSurfaceKHR surface) const;
 
+        bool timeline_semaphore_supported() const {
+            return timeline_semaphore;
+        }
+
+        // core or khr functions, timeline semaphores only
+        vk_result wait_semaphores(VkSemaphoreWaitInfo const& wait_info, ui64 timeout = UINT64_MAX) const;
+        vk_result signal_semaphore(VkSemaphoreSignalInfo const& signal_info) const;
+        vk_result get_semaphore_counter_value(VkSemaphore semaphore, ui64& value) const;
+
         void set_allocator(allocator::ptr value) {
             mem_allocator = value;
         }
@@ -139,6 +152,14 @@ namespace lava {
             return mem_allocator != nullptr ? mem_allocator->get() : nullptr;
         }
 
+        memory_stats get_memory_stats() const {
+            return mem_allocator != nullptr ? mem_allocator->get_stats() : memory_stats{};
+        }
+
+        sampler_cache& get_sampler_cache() {
+            return samplers;
+        }
+
     private:
         physical_device_cptr physical_device = nullptr;
 
@@ -149,7 +170,12 @@ namespace lava {
 
         VkPhysicalDeviceFeatures features{};
 
+        bool timeline_semaphore = false;
+        bool timeline_semaphore_khr = false;
+
         allocator::ptr mem_allocator;
+
+        sampler_cache samplers{ this };
     };
 
     struct device_manager {
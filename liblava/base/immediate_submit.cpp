@@ -0,0 +1,259 @@
+// file      : liblava/base/immediate_submit.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/base/immediate_submit.hpp>
+
+namespace lava {
+
+    bool immediate_submit::create(device_ptr d, queue::ref queue, ui32 batch_count) {
+        device = d;
+        target_queue = queue;
+
+        if (!target_queue.valid() || (batch_count == 0)) {
+            log()->error("create immediate submit - invalid queue or batch count");
+            return false;
+        }
+
+        VkCommandPoolCreateInfo const pool_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            .queueFamilyIndex = target_queue.family,
+        };
+
+        if (!device->vkCreateCommandPool(&pool_info, &pool)) {
+            log()->error("create immediate submit command pool");
+            return false;
+        }
+
+        batches.resize(batch_count);
+
+        VkFenceCreateInfo const fence_info{
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        };
+
+        for (auto& item : batches) {
+            if (!device->vkAllocateCommandBuffers(pool, 1, &item.cmd_buf)
+                || !device->vkCreateFence(&fence_info, &item.fence)) {
+                log()->error("create immediate submit batch");
+                destroy();
+                return false;
+            }
+        }
+
+        open_batch = no_index;
+        recorded = 0;
+
+        next_serial = 1;
+        completed_serial = 0;
+        submit_count = 0;
+
+        return true;
+    }
+
+    void immediate_submit::destroy() {
+        if (!device)
+            return;
+
+        submit();
+        wait_idle();
+
+        for (auto& item : batches) {
+            if (item.fence)
+                device->vkDestroyFence(item.fence);
+        }
+
+        batches.clear();
+
+        if (pool) {
+            device->vkDestroyCommandPool(pool);
+            pool = VK_NULL_HANDLE;
+        }
+
+        device = nullptr;
+    }
+
+    bool immediate_submit::wait_batch(batch& target, ui64 timeout) {
+        if (!target.submitted)
+            return true;
+
+        if (!device->vkWaitForFences(1, &target.fence, VK_TRUE, timeout))
+            return false;
+
+        target.submitted = false;
+        completed_serial = std::max(completed_serial, target.serial);
+
+        return true;
+    }
+
+    bool immediate_submit::open() {
+        if (open_batch != no_index)
+            return true;
+
+        // oldest batch, its fence is reused
+        auto next = 0u;
+        for (auto i = 1u; i < batches.size(); ++i)
+            if (batches[i].serial < batches[next].serial)
+                next = i;
+
+        auto& target = batches.at(next);
+        if (!wait_batch(target, UINT64_MAX))
+            return false;
+
+        if (!device->vkResetFences(1, &target.fence))
+            return false;
+
+        if (failed(device->call().vkResetCommandBuffer(target.cmd_buf, 0)))
+            return false;
+
+        VkCommandBufferBeginInfo const begin_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        if (failed(device->call().vkBeginCommandBuffer(target.cmd_buf, &begin_info)))
+            return false;
+
+        target.serial = next_serial++;
+
+        open_batch = next;
+        recorded = 0;
+
+        return true;
+    }
+
+    bool immediate_submit::record(one_time_command_func callback) {
+        if (!device || !callback)
+            return false;
+
+        std::unique_lock<std::mutex> lock(submit_mutex);
+
+        if (!open()) {
+            log()->error("immediate submit - open batch");
+            return false;
+        }
+
+        auto cmd_buf = batches.at(open_batch).cmd_buf;
+
+        // same order as separate submits
+        if (recorded > 0) {
+            VkMemoryBarrier const barrier{
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+            };
+
+            device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                                0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }
+
+        callback(cmd_buf);
+        ++recorded;
+
+        if ((batch_size > 0) && (recorded >= batch_size))
+            return submit_open().has_value();
+
+        return true;
+    }
+
+    immediate_submit::optional_token immediate_submit::submit() {
+        if (!device)
+            return std::nullopt;
+
+        std::unique_lock<std::mutex> lock(submit_mutex);
+        return submit_open();
+    }
+
+    immediate_submit::optional_token immediate_submit::submit_open() {
+        if (open_batch == no_index)
+            return token{};
+
+        auto& target = batches.at(open_batch);
+        open_batch = no_index;
+
+        if (failed(device->call().vkEndCommandBuffer(target.cmd_buf)))
+            return std::nullopt;
+
+        sync_point point;
+        if (timeline)
+            point = timeline->get_point(timeline->next());
+
+        timeline_submit batch_submit;
+        if (point.valid())
+            batch_submit.add_signal(point);
+
+        VkCommandBuffers const cmd_buffers = { target.cmd_buf };
+        auto const submit_info = batch_submit.get_submit_info(cmd_buffers);
+
+        if (!device->vkQueueSubmit(target_queue.vk_queue, 1, &submit_info, target.fence)) {
+            log()->error("immediate submit - queue submit");
+
+            // the value is taken, waits on it and later values must not hang
+            if (point.valid() && (timeline->get_value() < point.value))
+                timeline->signal(point.value);
+
+            return std::nullopt;
+        }
+
+        target.submitted = true;
+        ++submit_count;
+
+        return token{ target.serial, point };
+    }
+
+    bool immediate_submit::ready(token t) {
+        if (!device || !t.valid())
+            return true;
+
+        std::unique_lock<std::mutex> lock(submit_mutex);
+
+        if (t.value <= completed_serial)
+            return true;
+
+        for (auto& item : batches) {
+            if ((item.serial != t.value) || !item.submitted)
+                continue;
+
+            if (device->call().vkGetFenceStatus(device->get(), item.fence) != VK_SUCCESS)
+                return false;
+
+            item.submitted = false;
+            completed_serial = std::max(completed_serial, item.serial);
+            return true;
+        }
+
+        // still open
+        return false;
+    }
+
+    bool immediate_submit::wait(token t, ui64 timeout) {
+        if (!device || !t.valid())
+            return true;
+
+        std::unique_lock<std::mutex> lock(submit_mutex);
+
+        if (t.value <= completed_serial)
+            return true;
+
+        // recorded but not submitted yet
+        if ((open_batch != no_index) && (batches.at(open_batch).serial == t.value) && !submit_open())
+            return false;
+
+        for (auto& item : batches)
+            if (item.serial == t.value)
+                return wait_batch(item, timeout);
+
+        return true;
+    }
+
+    bool immediate_submit::wait_idle() {
+        std::unique_lock<std::mutex> lock(submit_mutex);
+
+        auto result = true;
+        for (auto& item : batches)
+            if (!wait_batch(item, UINT64_MAX))
+                result = false;
+
+        return result;
+    }
+
+} // namespace lava
@@ -0,0 +1,117 @@
+// file      : liblava/base/immediate_submit.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/base/timeline_semaphore.hpp>
+#include <mutex>
+#include <optional>
+
+namespace lava {
+
+    // one time commands batched into few submits with reused fences
+    struct immediate_submit : id_obj {
+        using ptr = std::shared_ptr<immediate_submit>;
+
+        // waitable submit of a batch
+        struct token {
+            ui64 value = 0;
+
+            // signaled with the batch if a timeline is set
+            sync_point point;
+
+            bool valid() const {
+                return value != 0;
+            }
+        };
+
+        using optional_token = std::optional<token>;
+
+        ~immediate_submit() {
+            destroy();
+        }
+
+        // batch_count command buffers in flight before recording waits
+        bool create(device_ptr device, queue::ref queue, ui32 batch_count = 4);
+        void destroy();
+
+        // recorded into the open batch after a barrier on all previous commands,
+        // submitted by submit() or when batch_size callbacks are recorded
+        bool record(one_time_command_func callback);
+
+        // open batch without waiting, invalid token when nothing was recorded,
+        // empty when the submit failed
+        optional_token submit();
+
+        bool ready(token t);
+        bool wait(token t, ui64 timeout = UINT64_MAX);
+
+        // submit and wait, like one_time_command_buffer
+        bool flush() {
+            auto const t = submit();
+            if (!t)
+                return false;
+
+            return !t->valid() || wait(*t);
+        }
+
+        bool execute(one_time_command_func callback) {
+            return record(callback) && flush();
+        }
+
+        // all submitted batches
+        bool wait_idle();
+
+        // 0 = until submit()
+        void set_batch_size(ui32 value) {
+            batch_size = value;
+        }
+
+        // each submit signals the next value, queues can wait on token::point
+        void set_timeline(timeline_semaphore::ptr value) {
+            timeline = value;
+        }
+
+        ui32 get_submit_count() const {
+            return submit_count;
+        }
+
+    private:
+        struct batch {
+            VkCommandBuffer cmd_buf = VK_NULL_HANDLE;
+            VkFence fence = VK_NULL_HANDLE;
+
+            ui64 serial = 0;
+            bool submitted = false;
+        };
+
+        bool open();
+        optional_token submit_open();
+        bool wait_batch(batch& target, ui64 timeout);
+
+        device_ptr device = nullptr;
+        queue target_queue;
+
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<batch> batches;
+
+        std::mutex submit_mutex;
+
+        index open_batch = no_index;
+        ui32 recorded = 0;
+
+        ui64 next_serial = 1;
+        ui64 completed_serial = 0;
+
+        ui32 batch_size = 0;
+        ui32 submit_count = 0;
+
+        timeline_semaphore::ptr timeline;
+    };
+
+    inline immediate_submit::ptr make_immediate_submit() {
+        return std::make_shared<immediate_submit>();
+    }
+
+} // namespace lava
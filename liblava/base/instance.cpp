@@ -30,6 +30,17 @@ namespace lava {
                 param.extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
         }
 
+        // memory budget on vulkan 1.0
+        if ((info.req_api_version == api_version::v1_0) && !exists(param.extensions, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) {
+            auto const properties = enumerate_extension_properties();
+            auto const available = std::any_of(properties.begin(), properties.end(), [](auto const& property) {
+                return string(property.extensionName) == VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME;
+            });
+
+            if (available)
+                param.extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        }
+
         if (!check(param)) {
             log()->error("create instance param");
 
@@ -5,6 +5,7 @@
 #include <liblava/base/device.hpp>
 #include <liblava/base/instance.hpp>
 #include <liblava/base/memory.hpp>
+#include <atomic>
 
 #ifdef _WIN32
 #    pragma warning(push, 4)
@@ -33,19 +34,190 @@
 
 namespace lava {
 
+    // in front of each callback allocation, the driver only hands back the pointer on free
+    struct cpu_allocation_header {
+        size_t size = 0;
+        void* arena = nullptr; // nullptr on heap
+        ui32 offset = 0;       // of the pointer in its block
+        ui32 scope = 0;
+    };
+
+    constexpr size_t cpu_header_size = 32;
+    static_assert(sizeof(cpu_allocation_header) <= cpu_header_size);
+
+    constexpr size_t cpu_min_alignment = 16;
+
+    struct cpu_scope_counter {
+        std::atomic<size_t> count = 0;
+        std::atomic<size_t> bytes = 0;
+        std::atomic<size_t> peak_bytes = 0;
+
+        std::atomic<size_t> total_count = 0;
+        std::atomic<size_t> arena_count = 0;
+    };
+
+    static std::array<cpu_scope_counter, cpu_allocation_scope_count> cpu_counters;
+
+    static size_t to_scope_index(VkSystemAllocationScope scope) {
+        return std::min(to_size_t(scope), cpu_allocation_scope_count - 1);
+    }
+
+    static void count_cpu_allocation(size_t scope, size_t size, bool arena) {
+        auto& counter = cpu_counters[scope];
+
+        counter.count.fetch_add(1, std::memory_order_relaxed);
+        counter.total_count.fetch_add(1, std::memory_order_relaxed);
+        if (arena)
+            counter.arena_count.fetch_add(1, std::memory_order_relaxed);
+
+        auto const bytes = counter.bytes.fetch_add(size, std::memory_order_relaxed) + size;
+
+        auto peak = counter.peak_bytes.load(std::memory_order_relaxed);
+        while ((bytes > peak) && !counter.peak_bytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {}
+    }
+
+    static void count_cpu_free(size_t scope, size_t size) {
+        auto& counter = cpu_counters[scope];
+
+        counter.count.fetch_sub(1, std::memory_order_relaxed);
+        counter.bytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    // command scope allocations only live for the duration of a vulkan command on the calling thread
+    struct cpu_arena {
+        ~cpu_arena() {
+            free_data(block);
+        }
+
+        static constexpr size_t capacity = 64 * 1024;
+
+        data_ptr allocate(size_t size, size_t alignment) {
+            if (!block) {
+                block = as_ptr(alloc_data(capacity, cpu_min_alignment));
+                if (!block)
+                    return nullptr;
+            }
+
+            // block itself is only aligned to cpu_min_alignment
+            auto const base = reinterpret_cast<uintptr_t>(block);
+            auto const offset = size_t(align_up(base + head, uintptr_t(alignment)) - base);
+            if (offset + size > capacity)
+                return nullptr;
+
+            head = offset + size;
+            ++live;
+
+            return block + offset;
+        }
+
+        void free() {
+            if (live > 0)
+                --live;
+
+            if (live == 0)
+                head = 0;
+        }
+
+    private:
+        data_ptr block = nullptr;
+        size_t head = 0;
+        size_t live = 0;
+    };
+
+    static thread_local cpu_arena command_arena;
+
+    static cpu_allocation_header* get_cpu_header(void* memory) {
+        return reinterpret_cast<cpu_allocation_header*>(as_ptr(memory) - cpu_header_size);
+    }
+
     static void* VKAPI_PTR custom_cpu_allocation(void* user_data, size_t size, size_t alignment, VkSystemAllocationScope allocation_scope) {
         assert(user_data == LAVA_CUSTOM_CPU_ALLOCATION_CALLBACK_USER_DATA);
-        return alloc_data(size, alignment);
+
+        if (size == 0)
+            return nullptr;
+
+        alignment = std::max(alignment, size_t(1));
+
+        auto const block_alignment = std::max(alignment, cpu_min_alignment);
+        auto const offset = align_up(cpu_header_size, alignment);
+        auto const block_size = align_up(offset + size, block_alignment);
+
+        auto const scope = to_scope_index(allocation_scope);
+
+        void* arena = nullptr;
+        data_ptr block = nullptr;
+
+        if (allocation_scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+            block = command_arena.allocate(block_size, block_alignment);
+            if (block)
+                arena = &command_arena;
+        }
+
+        if (!block)
+            block = as_ptr(alloc_data(block_size, block_alignment));
+
+        if (!block)
+            return nullptr;
+
+        auto result = block + offset;
+        new (get_cpu_header(result)) cpu_allocation_header{
+            .size = size,
+            .arena = arena,
+            .offset = to_ui32(offset),
+            .scope = to_ui32(scope),
+        };
+
+        count_cpu_allocation(scope, size, arena != nullptr);
+
+        return result;
+    }
+
+    static void VKAPI_PTR custom_cpu_free(void* user_data, void* memory) {
+        assert(user_data == LAVA_CUSTOM_CPU_ALLOCATION_CALLBACK_USER_DATA);
+
+        if (!memory)
+            return;
+
+        auto const header = *get_cpu_header(memory);
+
+        count_cpu_free(header.scope, header.size);
+
+        if (header.arena)
+            static_cast<cpu_arena*>(header.arena)->free();
+        else
+            free_data(as_ptr(memory) - header.offset);
     }
 
     static void* VKAPI_PTR custom_cpu_reallocation(void* user_data, void* original, size_t size, size_t alignment, VkSystemAllocationScope allocation_scope) {
         assert(user_data == LAVA_CUSTOM_CPU_ALLOCATION_CALLBACK_USER_DATA);
-        return realloc_data(original, size, alignment);
+
+        if (!original)
+            return custom_cpu_allocation(user_data, size, alignment, allocation_scope);
+
+        if (size == 0) {
+            custom_cpu_free(user_data, original);
+            return nullptr;
+        }
+
+        // original stays valid on failure
+        auto result = custom_cpu_allocation(user_data, size, alignment, allocation_scope);
+        if (!result)
+            return nullptr;
+
+        memcpy(result, original, std::min(size, get_cpu_header(original)->size));
+        custom_cpu_free(user_data, original);
+
+        return result;
+    }
+
+    static void VKAPI_PTR custom_cpu_internal_allocation(void* user_data, size_t size, VkInternalAllocationType allocation_type, VkSystemAllocationScope allocation_scope) {
+        assert(user_data == LAVA_CUSTOM_CPU_ALLOCATION_CALLBACK_USER_DATA);
+        count_cpu_allocation(to_scope_index(allocation_scope), size, false);
     }
 
-    static void VKAPI_PTR custom_cpu_free(void* user_Data, void* memory) {
-        assert(user_Data == LAVA_CUSTOM_CPU_ALLOCATION_CALLBACK_USER_DATA);
-        free_data(memory);
+    static void VKAPI_PTR custom_cpu_internal_free(void* user_data, size_t size, VkInternalAllocationType allocation_type, VkSystemAllocationScope allocation_scope) {
+        assert(user_data == LAVA_CUSTOM_CPU_ALLOCATION_CALLBACK_USER_DATA);
+        count_cpu_free(to_scope_index(allocation_scope), size);
     }
 
     memory::memory() {
@@ -56,6 +228,51 @@ namespace lava {
         vk_callbacks.pfnAllocation = reinterpret_cast<PFN_vkAllocationFunction>(&custom_cpu_allocation);
         vk_callbacks.pfnReallocation = reinterpret_cast<PFN_vkReallocationFunction>(&custom_cpu_reallocation);
         vk_callbacks.pfnFree = reinterpret_cast<PFN_vkFreeFunction>(&custom_cpu_free);
+        vk_callbacks.pfnInternalAllocation = reinterpret_cast<PFN_vkInternalAllocationNotification>(&custom_cpu_internal_allocation);
+        vk_callbacks.pfnInternalFree = reinterpret_cast<PFN_vkInternalFreeNotification>(&custom_cpu_internal_free);
+    }
+
+    cpu_memory_stats memory::get_cpu_stats() {
+        cpu_memory_stats result;
+
+        for (auto i = 0u; i < cpu_allocation_scope_count; ++i) {
+            auto const& counter = cpu_counters[i];
+
+            result[i] = {
+                .count = counter.count.load(std::memory_order_relaxed),
+                .bytes = counter.bytes.load(std::memory_order_relaxed),
+                .peak_bytes = counter.peak_bytes.load(std::memory_order_relaxed),
+                .total_count = counter.total_count.load(std::memory_order_relaxed),
+                .arena_count = counter.arena_count.load(std::memory_order_relaxed),
+            };
+        }
+
+        return result;
+    }
+
+    void memory::reset_cpu_stats() {
+        for (auto& counter : cpu_counters) {
+            counter.peak_bytes.store(counter.bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            counter.total_count.store(counter.count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            counter.arena_count.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    name allocation_scope_name(VkSystemAllocationScope scope) {
+        switch (scope) {
+        case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND:
+            return "command";
+        case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT:
+            return "object";
+        case VK_SYSTEM_ALLOCATION_SCOPE_CACHE:
+            return "cache";
+        case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE:
+            return "device";
+        case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE:
+            return "instance";
+        default:
+            return "unknown";
+        }
     }
 
     type memory::find_type_with_properties(VkPhysicalDeviceMemoryProperties properties, ui32 type_bits, VkMemoryPropertyFlags required_properties) {
@@ -84,6 +301,17 @@ namespace lava {
         return no_type;
     }
 
+    // core since vulkan 1.1
+    PFN_vkGetPhysicalDeviceMemoryProperties2KHR get_memory_properties_2_func() {
+        if (vkGetPhysicalDeviceMemoryProperties2KHR)
+            return vkGetPhysicalDeviceMemoryProperties2KHR;
+
+        if (instance::singleton().get_info().req_api_version != api_version::v1_0)
+            return vkGetPhysicalDeviceMemoryProperties2;
+
+        return nullptr;
+    }
+
     bool allocator::create(device_cptr device, VmaAllocatorCreateFlags flags) {
         VmaVulkanFunctions const vulkan_function {
             .vkGetPhysicalDeviceProperties = vkGetPhysicalDeviceProperties,
@@ -112,10 +340,19 @@ namespace lava {
             .vkBindImageMemory2KHR = device->call().vkBindImageMemory2KHR,
 #endif
 #if VMA_MEMORY_BUDGET
-            .vkGetPhysicalDeviceMemoryProperties2KHR = vkGetPhysicalDeviceMemoryProperties2KHR
+            .vkGetPhysicalDeviceMemoryProperties2KHR = get_memory_properties_2_func(),
 #endif
         };
 
+#if VMA_MEMORY_BUDGET
+        if (!vulkan_function.vkGetPhysicalDeviceMemoryProperties2KHR)
+            flags &= ~VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+#else
+        flags &= ~VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+#endif
+
+        budget = flags & VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+
         VmaAllocatorCreateInfo const allocator_info{
             .flags = flags,
             .physicalDevice = device->get_vk_physical_device(),
@@ -136,4 +373,86 @@ namespace lava {
         vma_allocator = nullptr;
     }
 
+    name memory_tag_name(memory_tag tag) {
+        switch (tag) {
+        case memory_tag::mesh:
+            return "mesh";
+        case memory_tag::texture:
+            return "texture";
+        case memory_tag::staging:
+            return "staging";
+        case memory_tag::ui:
+            return "ui";
+        case memory_tag::transient:
+            return "transient";
+        default:
+            return "none";
+        }
+    }
+
+    void allocator::track(memory_tag tag, VkDeviceSize size) {
+        std::unique_lock<std::mutex> lock(stats_mutex);
+
+        auto& target = tags.at(to_size_t(tag));
+        ++target.count;
+        target.bytes += size;
+        target.peak_bytes = std::max(target.peak_bytes, target.bytes);
+    }
+
+    void allocator::untrack(memory_tag tag, VkDeviceSize size) {
+        std::unique_lock<std::mutex> lock(stats_mutex);
+
+        auto& target = tags.at(to_size_t(tag));
+        target.count -= std::min(target.count, 1u);
+        target.bytes -= std::min(target.bytes, size);
+    }
+
+    memory_stats allocator::get_stats() {
+        memory_stats result;
+        if (!vma_allocator)
+            return result;
+
+        result.budget_supported = budget;
+
+        VkPhysicalDeviceMemoryProperties const* properties = nullptr;
+        vmaGetMemoryProperties(vma_allocator, &properties);
+
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> heap_budgets{};
+        vmaGetBudget(vma_allocator, heap_budgets.data());
+
+        VmaStats stats{};
+        vmaCalculateStats(vma_allocator, &stats);
+
+        std::unique_lock<std::mutex> lock(stats_mutex);
+
+        for (auto i = 0u; i < properties->memoryHeapCount; ++i) {
+            auto const& heap_budget = heap_budgets.at(i);
+            auto const& heap_info = stats.memoryHeap[i];
+
+            auto& peak = heap_peaks.at(i);
+            peak = std::max(peak, heap_budget.usage);
+
+            memory_heap_stats heap;
+            heap.device_local = properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+            heap.size = properties->memoryHeaps[i].size;
+            heap.budget = heap_budget.budget;
+            heap.usage = heap_budget.usage;
+            heap.peak_usage = peak;
+            heap.block_bytes = heap_budget.blockBytes;
+            heap.allocation_bytes = heap_budget.allocationBytes;
+            heap.block_count = heap_info.blockCount;
+            heap.allocation_count = heap_info.allocationCount;
+
+            result.heaps.push_back(heap);
+        }
+
+        result.tags = tags;
+
+        result.allocation_count = stats.total.allocationCount;
+        result.used_bytes = stats.total.usedBytes;
+        result.unused_bytes = stats.total.unusedBytes;
+
+        return result;
+    }
+
 } // namespace lava
@@ -7,6 +7,8 @@
 // clang-format off
 
 #include <liblava/base/base.hpp>
+#include <array>
+#include <mutex>
 #include <vk_mem_alloc.h>
 
 // clang-format on
@@ -17,6 +19,53 @@ namespace lava {
     struct device;
     using device_cptr = device const*;
 
+    // what an allocation is used for
+    enum class memory_tag : type {
+        none = 0,
+        mesh,
+        texture,
+        staging,
+        ui,
+        transient,
+        count
+    };
+
+    name memory_tag_name(memory_tag tag);
+
+    struct memory_heap_stats {
+        using list = std::vector<memory_heap_stats>;
+
+        bool device_local = false;
+
+        VkDeviceSize size = 0;
+        VkDeviceSize budget = 0; // heap size estimate without VK_EXT_memory_budget
+        VkDeviceSize usage = 0;
+        VkDeviceSize peak_usage = 0;
+
+        VkDeviceSize block_bytes = 0;
+        VkDeviceSize allocation_bytes = 0;
+
+        ui32 block_count = 0;
+        ui32 allocation_count = 0;
+    };
+
+    struct memory_tag_stats {
+        ui32 count = 0;
+        VkDeviceSize bytes = 0;
+        VkDeviceSize peak_bytes = 0;
+    };
+
+    struct memory_stats {
+        bool budget_supported = false;
+
+        memory_heap_stats::list heaps;
+        std::array<memory_tag_stats, size_t(memory_tag::count)> tags{};
+
+        ui32 allocation_count = 0;
+        VkDeviceSize used_bytes = 0;
+        VkDeviceSize unused_bytes = 0;
+    };
+
     struct allocator {
         using ptr = std::shared_ptr<allocator>;
 
@@ -35,10 +84,29 @@ namespace lava {
             return vma_allocator;
         }
 
+        bool budget_supported() const {
+            return budget;
+        }
+
+        // thread safe accounting by tag
+        void track(memory_tag tag, VkDeviceSize size);
+        void untrack(memory_tag tag, VkDeviceSize size);
+
+        // heap peaks are sampled on each call
+        memory_stats get_stats();
+
     private:
         VmaAllocator vma_allocator = nullptr;
+        bool budget = false;
+
+        std::mutex stats_mutex;
+        std::array<memory_tag_stats, size_t(memory_tag::count)> tags{};
+        std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heap_peaks{};
     };
 
+    // nullptr without vulkan 1.1 or VK_KHR_get_physical_device_properties2
+    PFN_vkGetPhysicalDeviceMemoryProperties2KHR get_memory_properties_2_func();
+
     inline allocator::ptr make_allocator() {
         return std::make_shared<allocator>();
     }
@@ -51,6 +119,22 @@ namespace lava {
         return result;
     }
 
+    constexpr size_t cpu_allocation_scope_count = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+    name allocation_scope_name(VkSystemAllocationScope scope);
+
+    // host allocations made by the driver
+    struct cpu_scope_stats {
+        size_t count = 0; // live
+        size_t bytes = 0; // live
+        size_t peak_bytes = 0;
+
+        size_t total_count = 0;
+        size_t arena_count = 0; // served by the thread arena
+    };
+
+    using cpu_memory_stats = std::array<cpu_scope_stats, cpu_allocation_scope_count>;
+
     struct memory : no_copy_no_move {
         static memory& get() {
             static memory memory;
@@ -76,6 +160,12 @@ namespace lava {
             use_custom_cpu_callbacks = value;
         }
 
+        // by VkSystemAllocationScope, only with custom cpu callbacks
+        static cpu_memory_stats get_cpu_stats();
+
+        // totals and peaks, live counts are kept
+        static void reset_cpu_stats();
+
     private:
         memory();
 
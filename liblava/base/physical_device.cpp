@@ -2,10 +2,22 @@
 // copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
 // license   : MIT; see accompanying LICENSE file
 
+#include <liblava/base/instance.hpp>
 #include <liblava/base/physical_device.hpp>
 
 namespace lava {
 
+    // core since vulkan 1.1
+    PFN_vkGetPhysicalDeviceFeatures2KHR get_features_2_func() {
+        if (vkGetPhysicalDeviceFeatures2KHR)
+            return vkGetPhysicalDeviceFeatures2KHR;
+
+        if (instance::singleton().get_info().req_api_version != api_version::v1_0)
+            return vkGetPhysicalDeviceFeatures2;
+
+        return nullptr;
+    }
+
     void physical_device::initialize(VkPhysicalDevice pd) {
         vk_physical_device = pd;
 
@@ -26,6 +38,28 @@ namespace lava {
             extension_properties.resize(extension_count);
             vkEnumerateDeviceExtensionProperties(vk_physical_device, nullptr, &extension_count, extension_properties.data());
         }
+
+        timeline_semaphore = false;
+
+        auto features_2_func = get_features_2_func();
+        if (features_2_func && (timeline_semaphore_core() || supported(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))) {
+            VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features{
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+            };
+
+            VkPhysicalDeviceFeatures2 features_2{
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &timeline_features,
+            };
+
+            features_2_func(vk_physical_device, &features_2);
+            timeline_semaphore = timeline_features.timelineSemaphore == VK_TRUE;
+        }
+    }
+
+    bool physical_device::timeline_semaphore_core() const {
+        return (instance::singleton().get_info().req_api_version >= api_version::v1_2)
+               && (properties.apiVersion >= VK_API_VERSION_1_2);
     }
 
     bool physical_device::supported(string_ref extension) const {
@@ -54,6 +88,19 @@ namespace lava {
         create_param.add_swapchain_extension();
         create_param.set_default_queues();
 
+        // vma heap budgets
+        if (supported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) && get_memory_properties_2_func()) {
+            create_param.extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            create_param.vma_flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+        }
+
+        if (timeline_semaphore_supported()) {
+            if (!timeline_semaphore_core())
+                create_param.extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+
+            create_param.timeline_semaphore = true;
+        }
+
         return create_param;
     }
 
@@ -47,6 +47,12 @@ namespace lava {
         bool swapchain_supported() const;
         bool surface_supported(index queue_family, VkSurfaceKHR surface) const;
 
+        // vulkan 1.2 or VK_KHR_timeline_semaphore
+        bool timeline_semaphore_supported() const {
+            return timeline_semaphore;
+        }
+        bool timeline_semaphore_core() const;
+
     private:
         VkPhysicalDevice vk_physical_device = nullptr;
 
@@ -56,8 +62,12 @@ namespace lava {
 
         VkQueueFamilyPropertiesList queue_family_properties;
         VkExtensionPropertiesList extension_properties;
+
+        bool timeline_semaphore = false;
     };
 
     using physical_device_ptr = physical_device;
 
+    PFN_vkGetPhysicalDeviceFeatures2KHR get_features_2_func();
+
 } // namespace lava
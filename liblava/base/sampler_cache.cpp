@@ -0,0 +1,113 @@
+// file      : liblava/base/sampler_cache.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/base/sampler_cache.hpp>
+
+namespace lava {
+
+    ui32 sampler_key_value(r32 value) {
+        ui32 result = 0;
+        memcpy(&result, &value, sizeof(result));
+        return result;
+    }
+
+    std::optional<sampler_cache::key> sampler_cache::get_key(VkSamplerCreateInfo const& info) {
+        // chained structs are not part of the key
+        if (info.pNext)
+            return std::nullopt;
+
+        return key{
+            info.flags,
+            to_ui32(info.magFilter),
+            to_ui32(info.minFilter),
+            to_ui32(info.mipmapMode),
+            to_ui32(info.addressModeU),
+            to_ui32(info.addressModeV),
+            to_ui32(info.addressModeW),
+            sampler_key_value(info.mipLodBias),
+            info.anisotropyEnable,
+            sampler_key_value(info.maxAnisotropy),
+            info.compareEnable,
+            to_ui32(info.compareOp),
+            sampler_key_value(info.minLod),
+            sampler_key_value(info.maxLod),
+            to_ui32(info.borderColor),
+            info.unnormalizedCoordinates,
+        };
+    }
+
+    VkSampler sampler_cache::acquire(VkSamplerCreateInfo const& info) {
+        auto const sampler_key = get_key(info);
+
+        std::unique_lock<std::mutex> lock(sampler_mutex);
+
+        if (sampler_key) {
+            auto const it = samplers.find(*sampler_key);
+            if (it != samplers.end()) {
+                ++entries.at(it->second).ref_count;
+                return it->second;
+            }
+        }
+
+        VkSampler result = VK_NULL_HANDLE;
+        if (!device->vkCreateSampler(&info, &result)) {
+            log()->error("create sampler");
+            return VK_NULL_HANDLE;
+        }
+
+        if (sampler_key) {
+            samplers.emplace(*sampler_key, result);
+            entries.emplace(result, entry{ *sampler_key, 1 });
+        } else {
+            entries.emplace(result, entry{ {}, 1, false });
+        }
+
+        if ((max_count > 0) && (entries.size() == max_count))
+            log()->warn("sampler cache - reached max sampler allocation count {}", max_count);
+
+        return result;
+    }
+
+    void sampler_cache::release(VkSampler sampler) {
+        if (!sampler)
+            return;
+
+        std::unique_lock<std::mutex> lock(sampler_mutex);
+
+        auto const it = entries.find(sampler);
+        if (it == entries.end()) {
+            log()->error("release sampler - not in cache");
+            return;
+        }
+
+        if (--it->second.ref_count > 0)
+            return;
+
+        if (it->second.shared)
+            samplers.erase(it->second.sampler_key);
+
+        entries.erase(it);
+
+        device->vkDestroySampler(sampler);
+    }
+
+    void sampler_cache::clear() {
+        std::unique_lock<std::mutex> lock(sampler_mutex);
+
+        if (!entries.empty())
+            log()->warn("sampler cache - destroy {} samplers still in use", entries.size());
+
+        for (auto& [sampler, entry] : entries)
+            device->vkDestroySampler(sampler);
+
+        entries.clear();
+        samplers.clear();
+    }
+
+    size_t sampler_cache::size() const {
+        std::unique_lock<std::mutex> lock(sampler_mutex);
+        return entries.size();
+    }
+
+} // namespace lava
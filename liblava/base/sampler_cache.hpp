@@ -0,0 +1,54 @@
+// file      : liblava/base/sampler_cache.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <array>
+#include <liblava/base/device_table.hpp>
+#include <mutex>
+#include <optional>
+
+namespace lava {
+
+    struct sampler_cache : no_copy_no_move {
+        explicit sampler_cache(device_table* device)
+        : device(device) {}
+
+        // identical create infos share one refcounted sampler,
+        // infos with a pNext chain (e.g. ycbcr conversion or reduction mode) get their own
+        VkSampler acquire(VkSamplerCreateInfo const& info);
+        void release(VkSampler sampler);
+
+        using key = std::array<ui32, 16>;
+
+        // empty when the info can not be shared
+        static std::optional<key> get_key(VkSamplerCreateInfo const& info);
+
+        // destroys all samplers, still referenced ones are reported
+        void clear();
+
+        size_t size() const;
+
+        void set_max_count(ui32 value) {
+            max_count = value;
+        }
+
+    private:
+        struct entry {
+            key sampler_key{};
+            ui32 ref_count = 0;
+            bool shared = true;
+        };
+
+        device_table* device = nullptr;
+
+        mutable std::mutex sampler_mutex;
+
+        std::map<key, VkSampler> samplers;
+        std::map<VkSampler, entry> entries;
+
+        ui32 max_count = 0;
+    };
+
+} // namespace lava
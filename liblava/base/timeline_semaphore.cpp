@@ -0,0 +1,150 @@
+// file      : liblava/base/timeline_semaphore.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/base/timeline_semaphore.hpp>
+
+namespace lava {
+
+    bool timeline_semaphore::create(device_ptr d, ui64 initial_value) {
+        device = d;
+
+        if (!device->timeline_semaphore_supported()) {
+            log()->error("create timeline semaphore - not supported");
+            return false;
+        }
+
+        VkSemaphoreTypeCreateInfo const type_info{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+            .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+            .initialValue = initial_value,
+        };
+
+        VkSemaphoreCreateInfo const create_info{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = &type_info,
+        };
+
+        if (!device->vkCreateSemaphore(&create_info, &vk_semaphore)) {
+            log()->error("create timeline semaphore");
+            return false;
+        }
+
+        last_value = initial_value;
+
+        return true;
+    }
+
+    void timeline_semaphore::destroy() {
+        if (!vk_semaphore)
+            return;
+
+        device->vkDestroySemaphore(vk_semaphore);
+        vk_semaphore = VK_NULL_HANDLE;
+
+        device = nullptr;
+    }
+
+    ui64 timeline_semaphore::get_value() const {
+        ui64 result = 0;
+        if (!device || !device->get_semaphore_counter_value(vk_semaphore, result))
+            return 0;
+
+        return result;
+    }
+
+    bool timeline_semaphore::signal(ui64 value) {
+        VkSemaphoreSignalInfo const signal_info{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO,
+            .semaphore = vk_semaphore,
+            .value = value,
+        };
+
+        if (!device->signal_semaphore(signal_info))
+            return false;
+
+        // keep next() ahead of host signals
+        auto last = last_value.load();
+        while ((last < value) && !last_value.compare_exchange_weak(last, value)) {}
+
+        return true;
+    }
+
+    bool timeline_semaphore::wait(ui64 value, ui64 timeout) const {
+        return wait_sync_points(device, { get_point(value) }, timeout);
+    }
+
+    vk_result wait_sync_points(device_ptr device, sync_point::list const& points, ui64 timeout, bool all) {
+        if (points.empty())
+            return { true, VK_SUCCESS };
+
+        VkSemaphores semaphores;
+        std::vector<ui64> values;
+
+        for (auto& point : points) {
+            semaphores.push_back(point.semaphore);
+            values.push_back(point.value);
+        }
+
+        VkSemaphoreWaitInfo const wait_info{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .flags = all ? VkSemaphoreWaitFlags(0) : VK_SEMAPHORE_WAIT_ANY_BIT,
+            .semaphoreCount = to_ui32(semaphores.size()),
+            .pSemaphores = semaphores.data(),
+            .pValues = values.data(),
+        };
+
+        return device->wait_semaphores(wait_info, timeout);
+    }
+
+    void timeline_submit::add_wait(VkSemaphore semaphore, VkPipelineStageFlags stage, ui64 value) {
+        wait_semaphores.push_back(semaphore);
+        wait_values.push_back(value);
+        wait_stages.push_back(stage);
+
+        if (value > 0)
+            timeline = true;
+    }
+
+    void timeline_submit::add_signal(VkSemaphore semaphore, ui64 value) {
+        signal_semaphores.push_back(semaphore);
+        signal_values.push_back(value);
+
+        if (value > 0)
+            timeline = true;
+    }
+
+    VkSubmitInfo timeline_submit::get_submit_info(VkCommandBuffers const& cmd_buffers) {
+        timeline_info = {
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .waitSemaphoreValueCount = to_ui32(wait_values.size()),
+            .pWaitSemaphoreValues = wait_values.data(),
+            .signalSemaphoreValueCount = to_ui32(signal_values.size()),
+            .pSignalSemaphoreValues = signal_values.data(),
+        };
+
+        return {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = timeline ? &timeline_info : nullptr,
+            .waitSemaphoreCount = to_ui32(wait_semaphores.size()),
+            .pWaitSemaphores = wait_semaphores.data(),
+            .pWaitDstStageMask = wait_stages.data(),
+            .commandBufferCount = to_ui32(cmd_buffers.size()),
+            .pCommandBuffers = cmd_buffers.data(),
+            .signalSemaphoreCount = to_ui32(signal_semaphores.size()),
+            .pSignalSemaphores = signal_semaphores.data(),
+        };
+    }
+
+    void timeline_submit::clear() {
+        wait_semaphores.clear();
+        wait_values.clear();
+        wait_stages.clear();
+
+        signal_semaphores.clear();
+        signal_values.clear();
+
+        timeline = false;
+    }
+
+} // namespace lava
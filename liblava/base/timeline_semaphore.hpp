@@ -0,0 +1,111 @@
+// file      : liblava/base/timeline_semaphore.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/base/device.hpp>
+#include <atomic>
+
+namespace lava {
+
+    // value on a timeline semaphore
+    struct sync_point {
+        using list = std::vector<sync_point>;
+
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+        ui64 value = 0;
+
+        bool valid() const {
+            return semaphore != VK_NULL_HANDLE;
+        }
+    };
+
+    // host and queue sync with increasing values, requires device::timeline_semaphore_supported()
+    struct timeline_semaphore : id_obj {
+        using ptr = std::shared_ptr<timeline_semaphore>;
+
+        ~timeline_semaphore() {
+            destroy();
+        }
+
+        bool create(device_ptr device, ui64 initial_value = 0);
+        void destroy();
+
+        VkSemaphore get() const {
+            return vk_semaphore;
+        }
+
+        // value for the next signal operation
+        ui64 next() {
+            return ++last_value;
+        }
+        ui64 get_last_value() const {
+            return last_value;
+        }
+
+        sync_point get_point(ui64 value) const {
+            return { vk_semaphore, value };
+        }
+        sync_point get_last_point() const {
+            return get_point(last_value);
+        }
+
+        // current value on the device
+        ui64 get_value() const;
+
+        bool reached(ui64 value) const {
+            return get_value() >= value;
+        }
+
+        bool signal(ui64 value);
+        bool wait(ui64 value, ui64 timeout = UINT64_MAX) const;
+
+    private:
+        device_ptr device = nullptr;
+        VkSemaphore vk_semaphore = VK_NULL_HANDLE;
+
+        std::atomic<ui64> last_value = 0;
+    };
+
+    inline timeline_semaphore::ptr make_timeline_semaphore() {
+        return std::make_shared<timeline_semaphore>();
+    }
+
+    vk_result wait_sync_points(device_ptr device, sync_point::list const& points, ui64 timeout = UINT64_MAX, bool all = true);
+
+    // waits and signals of one submit, binary semaphores have no value
+    struct timeline_submit {
+        void add_wait(sync_point point, VkPipelineStageFlags stage) {
+            add_wait(point.semaphore, stage, point.value);
+        }
+        void add_wait(VkSemaphore semaphore, VkPipelineStageFlags stage, ui64 value = 0);
+
+        void add_signal(sync_point point) {
+            add_signal(point.semaphore, point.value);
+        }
+        void add_signal(VkSemaphore semaphore, ui64 value = 0);
+
+        // points into this, valid until the next change
+        VkSubmitInfo get_submit_info(VkCommandBuffers const& cmd_buffers);
+
+        void clear();
+
+        bool empty() const {
+            return wait_semaphores.empty() && signal_semaphores.empty();
+        }
+
+    private:
+        VkSemaphores wait_semaphores;
+        std::vector<ui64> wait_values;
+        std::vector<VkPipelineStageFlags> wait_stages;
+
+        VkSemaphores signal_semaphores;
+        std::vector<ui64> signal_values;
+
+        bool timeline = false;
+
+        VkTimelineSemaphoreSubmitInfo timeline_info{};
+    };
+
+} // namespace lava
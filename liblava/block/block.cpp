@@ -9,6 +9,9 @@ namespace lava {
     bool command::create(device_ptr device, index frame_count, VkCommandPools cmd_pools) {
         buffers.resize(frame_count);
 
+        dirty.assign(frame_count, true);
+        versions.assign(frame_count, 0);
+
         for (auto i = 0u; i < frame_count; ++i) {
             VkCommandBufferAllocateInfo const allocate_info{
                 .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
@@ -27,42 +30,79 @@ namespace lava {
     void command::destroy(device_ptr device, VkCommandPools cmd_pools) {
         for (auto i = 0u; i < buffers.size(); ++i)
             device->call().vkFreeCommandBuffers(device->get(), cmd_pools.at(i), 1, &buffers.at(i));
+
+        buffers.clear();
     }
 
-    bool block::create(lava::device_ptr d, index frame_count, index queue_family) {
+    bool block::create(lava::device_ptr d, index frame_count, index queue_family, ui32 thread_count) {
         device = d;
 
         current_frame = 0;
 
-        cmd_pools.resize(frame_count);
+        cmd_pools.resize(std::max(thread_count, 1u));
+        static_pools.resize(cmd_pools.size());
+
+        auto create_pools = [&](VkCommandPools& thread_pools, VkCommandPoolCreateFlags flags) {
+            thread_pools.resize(frame_count);
+
+            for (auto i = 0u; i < frame_count; ++i) {
+                VkCommandPoolCreateInfo const create_info{
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                    .flags = flags,
+                    .queueFamilyIndex = queue_family,
+                };
+                if (failed(device->call().vkCreateCommandPool(device->get(), &create_info, memory::alloc(), &thread_pools.at(i)))) {
+                    log()->error("create block command pool");
+                    return false;
+                }
+            }
 
-        for (auto i = 0u; i < frame_count; ++i) {
-            VkCommandPoolCreateInfo const create_info{
-                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-                .flags = 0,
-                .queueFamilyIndex = queue_family,
-            };
-            if (failed(device->call().vkCreateCommandPool(device->get(), &create_info, memory::alloc(), &cmd_pools.at(i)))) {
-                log()->error("create block command pool");
+            return true;
+        };
+
+        for (auto& thread_pools : cmd_pools)
+            if (!create_pools(thread_pools, 0))
                 return false;
-            }
-        }
 
-        for (auto& command : commands)
-            if (!command.second.create(device, frame_count, cmd_pools))
+        // static commands are reset one by one
+        for (auto& thread_pools : static_pools)
+            if (!create_pools(thread_pools, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT))
                 return false;
 
+        // spread commands over threads in order
+        next_thread = 0;
+        for (auto& command : cmd_order) {
+            command->thread = next_thread;
+            next_thread = (next_thread + 1) % get_thread_count();
+
+            if (!command->create(device, frame_count, get_pools(*command)))
+                return false;
+        }
+
+        // main thread records too
+        if (get_thread_count() > 1)
+            workers.setup(get_thread_count() - 1);
+
         return true;
     }
 
     void block::destroy() {
-        for (auto& command : commands)
-            command.second.destroy(device, cmd_pools);
+        workers.teardown();
+
+        if (!cmd_pools.empty())
+            for (auto& command : commands)
+                command.second.destroy(device, get_pools(command.second));
+
+        for (auto& thread_pools : cmd_pools)
+            for (auto i = 0u; i < thread_pools.size(); ++i)
+                device->call().vkDestroyCommandPool(device->get(), thread_pools.at(i), memory::alloc());
 
-        for (auto i = 0u; i < cmd_pools.size(); ++i)
-            device->call().vkDestroyCommandPool(device->get(), cmd_pools.at(i), memory::alloc());
+        for (auto& thread_pools : static_pools)
+            for (auto i = 0u; i < thread_pools.size(); ++i)
+                device->call().vkDestroyCommandPool(device->get(), thread_pools.at(i), memory::alloc());
 
         cmd_pools.clear();
+        static_pools.clear();
         cmd_order.clear();
         commands.clear();
     }
@@ -72,10 +112,29 @@ namespace lava {
         cmd.on_func = func;
         cmd.active = active;
 
-        if (device && !cmd_pools.empty())
-            if (!cmd.create(device, get_frame_count(), cmd_pools))
+        return insert_cmd(std::move(cmd));
+    }
+
+    id block::add_static_cmd(command::func func, command::version_func version, bool active) {
+        command cmd;
+        cmd.on_func = func;
+        cmd.active = active;
+        cmd.static_command = true;
+        cmd.on_version = version;
+
+        return insert_cmd(std::move(cmd));
+    }
+
+    id block::insert_cmd(command&& cmd) {
+        if (device && !cmd_pools.empty()) {
+            cmd.thread = next_thread;
+
+            if (!cmd.create(device, get_frame_count(), get_pools(cmd)))
                 return undef_id;
 
+            next_thread = (next_thread + 1) % get_thread_count();
+        }
+
         auto result = cmd.get_id();
 
         commands.emplace(result, std::move(cmd));
@@ -84,47 +143,116 @@ namespace lava {
         return result;
     }
 
+    bool block::set_static(id::ref cmd, bool value, command::version_func version) {
+        if (!commands.count(cmd))
+            return false;
+
+        auto& command = commands.at(cmd);
+        command.on_version = version;
+
+        if (command.static_command == value) {
+            command.mark_dirty();
+            return true;
+        }
+
+        // buffers move to the other pools
+        if (cmd_pools.empty()) {
+            command.static_command = value;
+            return true;
+        }
+
+        command.destroy(device, get_pools(command));
+        command.static_command = value;
+
+        return command.create(device, get_frame_count(), get_pools(command));
+    }
+
+    void block::mark_dirty() {
+        for (auto& command : commands)
+            command.second.mark_dirty();
+    }
+
+    bool block::mark_dirty(id::ref cmd) {
+        if (!commands.count(cmd))
+            return false;
+
+        commands.at(cmd).mark_dirty();
+        return true;
+    }
+
     void block::remove_cmd(id::ref cmd) {
         if (!commands.count(cmd))
             return;
 
         auto& command = commands.at(cmd);
-        command.destroy(device, cmd_pools);
+        if (!cmd_pools.empty())
+            command.destroy(device, get_pools(command));
 
         remove(cmd_order, &command);
 
         commands.erase(cmd);
     }
 
-    bool block::process(index frame) {
-        current_frame = frame;
+    bool block::record(command& cmd, index frame) {
+        auto& cmd_buf = cmd.buffers.at(frame);
+
+        ui64 version = 0;
+        if (cmd.static_command) {
+            if (cmd.on_version)
+                version = cmd.on_version();
+
+            // still valid from the last use of this frame
+            if (!cmd.dirty.at(frame) && (cmd.versions.at(frame) == version))
+                return true;
+        }
 
-        if (failed(device->call().vkResetCommandPool(device->get(), cmd_pools.at(frame), 0))) {
-            log()->error("block reset command pool");
+        VkCommandBufferBeginInfo const begin_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = cmd.static_command ? VkCommandBufferUsageFlags(0) : VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        if (failed(device->call().vkBeginCommandBuffer(cmd_buf, &begin_info)))
             return false;
+
+        if (cmd.on_func)
+            cmd.on_func(cmd_buf);
+
+        if (failed(device->call().vkEndCommandBuffer(cmd_buf)))
+            return false;
+
+        if (cmd.static_command) {
+            cmd.dirty.at(frame) = false;
+            cmd.versions.at(frame) = version;
         }
 
+        return true;
+    }
+
+    bool block::record_thread(index thread, index frame) {
         for (auto& command : cmd_order) {
-            if (!command->active)
+            if (!command->active || (command->thread != thread))
                 continue;
 
-            auto& cmd_buf = command->buffers.at(frame);
-
-            VkCommandBufferBeginInfo const begin_info{
-                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-            };
-            if (failed(device->call().vkBeginCommandBuffer(cmd_buf, &begin_info)))
+            if (!record(*command, frame))
                 return false;
+        }
 
-            if (command->on_func)
-                command->on_func(cmd_buf);
+        return true;
+    }
 
-            if (failed(device->call().vkEndCommandBuffer(cmd_buf)))
+    bool block::process(index frame) {
+        current_frame = frame;
+
+        for (auto& thread_pools : cmd_pools) {
+            if (failed(device->call().vkResetCommandPool(device->get(), thread_pools.at(frame), 0))) {
+                log()->error("block reset command pool");
                 return false;
+            }
         }
 
-        return true;
+        // each thread records into its own pools, get_buffers() keeps the command order
+        return workers.parallel_for(get_thread_count(), [&](index thread) {
+            return record_thread(thread, frame);
+        });
     }
 
     bool block::activated(id::ref command) {
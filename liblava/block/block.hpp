@@ -5,6 +5,7 @@
 #pragma once
 
 #include <liblava/base/device.hpp>
+#include <liblava/util/thread.hpp>
 
 namespace lava {
 
@@ -19,6 +20,23 @@ namespace lava {
 
         bool active = true;
 
+        // recording thread, command pools of the block
+        index thread = 0;
+
+        // recorded once per frame and submitted again until dirty or the version changes
+        bool static_command = false;
+
+        using version_func = std::function<ui64()>;
+        version_func on_version;
+
+        // per frame
+        std::vector<bool> dirty = {};
+        std::vector<ui64> versions = {};
+
+        void mark_dirty() {
+            std::fill(dirty.begin(), dirty.end(), true);
+        }
+
         bool create(device_ptr device, index frame_count, VkCommandPools command_pools);
         void destroy(device_ptr device, VkCommandPools command_pools);
     };
@@ -32,11 +50,15 @@ namespace lava {
             destroy();
         }
 
-        bool create(device_ptr device, index frame_count, index queue_family);
+        // thread_count > 1 records commands in parallel, command functions must be thread safe
+        bool create(device_ptr device, index frame_count, index queue_family, ui32 thread_count = 1);
         void destroy();
 
         index get_frame_count() const {
-            return to_index(cmd_pools.size());
+            return cmd_pools.empty() ? 0 : to_index(cmd_pools.front().size());
+        }
+        ui32 get_thread_count() const {
+            return to_ui32(cmd_pools.size());
         }
 
         id add_cmd(command::func func, bool active = true);
@@ -44,6 +66,14 @@ namespace lava {
             return add_cmd(func, active);
         }
 
+        // e.g. render_pass::get_version() as version, static scenes or fixed ui
+        id add_static_cmd(command::func func, command::version_func version = {}, bool active = true);
+        bool set_static(id::ref cmd, bool value = true, command::version_func version = {});
+
+        // static commands are recorded again, e.g. after a resize
+        void mark_dirty();
+        bool mark_dirty(id::ref cmd);
+
         void remove_cmd(id::ref cmd);
         void remove_command(id::ref cmd) {
             remove_cmd(cmd);
@@ -86,13 +116,28 @@ namespace lava {
         }
 
     private:
+        id insert_cmd(command&& cmd);
+
+        VkCommandPools const& get_pools(command const& cmd) const {
+            return cmd.static_command ? static_pools.at(cmd.thread) : cmd_pools.at(cmd.thread);
+        }
+
+        bool record(command& cmd, index frame);
+        bool record_thread(index thread, index frame);
+
         device_ptr device = nullptr;
 
         index current_frame = 0;
-        VkCommandPools cmd_pools = {};
+
+        // per thread, per frame
+        std::vector<VkCommandPools> cmd_pools = {};
+        std::vector<VkCommandPools> static_pools = {};
+        index next_thread = 0;
 
         command::map commands;
         command::list cmd_order;
+
+        thread_pool workers;
     };
 
     inline block::ptr make_block() {
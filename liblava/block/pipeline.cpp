@@ -49,6 +49,7 @@ namespace lava {
     }
 
     bool pipeline::create() {
+        ++version;
         return create_internal();
     }
 
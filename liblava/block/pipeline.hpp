@@ -119,6 +119,12 @@ namespace lava {
         VkPipeline get() const {
             return vk_pipeline;
         }
+
+        // changes with each create(), e.g. for cached recordings
+        ui64 get_version() const {
+            return version;
+        }
+
         device_ptr get_device() {
             return device;
         }
@@ -173,6 +179,8 @@ namespace lava {
     private:
         bool active = true;
         bool auto_bind_active = true;
+
+        ui64 version = 0;
     };
 
     pipeline::shader_stage::ptr make_pipeline_shader_stage(VkShaderStageFlagBits stage);
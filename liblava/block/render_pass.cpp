@@ -65,7 +65,7 @@ namespace lava {
         device = nullptr;
     }
 
-    void render_pass::begin(VkCommandBuffer cmd_buf, index frame) {
+    void render_pass::begin(VkCommandBuffer cmd_buf, index frame, VkSubpassContents contents) {
         auto origin = area.get_origin();
         auto size = area.get_size();
 
@@ -78,7 +78,7 @@ namespace lava {
             .pClearValues = clear_values.data(),
         };
 
-        device->call().vkCmdBeginRenderPass(cmd_buf, &info, VK_SUBPASS_CONTENTS_INLINE);
+        device->call().vkCmdBeginRenderPass(cmd_buf, &info, contents);
     }
 
     void render_pass::end(VkCommandBuffer cmd_buf) {
@@ -86,25 +86,45 @@ namespace lava {
     }
 
     void render_pass::process(VkCommandBuffer cmd_buf, index frame) {
-        begin(cmd_buf, frame);
+        // begin and next subpass take the contents of the subpass they start
+        begin(cmd_buf, frame, subpasses.empty() ? VK_SUBPASS_CONTENTS_INLINE : subpasses.front()->get_contents());
 
-        ui32 count = 0;
+        for (auto subpass_index = 0u; subpass_index < subpasses.size(); ++subpass_index) {
+            auto& subpass = subpasses[subpass_index];
 
-        for (auto& subpass : subpasses) {
-            if (count > 0)
-                device->call().vkCmdNextSubpass(cmd_buf, VK_SUBPASS_CONTENTS_INLINE);
+            if (subpass_index > 0)
+                device->call().vkCmdNextSubpass(cmd_buf, subpass->get_contents());
 
             if (!subpass->activated())
                 continue;
 
-            subpass->process(cmd_buf, area.get_size());
-
-            ++count;
+            if (subpass->secondary()) {
+                secondary_target const target{
+                    .device = device,
+                    .render_pass = vk_render_pass,
+                    .subpass_index = to_ui32(subpass_index),
+                    .framebuffer = framebuffers[frame],
+                    .frame = frame,
+                };
+
+                if (!subpass->process_secondary(cmd_buf, area.get_size(), target))
+                    log()->error("render pass - process secondary subpass");
+            } else {
+                subpass->process(cmd_buf, area.get_size());
+            }
         }
 
         end(cmd_buf);
     }
 
+    ui64 render_pass::get_version() const {
+        auto result = target_version;
+        for (auto& subpass : subpasses)
+            result = result * 31 + (subpass->activated() ? subpass->get_version() : 0);
+
+        return result;
+    }
+
     void render_pass::set_clear_color(v3 value) {
         clear_values.resize(2);
 
@@ -126,6 +146,7 @@ namespace lava {
 
     bool render_pass::on_target_created(VkAttachmentsRef target_attachments, rect a) {
         area = a;
+        ++target_version;
         framebuffers.resize(target_attachments.size());
 
         auto size = area.get_size();
@@ -62,6 +62,15 @@ namespace lava {
         void set_clear_color(v3 value = v3(0.086f, 0.086f, 0.094f));
         v3 get_clear_color() const;
 
+        // changes with subpasses, pipelines and target, e.g. for static block commands
+        ui64 get_version() const;
+
+        // recordings of all subpasses are stale, e.g. resources moved
+        void invalidate() {
+            for (auto& subpass : subpasses)
+                subpass->invalidate();
+        }
+
         void add(graphics_pipeline::ptr pipeline, index subpass = 0) {
             subpasses.at(subpass)->add(pipeline);
         }
@@ -85,7 +94,9 @@ namespace lava {
         VkClearValues clear_values = {};
         rect area;
 
-        void begin(VkCommandBuffer cmd_buf, index frame);
+        ui64 target_version = 0;
+
+        void begin(VkCommandBuffer cmd_buf, index frame, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void end(VkCommandBuffer cmd_buf);
 
         bool on_target_created(VkAttachmentsRef target_attachments, rect area);
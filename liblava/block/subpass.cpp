@@ -20,6 +20,8 @@ namespace lava {
     }
 
     void subpass::destroy() {
+        set_inline();
+
         clear_pipelines();
     }
 
@@ -28,10 +30,12 @@ namespace lava {
             pipeline->destroy();
 
         pipelines.clear();
+        invalidate();
     }
 
     void subpass::remove(graphics_pipeline::ptr pipeline) {
         lava::remove(pipelines, std::move(pipeline));
+        invalidate();
     }
 
     void subpass::set_color_attachment(index attachment, VkImageLayout layout) {
@@ -126,8 +130,10 @@ namespace lava {
         description.pPreserveAttachments = preserve_attachments.data();
     }
 
-    void subpass::process(VkCommandBuffer cmd_buf, uv2 size) {
-        for (auto& pipeline : pipelines) {
+    void subpass::record_pipelines(VkCommandBuffer cmd_buf, uv2 size, index first, index last) {
+        for (auto i = first; i < last; ++i) {
+            auto& pipeline = pipelines.at(i);
+
             if (!pipeline->activated())
                 continue;
 
@@ -147,6 +153,193 @@ namespace lava {
         }
     }
 
+    void subpass::process(VkCommandBuffer cmd_buf, uv2 size) {
+        record_pipelines(cmd_buf, size, 0, to_index(pipelines.size()));
+    }
+
+    ui64 subpass::get_version() const {
+        return version * 31 + pipeline_key(0, to_index(pipelines.size()));
+    }
+
+    ui64 subpass::pipeline_key(index first, index last) const {
+        ui64 result = 0;
+        for (auto i = first; i < last; ++i) {
+            auto const& pipeline = pipelines.at(i);
+
+            result = result * 31 + (pipeline->activated() ? i + 1 : 0);
+            result = result * 31 + pipeline->get_version();
+            result = result * 31 + std::hash<VkPipeline>{}(pipeline->get());
+
+            auto const layout = pipeline->get_layout();
+            result = result * 31 + std::hash<VkPipelineLayout>{}(layout ? layout->get() : VK_NULL_HANDLE);
+        }
+
+        return result;
+    }
+
+    void subpass::set_secondary(index family, ui32 bucket_count) {
+        set_inline();
+
+        queue_family = family;
+        buckets.resize(std::max(bucket_count, 1u));
+
+        // first bucket on the recording thread
+        if (buckets.size() > 1)
+            workers.setup(to_ui32(buckets.size() - 1));
+
+        invalidate();
+    }
+
+    void subpass::set_inline() {
+        workers.teardown();
+
+        release_buckets();
+        buckets.clear();
+    }
+
+    void subpass::release_buckets() {
+        for (auto& current : buckets) {
+            if (current.pool)
+                bucket_device->call().vkDestroyCommandPool(bucket_device->get(), current.pool, memory::alloc());
+
+            current = {};
+        }
+
+        bucket_device = nullptr;
+    }
+
+    index subpass::bucket_first(index bucket) const {
+        auto const count = to_index(buckets.size());
+        auto const chunk = (to_index(pipelines.size()) + count - 1) / count;
+
+        return std::min(bucket * chunk, to_index(pipelines.size()));
+    }
+
+    index subpass::bucket_last(index bucket) const {
+        return bucket_first(bucket + 1);
+    }
+
+    bool subpass::prepare_buckets(secondary_target const& target) {
+        if (bucket_device && (bucket_device != target.device))
+            release_buckets();
+
+        bucket_device = target.device;
+
+        for (auto& current : buckets) {
+            if (!current.pool) {
+                VkCommandPoolCreateInfo const create_info{
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                    .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                    .queueFamilyIndex = queue_family,
+                };
+                if (failed(bucket_device->call().vkCreateCommandPool(bucket_device->get(), &create_info, memory::alloc(), &current.pool))) {
+                    log()->error("create subpass command pool");
+                    return false;
+                }
+            }
+
+            // frames in flight are known when they show up
+            while (current.buffers.size() <= target.frame) {
+                VkCommandBufferAllocateInfo const allocate_info{
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    .commandPool = current.pool,
+                    .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                    .commandBufferCount = 1,
+                };
+
+                VkCommandBuffer cmd_buf = VK_NULL_HANDLE;
+                if (failed(bucket_device->call().vkAllocateCommandBuffers(bucket_device->get(), &allocate_info, &cmd_buf))) {
+                    log()->error("create subpass secondary command buffer");
+                    return false;
+                }
+
+                current.buffers.push_back(cmd_buf);
+                current.versions.push_back(0);
+                current.pipeline_keys.push_back(0);
+                current.framebuffers.push_back(VK_NULL_HANDLE);
+            }
+        }
+
+        return true;
+    }
+
+    bool subpass::record_bucket(index b, uv2 size, secondary_target const& target) {
+        auto const first = bucket_first(b);
+        auto const last = bucket_last(b);
+        if (first == last)
+            return true;
+
+        auto& current = buckets.at(b);
+        auto const frame = target.frame;
+
+        // pipelines toggled or rebuilt since the last recording
+        auto const key = pipeline_key(first, last);
+
+        if (cache && (current.versions.at(frame) == version)
+            && (current.pipeline_keys.at(frame) == key)
+            && (current.framebuffers.at(frame) == target.framebuffer))
+            return true;
+
+        auto cmd_buf = current.buffers.at(frame);
+
+        VkCommandBufferInheritanceInfo const inheritance_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+            .renderPass = target.render_pass,
+            .subpass = target.subpass_index,
+            .framebuffer = target.framebuffer,
+        };
+
+        // never one time submit, a static block command executes them again without recording
+        VkCommandBufferBeginInfo const begin_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+            .pInheritanceInfo = &inheritance_info,
+        };
+        if (failed(bucket_device->call().vkBeginCommandBuffer(cmd_buf, &begin_info)))
+            return false;
+
+        record_pipelines(cmd_buf, size, first, last);
+
+        if (failed(bucket_device->call().vkEndCommandBuffer(cmd_buf)))
+            return false;
+
+        current.versions.at(frame) = version;
+        current.pipeline_keys.at(frame) = key;
+        current.framebuffers.at(frame) = target.framebuffer;
+
+        return true;
+    }
+
+    bool subpass::process_secondary(VkCommandBuffer cmd_buf, uv2 size, secondary_target const& target) {
+        if (!secondary() || !target.device)
+            return false;
+
+        if (!prepare_buckets(target))
+            return false;
+
+        if (size != recorded_size) {
+            recorded_size = size;
+            invalidate();
+        }
+
+        // each bucket records into its own pool
+        auto const recorded = workers.parallel_for(to_ui32(buckets.size()), [&](index b) {
+            return record_bucket(b, size, target);
+        });
+        if (!recorded)
+            return false;
+
+        VkCommandBuffers cmd_buffers;
+        for (auto b = 0u; b < buckets.size(); ++b)
+            if (bucket_first(b) != bucket_last(b))
+                cmd_buffers.push_back(buckets.at(b).buffers.at(target.frame));
+
+        if (!cmd_buffers.empty())
+            target.device->call().vkCmdExecuteCommands(cmd_buf, to_ui32(cmd_buffers.size()), cmd_buffers.data());
+
+        return true;
+    }
+
     subpass::ptr make_subpass(VkPipelineBindPoint pipeline_bind_point) {
         auto result = std::make_shared<subpass>();
 
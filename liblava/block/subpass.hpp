@@ -5,9 +5,19 @@
 #pragma once
 
 #include <liblava/block/pipeline.hpp>
+#include <liblava/util/thread.hpp>
 
 namespace lava {
 
+    // render pass state inherited by secondary command buffers
+    struct secondary_target {
+        device_ptr device = nullptr;
+        VkRenderPass render_pass = VK_NULL_HANDLE;
+        ui32 subpass_index = 0;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        index frame = 0;
+    };
+
     struct subpass : id_obj {
         using ptr = std::shared_ptr<subpass>;
         using list = std::vector<ptr>;
@@ -18,10 +28,12 @@ namespace lava {
 
         void add(graphics_pipeline::ptr const& pipeline) {
             pipelines.push_back(pipeline);
+            invalidate();
         }
 
         void add_front(graphics_pipeline::ptr const& pipeline) {
             pipelines.insert(pipelines.begin(), pipeline);
+            invalidate();
         }
 
         void remove(graphics_pipeline::ptr pipeline);
@@ -30,6 +42,36 @@ namespace lava {
 
         void process(VkCommandBuffer cmd_buf, uv2 size);
 
+        // pipelines split in bucket_count buckets, each recorded into a secondary command buffer in parallel
+        void set_secondary(index queue_family, ui32 bucket_count = 1);
+        void set_inline();
+
+        bool secondary() const {
+            return !buckets.empty();
+        }
+        VkSubpassContents get_contents() const {
+            return secondary() ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+        }
+
+        // records and executes the buckets, inside the render pass
+        bool process_secondary(VkCommandBuffer cmd_buf, uv2 size, secondary_target const& target);
+
+        // keep recorded buckets while pipelines, their active state, size and framebuffer are unchanged
+        void set_cache(bool value = true) {
+            cache = value;
+        }
+        bool cached() const {
+            return cache;
+        }
+
+        // on_process records something else, recorded buckets are stale
+        void invalidate() {
+            ++version;
+        }
+
+        // changes with pipelines, their active state, handles, layouts and invalidate()
+        ui64 get_version() const;
+
         VkSubpassDescription const& get_description() const {
             return description;
         }
@@ -74,6 +116,41 @@ namespace lava {
         index_list preserve_attachments;
 
         graphics_pipeline::list pipelines;
+
+        struct bucket {
+            using list = std::vector<bucket>;
+
+            VkCommandPool pool = VK_NULL_HANDLE;
+
+            // per frame
+            VkCommandBuffers buffers;
+            std::vector<ui64> versions;
+            std::vector<ui64> pipeline_keys;
+            VkFramebuffers framebuffers;
+        };
+
+        void record_pipelines(VkCommandBuffer cmd_buf, uv2 size, index first, index last);
+
+        // active state and rebuilds of a range of pipelines
+        ui64 pipeline_key(index first, index last) const;
+
+        bool prepare_buckets(secondary_target const& target);
+        bool record_bucket(index bucket, uv2 size, secondary_target const& target);
+        void release_buckets();
+
+        // range of pipelines in a bucket
+        index bucket_first(index bucket) const;
+        index bucket_last(index bucket) const;
+
+        bucket::list buckets;
+        index queue_family = 0;
+        device_ptr bucket_device = nullptr;
+
+        bool cache = false;
+        ui64 version = 1;
+        uv2 recorded_size = uv2(0, 0);
+
+        thread_pool workers;
     };
 
     subpass::ptr make_subpass(VkPipelineBindPoint pipeline_bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS);
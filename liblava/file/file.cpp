@@ -38,7 +38,7 @@ namespace lava {
                 if (o_stream.is_open())
                     type = file_type::f_stream;
             } else {
-                i_stream = std::ifstream(path, std::ios::binary | std::ios::ate);
+                i_stream = std::ifstream(path, std::ios::binary);
                 if (i_stream.is_open())
                     type = file_type::f_stream;
             }
@@ -100,9 +100,8 @@ namespace lava {
         if (type == file_type::fs) {
             return PHYSFS_readBytes(fs_file, data, size);
         } else if (type == file_type::f_stream) {
-            i_stream.seekg(0, std::ios::beg);
             i_stream.read(data, size);
-            return to_i64(size);
+            return to_i64(i_stream.gcount());
         }
 
         return file_error_result;
@@ -124,12 +123,15 @@ namespace lava {
 
     i64 file::seek(ui64 position) {
         if (type == file_type::fs) {
-            return PHYSFS_seek(fs_file, position);
+            if (!PHYSFS_seek(fs_file, position))
+                return file_error_result;
+
+            return tell();
         } else if (type == file_type::f_stream) {
             if (write_mode)
-                o_stream.seekp(position, std::ostream::cur);
+                o_stream.seekp(position, std::ostream::beg);
             else
-                i_stream.seekg(position, std::ostream::cur);
+                i_stream.seekg(position, std::istream::beg);
 
             return tell();
         }
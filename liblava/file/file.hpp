@@ -36,6 +36,7 @@ namespace lava {
         bool opened() const;
         i64 get_size() const;
 
+        // reads from the current position, returns the bytes read
         i64 read(data_ptr data) {
             return read(data, to_ui64(get_size()));
         }
@@ -43,6 +44,7 @@ namespace lava {
 
         i64 write(data_cptr data, ui64 size);
 
+        // absolute position from the beginning, returns the new position
         i64 seek(ui64 position);
         i64 tell() const;
 
@@ -23,13 +23,23 @@ namespace lava {
 
         queued_frames = target->get_backbuffer_count();
 
-        fences.resize(queued_frames);
-        fences_in_use.resize(queued_frames, 0);
+        use_timeline = device->timeline_semaphore_supported();
+        if (use_timeline) {
+            if (!frame_timeline.create(device))
+                return false;
+
+            frame_values.resize(queued_frames, 0);
+            frame_values_in_use.resize(queued_frames, 0);
+        } else {
+            fences.resize(queued_frames);
+            fences_in_use.resize(queued_frames, 0);
+        }
+
         image_acquired_semaphores.resize(queued_frames);
         render_complete_semaphores.resize(queued_frames);
 
         for (auto i = 0u; i < queued_frames; ++i) {
-            {
+            if (!use_timeline) {
                 VkFenceCreateInfo const create_info{
                     .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
                     .flags = VK_FENCE_CREATE_SIGNALED_BIT,
@@ -59,8 +69,10 @@ namespace lava {
         if (on_destroy)
             on_destroy();
 
+        for (auto fence : fences)
+            device->vkDestroyFence(fence);
+
         for (auto i = 0u; i < queued_frames; ++i) {
-            device->vkDestroyFence(fences[i]);
             device->vkDestroySemaphore(image_acquired_semaphores[i]);
             device->vkDestroySemaphore(render_complete_semaphores[i]);
         }
@@ -70,32 +82,61 @@ namespace lava {
         image_acquired_semaphores.clear();
         render_complete_semaphores.clear();
 
-        queued_frames = 0;
-    }
+        frame_timeline.destroy();
+        frame_values.clear();
+        frame_values_in_use.clear();
 
-    optional_index renderer::begin_frame() {
-        if (!active)
-            return {};
+        frame_submit.clear();
 
-        std::array<VkFence, 1> const wait_fences = { fences[current_sync] };
+        queued_frames = 0;
+    }
 
+    bool renderer::wait_frame() {
         for (;;) {
-            auto result = device->vkWaitForFences(to_ui32(wait_fences.size()), wait_fences.data(), VK_TRUE, 100);
+            auto result = use_timeline ? wait_sync_points(device, { frame_timeline.get_point(frame_values[current_sync]) }, 100)
+                                       : device->vkWaitForFences(1, &fences[current_sync], VK_TRUE, 100);
             if (result)
-                break;
+                return true;
 
             if (result.value == VK_TIMEOUT)
                 continue;
 
-            if (result.value == VK_ERROR_OUT_OF_DATE_KHR) {
+            if (result.value == VK_ERROR_OUT_OF_DATE_KHR)
                 target->request_reload();
-                return {};
-            }
 
-            if (!result)
-                return {};
+            return false;
+        }
+    }
+
+    bool renderer::wait_frame_in_use() {
+        vk_result result;
+
+        if (use_timeline) {
+            auto const value = frame_values_in_use[current_frame];
+            if (value == 0)
+                return true;
+
+            result = wait_sync_points(device, { frame_timeline.get_point(value) });
+        } else {
+            if ((fences_in_use[current_frame] == 0) || (fences_in_use[current_frame] == fences[current_sync]))
+                return true;
+
+            result = device->vkWaitForFences(1, &fences_in_use[current_frame], VK_TRUE, UINT64_MAX);
         }
 
+        if (result.value == VK_ERROR_OUT_OF_DATE_KHR)
+            target->request_reload();
+
+        return result;
+    }
+
+    optional_index renderer::begin_frame() {
+        if (!active)
+            return {};
+
+        if (!wait_frame())
+            return {};
+
         auto current_semaphore = image_acquired_semaphores[current_sync];
 
         auto result = device->vkAcquireNextImageKHR(target->get(), UINT64_MAX, current_semaphore, 0, &current_frame);
@@ -105,16 +146,17 @@ namespace lava {
         }
 
         // because frames might not come in sequential order current frame might still be locked
-        if ((fences_in_use[current_frame] != 0) && (fences_in_use[current_frame] != fences[current_sync])) {
-            auto result = device->vkWaitForFences(1, &fences_in_use[current_frame], VK_TRUE, UINT64_MAX);
-
-            if (result.value == VK_ERROR_OUT_OF_DATE_KHR) {
-                target->request_reload();
-                return {};
-            }
+        if (!wait_frame_in_use())
+            return {};
 
+        if (use_timeline) {
             if (!result)
                 return {};
+
+            frame_values[current_sync] = frame_timeline.next();
+            frame_values_in_use[current_frame] = frame_values[current_sync];
+
+            return get_frame();
         }
 
         fences_in_use[current_frame] = fences[current_sync];
@@ -122,7 +164,7 @@ namespace lava {
         if (!result)
             return {};
 
-        if (!device->vkResetFences(to_ui32(wait_fences.size()), wait_fences.data()))
+        if (!device->vkResetFences(1, &fences[current_sync]))
             return {};
 
         return get_frame();
@@ -131,26 +173,22 @@ namespace lava {
     bool renderer::end_frame(VkCommandBuffers const& cmd_buffers) {
         assert(!cmd_buffers.empty());
 
-        std::array<VkSemaphore, 1> const wait_semaphores = { image_acquired_semaphores[current_sync] };
+        frame_submit.add_wait(image_acquired_semaphores[current_sync], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
         std::array<VkSemaphore, 1> const sync_present_semaphores = { render_complete_semaphores[current_sync] };
+        frame_submit.add_signal(render_complete_semaphores[current_sync]);
 
-        VkPipelineStageFlags const wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-
-        VkSubmitInfo const submit_info{
-            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .waitSemaphoreCount = to_ui32(wait_semaphores.size()),
-            .pWaitSemaphores = wait_semaphores.data(),
-            .pWaitDstStageMask = &wait_stage,
-            .commandBufferCount = to_ui32(cmd_buffers.size()),
-            .pCommandBuffers = cmd_buffers.data(),
-            .signalSemaphoreCount = to_ui32(sync_present_semaphores.size()),
-            .pSignalSemaphores = sync_present_semaphores.data(),
-        };
+        if (use_timeline)
+            frame_submit.add_signal(frame_timeline.get_point(frame_values[current_sync]));
+
+        std::array<VkSubmitInfo, 1> const submit_infos = { frame_submit.get_submit_info(cmd_buffers) };
+        VkFence current_fence = use_timeline ? VK_NULL_HANDLE : fences[current_sync];
+
+        auto submitted = device->vkQueueSubmit(graphics_queue.vk_queue, to_ui32(submit_infos.size()), submit_infos.data(), current_fence);
 
-        std::array<VkSubmitInfo, 1> const submit_infos = { submit_info };
-        VkFence current_fence = fences[current_sync];
+        frame_submit.clear();
 
-        if (!device->vkQueueSubmit(graphics_queue.vk_queue, to_ui32(submit_infos.size()), submit_infos.data(), current_fence))
+        if (!submitted)
             return false;
 
         std::array<VkSwapchainKHR, 1> const swapchains = { target->get() };
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <liblava/base/timeline_semaphore.hpp>
 #include <liblava/frame/swapchain.hpp>
 #include <optional>
 
@@ -25,6 +26,26 @@ namespace lava {
             return end_frame(cmd_buffers);
         }
 
+        // extra semaphore for the next end_frame (e.g. transfer queue uploads)
+        void add_wait_semaphore(VkSemaphore semaphore, VkPipelineStageFlags stage) {
+            frame_submit.add_wait(semaphore, stage);
+        }
+
+        // timeline value for the next end_frame (e.g. uploads or compute jobs)
+        void add_wait(sync_point point, VkPipelineStageFlags stage) {
+            frame_submit.add_wait(point, stage);
+        }
+
+        // signaled when the last submitted frame is done, invalid with fences
+        sync_point get_frame_sync() const {
+            return frame_timeline.get_last_point();
+        }
+
+        // timeline semaphore instead of fences, if supported by the device
+        bool timeline_used() const {
+            return use_timeline;
+        }
+
         index get_frame() const {
             return current_frame;
         }
@@ -52,6 +73,16 @@ namespace lava {
         VkFences fences_in_use = {};
         VkSemaphores image_acquired_semaphores = {};
         VkSemaphores render_complete_semaphores = {};
+
+        bool use_timeline = false;
+        timeline_semaphore frame_timeline;
+        std::vector<ui64> frame_values = {};
+        std::vector<ui64> frame_values_in_use = {};
+
+        timeline_submit frame_submit;
+
+        bool wait_frame();
+        bool wait_frame_in_use();
     };
 
 } // namespace lava
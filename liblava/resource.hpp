@@ -4,8 +4,15 @@
 
 #pragma once
 
+#include <liblava/resource/block_compression.hpp>
 #include <liblava/resource/buffer.hpp>
+#include <liblava/resource/buffer_allocator.hpp>
+#include <liblava/resource/defragmenter.hpp>
 #include <liblava/resource/format.hpp>
 #include <liblava/resource/image.hpp>
 #include <liblava/resource/mesh.hpp>
+#include <liblava/resource/mip_map.hpp>
+#include <liblava/resource/staging.hpp>
 #include <liblava/resource/texture.hpp>
+#include <liblava/resource/transient_image_pool.hpp>
+#include <liblava/resource/uniform_ring.hpp>
@@ -0,0 +1,680 @@
+// file      : liblava/resource/block_compression.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <array>
+#include <cmath>
+#include <liblava/resource/block_compression.hpp>
+
+namespace lava {
+
+    using block_texels = std::array<v4, 16>;
+
+    constexpr r32 const block_max_error = 1e30f;
+
+    VkFormat get_block_format(block_format format, bool srgb) {
+        switch (format) {
+        case block_format::bc1:
+            return srgb ? VK_FORMAT_BC1_RGBA_SRGB_BLOCK : VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case block_format::bc3:
+            return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        case block_format::bc5:
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case block_format::bc7:
+            return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+        }
+
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    size_t get_block_bytes(block_format format) {
+        return format == block_format::bc1 ? 8 : 16;
+    }
+
+    size_t get_block_compressed_size(uv2 size, block_format format) {
+        return size_t(ceil_div(size.x, 4u)) * ceil_div(size.y, 4u) * get_block_bytes(format);
+    }
+
+    // edge blocks repeat the last row / column
+    void load_block(cdata const& source, uv2 size, ui32 block_x, ui32 block_y, block_texels& texels) {
+        auto const data = (ui8 const*) source.ptr;
+
+        for (auto y = 0u; y < 4; ++y) {
+            auto const sy = std::min(block_y * 4 + y, size.y - 1);
+
+            for (auto x = 0u; x < 4; ++x) {
+                auto const sx = std::min(block_x * 4 + x, size.x - 1);
+                auto const texel = data + (size_t(sy) * size.x + sx) * 4;
+
+                texels[y * 4 + x] = v4(texel[0], texel[1], texel[2], texel[3]);
+            }
+        }
+    }
+
+    // principal axis by power iteration, weights select the channels
+    v4 block_axis(block_texels const& texels, v4 const& mean, v4 const& mask) {
+        r32 cov[4][4] = {};
+
+        for (auto& texel : texels) {
+            auto const d = (texel - mean) * mask;
+
+            for (auto i = 0; i < 4; ++i)
+                for (auto j = 0; j < 4; ++j)
+                    cov[i][j] += d[i] * d[j];
+        }
+
+        v4 axis(1.f, 1.f, 1.f, 1.f);
+        axis *= mask;
+
+        for (auto iteration = 0; iteration < 8; ++iteration) {
+            v4 next(0.f);
+            for (auto i = 0; i < 4; ++i)
+                for (auto j = 0; j < 4; ++j)
+                    next[i] += cov[i][j] * axis[j];
+
+            auto const length = std::sqrt(glm::dot(next, next));
+            if (length < 1e-6f)
+                break;
+
+            axis = next / length;
+        }
+
+        return axis;
+    }
+
+    void block_extremes(block_texels const& texels, v4 const& mask, v4& min, v4& max) {
+        v4 mean(0.f);
+        for (auto& texel : texels)
+            mean += texel;
+        mean /= 16.f;
+
+        auto const axis = block_axis(texels, mean, mask);
+
+        auto min_t = block_max_error;
+        auto max_t = -block_max_error;
+
+        for (auto& texel : texels) {
+            auto const t = glm::dot((texel - mean) * mask, axis);
+            min_t = std::min(min_t, t);
+            max_t = std::max(max_t, t);
+        }
+
+        min = glm::clamp(mean + axis * min_t, v4(0.f), v4(255.f));
+        max = glm::clamp(mean + axis * max_t, v4(0.f), v4(255.f));
+    }
+
+    // one least squares step for given index weights
+    bool refine_endpoints(block_texels const& texels, std::array<r32, 16> const& weights, v4& e0, v4& e1) {
+        r32 a = 0.f, b = 0.f, c = 0.f;
+        v4 rhs0(0.f), rhs1(0.f);
+
+        for (auto i = 0u; i < 16; ++i) {
+            auto const w = weights[i];
+            a += (1.f - w) * (1.f - w);
+            b += (1.f - w) * w;
+            c += w * w;
+
+            rhs0 += texels[i] * (1.f - w);
+            rhs1 += texels[i] * w;
+        }
+
+        auto const det = a * c - b * b;
+        if (std::abs(det) < 1e-6f)
+            return false;
+
+        e0 = glm::clamp((rhs0 * c - rhs1 * b) / det, v4(0.f), v4(255.f));
+        e1 = glm::clamp((rhs1 * a - rhs0 * b) / det, v4(0.f), v4(255.f));
+        return true;
+    }
+
+    r32 texel_error(v4 const& a, v4 const& b, v4 const& mask) {
+        auto const d = (a - b) * mask;
+        return glm::dot(d, d);
+    }
+
+    // bc1 color
+
+    ui16 pack_565(v4 const& color) {
+        auto const r = ui16(std::lround(color.r * 31.f / 255.f));
+        auto const g = ui16(std::lround(color.g * 63.f / 255.f));
+        auto const b = ui16(std::lround(color.b * 31.f / 255.f));
+        return ui16((r << 11) | (g << 5) | b);
+    }
+
+    v4 unpack_565(ui16 color) {
+        auto const r = (color >> 11) & 31;
+        auto const g = (color >> 5) & 63;
+        auto const b = color & 31;
+        return v4((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255.f);
+    }
+
+    void bc1_palette(ui16 c0, ui16 c1, bool four_colors, std::array<v4, 4>& palette) {
+        palette[0] = unpack_565(c0);
+        palette[1] = unpack_565(c1);
+
+        if (four_colors) {
+            palette[2] = (palette[0] * 2.f + palette[1]) / 3.f;
+            palette[3] = (palette[0] + palette[1] * 2.f) / 3.f;
+        } else {
+            palette[2] = (palette[0] + palette[1]) * 0.5f;
+            palette[3] = v4(0.f);
+        }
+    }
+
+    // returns the error, transparent texels use index 3 in three color mode
+    r32 bc1_indices(block_texels const& texels, std::array<v4, 4> const& palette, bool four_colors,
+                    ui32 alpha_threshold, ui32& indices) {
+        v4 const mask(1.f, 1.f, 1.f, 0.f);
+
+        indices = 0;
+        auto result = 0.f;
+
+        for (auto i = 0u; i < 16; ++i) {
+            if (!four_colors && (texels[i].a < alpha_threshold)) {
+                indices |= 3u << (i * 2);
+                continue;
+            }
+
+            auto best = 0u;
+            auto best_error = block_max_error;
+
+            for (auto p = 0u; p < (four_colors ? 4u : 3u); ++p) {
+                auto const error = texel_error(texels[i], palette[p], mask);
+                if (error < best_error) {
+                    best_error = error;
+                    best = p;
+                }
+            }
+
+            indices |= best << (i * 2);
+            result += best_error;
+        }
+
+        return result;
+    }
+
+    r32 encode_bc1_endpoints(block_texels const& texels, v4 const& min, v4 const& max, bool four_colors,
+                             ui32 alpha_threshold, ui16& c0, ui16& c1, ui32& indices) {
+        c0 = pack_565(max);
+        c1 = pack_565(min);
+
+        // four color mode needs c0 > c1, three color mode c0 <= c1
+        if ((four_colors && (c0 < c1)) || (!four_colors && (c0 > c1)))
+            std::swap(c0, c1);
+
+        if (four_colors && (c0 == c1)) {
+            indices = 0;
+
+            std::array<v4, 4> palette;
+            bc1_palette(c0, c1, false, palette);
+
+            auto error = 0.f;
+            for (auto& texel : texels)
+                error += texel_error(texel, palette[0], v4(1.f, 1.f, 1.f, 0.f));
+            return error;
+        }
+
+        std::array<v4, 4> palette;
+        bc1_palette(c0, c1, four_colors, palette);
+
+        return bc1_indices(texels, palette, four_colors, alpha_threshold, indices);
+    }
+
+    void encode_bc1_block(block_texels const& texels, bool alpha, ui8* block) {
+        ui32 const alpha_threshold = 128;
+
+        auto transparent = false;
+        if (alpha)
+            for (auto& texel : texels)
+                transparent |= texel.a < alpha_threshold;
+
+        auto const four_colors = !transparent;
+        v4 const mask(1.f, 1.f, 1.f, 0.f);
+
+        v4 min, max;
+        block_extremes(texels, mask, min, max);
+
+        ui16 c0 = 0, c1 = 0;
+        ui32 indices = 0;
+        auto error = encode_bc1_endpoints(texels, min, max, four_colors, alpha_threshold, c0, c1, indices);
+
+        if (four_colors && (c0 != c1)) {
+            static std::array<r32, 4> const index_weights = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+
+            std::array<r32, 16> weights;
+            for (auto i = 0u; i < 16; ++i)
+                weights[i] = index_weights[(indices >> (i * 2)) & 3];
+
+            // weights run from c0 (max) to c1 (min)
+            v4 e0, e1;
+            if (refine_endpoints(texels, weights, e0, e1)) {
+                ui16 r0 = 0, r1 = 0;
+                ui32 refined_indices = 0;
+                auto const refined_error = encode_bc1_endpoints(texels, e1, e0, true, alpha_threshold, r0, r1, refined_indices);
+
+                if (refined_error < error) {
+                    c0 = r0;
+                    c1 = r1;
+                    indices = refined_indices;
+                }
+            }
+        }
+
+        memcpy(block, &c0, 2);
+        memcpy(block + 2, &c1, 2);
+        memcpy(block + 4, &indices, 4);
+    }
+
+    // bc4 single channel (bc3 alpha, bc5 red / green)
+
+    void encode_bc4_block(block_texels const& texels, ui32 channel, ui8* block) {
+        auto min = 255.f;
+        auto max = 0.f;
+
+        for (auto& texel : texels) {
+            min = std::min(min, texel[channel]);
+            max = std::max(max, texel[channel]);
+        }
+
+        auto const a0 = ui8(std::lround(max));
+        auto const a1 = ui8(std::lround(min));
+
+        block[0] = a0;
+        block[1] = a1;
+
+        ui64 indices = 0;
+
+        if (a0 > a1) {
+            // eight values, position 0 = a0 (index 0), 7 = a1 (index 1), between use index + 1
+            for (auto i = 0u; i < 16; ++i) {
+                auto const t = std::lround((a0 - texels[i][channel]) * 7.f / (a0 - a1));
+                auto const position = std::clamp(i32(t), 0, 7);
+
+                ui64 const index = position == 0 ? 0 : (position == 7 ? 1 : position + 1);
+                indices |= index << (i * 3);
+            }
+        }
+
+        for (auto i = 0u; i < 6; ++i)
+            block[2 + i] = ui8(indices >> (i * 8));
+    }
+
+    // bc7 mode 6: rgba 7777 + p bit per endpoint, 4 bit indices
+
+    constexpr std::array<ui32, 16> const bc7_weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    struct bc7_endpoint {
+        std::array<ui32, 4> value; // 7 bit
+        ui32 p_bit = 0;
+
+        v4 expand() const {
+            return v4((value[0] << 1) | p_bit, (value[1] << 1) | p_bit, (value[2] << 1) | p_bit, (value[3] << 1) | p_bit);
+        }
+    };
+
+    bc7_endpoint quantize_bc7(v4 const& color, ui32 p_bit) {
+        bc7_endpoint result;
+        result.p_bit = p_bit;
+
+        for (auto c = 0; c < 4; ++c)
+            result.value[c] = ui32(std::clamp(i32(std::lround((color[c] - p_bit) * 0.5f)), 0, 127));
+
+        return result;
+    }
+
+    v4 interpolate_bc7(v4 const& e0, v4 const& e1, ui32 weight) {
+        v4 result;
+        for (auto c = 0; c < 4; ++c)
+            result[c] = r32((ui32(e0[c]) * (64 - weight) + ui32(e1[c]) * weight + 32) >> 6);
+
+        return result;
+    }
+
+    r32 bc7_indices(block_texels const& texels, bc7_endpoint const& q0, bc7_endpoint const& q1,
+                    std::array<ui32, 16>& indices) {
+        auto const e0 = q0.expand();
+        auto const e1 = q1.expand();
+
+        std::array<v4, 16> palette;
+        for (auto i = 0u; i < 16; ++i)
+            palette[i] = interpolate_bc7(e0, e1, bc7_weights[i]);
+
+        v4 const mask(1.f);
+        auto result = 0.f;
+
+        for (auto i = 0u; i < 16; ++i) {
+            auto best = 0u;
+            auto best_error = block_max_error;
+
+            for (auto p = 0u; p < 16; ++p) {
+                auto const error = texel_error(texels[i], palette[p], mask);
+                if (error < best_error) {
+                    best_error = error;
+                    best = p;
+                }
+            }
+
+            indices[i] = best;
+            result += best_error;
+        }
+
+        return result;
+    }
+
+    r32 encode_bc7_endpoints(block_texels const& texels, v4 const& e0, v4 const& e1,
+                             bc7_endpoint& q0, bc7_endpoint& q1, std::array<ui32, 16>& indices) {
+        auto result = block_max_error;
+
+        for (auto p0 = 0u; p0 < 2; ++p0) {
+            for (auto p1 = 0u; p1 < 2; ++p1) {
+                auto const t0 = quantize_bc7(e0, p0);
+                auto const t1 = quantize_bc7(e1, p1);
+
+                std::array<ui32, 16> t_indices;
+                auto const error = bc7_indices(texels, t0, t1, t_indices);
+
+                if (error < result) {
+                    result = error;
+                    q0 = t0;
+                    q1 = t1;
+                    indices = t_indices;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    struct bit_writer {
+        ui8* data = nullptr;
+        ui32 position = 0;
+
+        void write(ui32 value, ui32 count) {
+            for (auto i = 0u; i < count; ++i, ++position)
+                if ((value >> i) & 1)
+                    data[position >> 3] |= ui8(1 << (position & 7));
+        }
+    };
+
+    struct bit_reader {
+        ui8 const* data = nullptr;
+        ui32 position = 0;
+
+        ui32 read(ui32 count) {
+            ui32 result = 0;
+            for (auto i = 0u; i < count; ++i, ++position)
+                result |= ((data[position >> 3] >> (position & 7)) & 1u) << i;
+
+            return result;
+        }
+    };
+
+    void encode_bc7_block(block_texels const& texels, ui8* block) {
+        v4 min, max;
+        block_extremes(texels, v4(1.f), min, max);
+
+        bc7_endpoint q0, q1;
+        std::array<ui32, 16> indices;
+        auto error = encode_bc7_endpoints(texels, min, max, q0, q1, indices);
+
+        std::array<r32, 16> weights;
+        for (auto i = 0u; i < 16; ++i)
+            weights[i] = bc7_weights[indices[i]] / 64.f;
+
+        v4 e0, e1;
+        if (refine_endpoints(texels, weights, e0, e1)) {
+            bc7_endpoint r0, r1;
+            std::array<ui32, 16> refined_indices;
+
+            if (encode_bc7_endpoints(texels, e0, e1, r0, r1, refined_indices) < error) {
+                q0 = r0;
+                q1 = r1;
+                indices = refined_indices;
+            }
+        }
+
+        // anchor index has an implicit zero msb
+        if (indices[0] & 8) {
+            std::swap(q0, q1);
+            for (auto& index : indices)
+                index = 15 - index;
+        }
+
+        memset(block, 0, 16);
+        bit_writer writer{ block };
+
+        writer.write(1 << 6, 7);
+
+        for (auto c = 0; c < 4; ++c) {
+            writer.write(q0.value[c], 7);
+            writer.write(q1.value[c], 7);
+        }
+
+        writer.write(q0.p_bit, 1);
+        writer.write(q1.p_bit, 1);
+
+        writer.write(indices[0], 3);
+        for (auto i = 1u; i < 16; ++i)
+            writer.write(indices[i], 4);
+    }
+
+    bool decode_bc7_block(ui8 const* block, block_texels& texels) {
+        bit_reader reader{ block };
+
+        if (reader.read(7) != (1 << 6))
+            return false;
+
+        bc7_endpoint q0, q1;
+        for (auto c = 0; c < 4; ++c) {
+            q0.value[c] = reader.read(7);
+            q1.value[c] = reader.read(7);
+        }
+
+        q0.p_bit = reader.read(1);
+        q1.p_bit = reader.read(1);
+
+        auto const e0 = q0.expand();
+        auto const e1 = q1.expand();
+
+        for (auto i = 0u; i < 16; ++i)
+            texels[i] = interpolate_bc7(e0, e1, bc7_weights[reader.read(i == 0 ? 3 : 4)]);
+
+        return true;
+    }
+
+    void decode_bc1_block(ui8 const* block, bool force_four_colors, block_texels& texels) {
+        ui16 c0 = 0, c1 = 0;
+        ui32 indices = 0;
+        memcpy(&c0, block, 2);
+        memcpy(&c1, block + 2, 2);
+        memcpy(&indices, block + 4, 4);
+
+        std::array<v4, 4> palette;
+        bc1_palette(c0, c1, force_four_colors || (c0 > c1), palette);
+
+        for (auto i = 0u; i < 16; ++i)
+            texels[i] = palette[(indices >> (i * 2)) & 3];
+    }
+
+    void decode_bc4_block(ui8 const* block, ui32 channel, block_texels& texels) {
+        r32 const a0 = block[0];
+        r32 const a1 = block[1];
+
+        std::array<r32, 8> palette = { a0, a1 };
+        for (auto i = 2u; i < 8; ++i)
+            palette[i] = a0 > a1 ? ((8 - i) * a0 + (i - 1) * a1) / 7.f
+                                 : (i < 6 ? ((6 - i) * a0 + (i - 1) * a1) / 5.f : (i == 6 ? 0.f : 255.f));
+
+        ui64 indices = 0;
+        for (auto i = 0u; i < 6; ++i)
+            indices |= ui64(block[2 + i]) << (i * 8);
+
+        for (auto i = 0u; i < 16; ++i)
+            texels[i][channel] = std::floor(palette[(indices >> (i * 3)) & 7] + 0.5f);
+    }
+
+    void compress_block_rows(cdata const& source, uv2 size, block_format format, ui8* result,
+                             ui32 first_row, ui32 last_row) {
+        auto const blocks_x = ceil_div(size.x, 4u);
+        auto const block_bytes = get_block_bytes(format);
+
+        block_texels texels;
+
+        for (auto by = first_row; by < last_row; ++by) {
+            for (auto bx = 0u; bx < blocks_x; ++bx) {
+                load_block(source, size, bx, by, texels);
+
+                auto block = result + (size_t(by) * blocks_x + bx) * block_bytes;
+
+                switch (format) {
+                case block_format::bc1:
+                    encode_bc1_block(texels, true, block);
+                    break;
+
+                case block_format::bc3:
+                    encode_bc4_block(texels, 3, block);
+                    encode_bc1_block(texels, false, block + 8);
+                    break;
+
+                case block_format::bc5:
+                    encode_bc4_block(texels, 0, block);
+                    encode_bc4_block(texels, 1, block + 8);
+                    break;
+
+                case block_format::bc7:
+                    encode_bc7_block(texels, block);
+                    break;
+                }
+            }
+        }
+    }
+
+    bool prepare_blocks(cdata const& source, uv2 size, block_format format, unique_data& result) {
+        if (!source.ptr || (size.x == 0) || (size.y == 0) || (source.size < size_t(size.x) * size.y * 4)) {
+            log()->error("compress blocks - invalid source");
+            return false;
+        }
+
+        result.set(get_block_compressed_size(size, format));
+        if (!result.ptr) {
+            log()->error("compress blocks - allocate {} bytes", result.size);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool compress_blocks(cdata const& source, uv2 size, block_format format, unique_data& result) {
+        if (!prepare_blocks(source, size, format, result))
+            return false;
+
+        compress_block_rows(source, size, format, (ui8*) result.ptr, 0, ceil_div(size.y, 4u));
+        return true;
+    }
+
+    bool compress_blocks(cdata const& source, uv2 size, block_format format, unique_data& result,
+                         thread_pool& pool, ui32 task_count) {
+        if (!prepare_blocks(source, size, format, result))
+            return false;
+
+        auto const block_rows = ceil_div(size.y, 4u);
+        auto const rows_per_task = ceil_div(block_rows, std::clamp(task_count, 1u, block_rows));
+
+        return pool.parallel_for(ceil_div(block_rows, rows_per_task), [&](index task) {
+            auto const first = task * rows_per_task;
+            compress_block_rows(source, size, format, (ui8*) result.ptr, first, std::min(first + rows_per_task, block_rows));
+            return true;
+        });
+    }
+
+    bool decompress_blocks(cdata const& source, uv2 size, block_format format, unique_data& result) {
+        if (!source.ptr || (source.size < get_block_compressed_size(size, format))) {
+            log()->error("decompress blocks - invalid source");
+            return false;
+        }
+
+        result.set(size_t(size.x) * size.y * 4);
+        if (!result.ptr)
+            return false;
+
+        auto const blocks_x = ceil_div(size.x, 4u);
+        auto const blocks_y = ceil_div(size.y, 4u);
+        auto const block_bytes = get_block_bytes(format);
+
+        auto const src = (ui8 const*) source.ptr;
+        auto const dst = (ui8*) result.ptr;
+
+        block_texels texels;
+
+        for (auto by = 0u; by < blocks_y; ++by) {
+            for (auto bx = 0u; bx < blocks_x; ++bx) {
+                auto const block = src + (size_t(by) * blocks_x + bx) * block_bytes;
+
+                texels.fill(v4(0.f, 0.f, 0.f, 255.f));
+
+                switch (format) {
+                case block_format::bc1:
+                    decode_bc1_block(block, false, texels);
+                    break;
+
+                case block_format::bc3: {
+                    decode_bc1_block(block + 8, true, texels);
+                    decode_bc4_block(block, 3, texels);
+                    break;
+                }
+
+                case block_format::bc5:
+                    decode_bc4_block(block, 0, texels);
+                    decode_bc4_block(block + 8, 1, texels);
+                    break;
+
+                case block_format::bc7:
+                    if (!decode_bc7_block(block, texels)) {
+                        log()->error("decompress blocks - bc7 mode not supported");
+                        return false;
+                    }
+                    break;
+                }
+
+                for (auto y = 0u; y < 4; ++y) {
+                    for (auto x = 0u; x < 4; ++x) {
+                        auto const px = bx * 4 + x;
+                        auto const py = by * 4 + y;
+                        if ((px >= size.x) || (py >= size.y))
+                            continue;
+
+                        auto texel = dst + (size_t(py) * size.x + px) * 4;
+                        for (auto c = 0; c < 4; ++c)
+                            texel[c] = ui8(std::clamp(texels[y * 4 + x][c], 0.f, 255.f));
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    r64 compute_psnr(cdata const& reference, cdata const& data, ui32 channels) {
+        auto const count = std::min(reference.size, data.size) / 4;
+        if ((count == 0) || (channels == 0))
+            return 0.0;
+
+        auto const a = (ui8 const*) reference.ptr;
+        auto const b = (ui8 const*) data.ptr;
+
+        r64 sum = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            for (auto c = 0u; c < channels; ++c) {
+                auto const d = r64(a[i * 4 + c]) - r64(b[i * 4 + c]);
+                sum += d * d;
+            }
+        }
+
+        auto const mse = sum / (r64(count) * channels);
+        if (mse <= 0.0)
+            return 100.0;
+
+        return 10.0 * std::log10(255.0 * 255.0 / mse);
+    }
+
+} // namespace lava
@@ -0,0 +1,36 @@
+// file      : liblava/resource/block_compression.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/base/base.hpp>
+#include <liblava/util/thread.hpp>
+
+namespace lava {
+
+    enum class block_format : type {
+        bc1 = 0,
+        bc3,
+        bc5,
+        bc7
+    };
+
+    VkFormat get_block_format(block_format format, bool srgb = false);
+
+    size_t get_block_compressed_size(uv2 size, block_format format);
+
+    // rgba8 texels, blocks are written row by row (bc7 uses mode 6)
+    bool compress_blocks(cdata const& source, uv2 size, block_format format, unique_data& result);
+
+    // block rows split into task_count tasks, one on the calling thread and the others on pool
+    bool compress_blocks(cdata const& source, uv2 size, block_format format, unique_data& result,
+                         thread_pool& pool, ui32 task_count);
+
+    // back to rgba8, for verification of compress_blocks output
+    bool decompress_blocks(cdata const& source, uv2 size, block_format format, unique_data& result);
+
+    // over the first channels of rgba8 texels
+    r64 compute_psnr(cdata const& reference, cdata const& data, ui32 channels = 4);
+
+} // namespace lava
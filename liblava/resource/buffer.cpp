@@ -42,8 +42,9 @@ namespace lava {
         return flags;
     }
 
-    bool buffer::create(device_ptr d, void const* data, size_t size, VkBufferUsageFlags usage, bool mapped, VmaMemoryUsage memory_usage) {
+    bool buffer::create(device_ptr d, void const* data, size_t size, VkBufferUsageFlags u, bool mapped, VmaMemoryUsage memory_usage) {
         device = d;
+        usage = u;
 
         VkBufferCreateInfo buffer_info{
             .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
@@ -53,6 +54,12 @@ namespace lava {
             .queueFamilyIndexCount = 0,
         };
 
+        if (shared_families.size() > 1) {
+            buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            buffer_info.queueFamilyIndexCount = to_ui32(shared_families.size());
+            buffer_info.pQueueFamilyIndices = shared_families.data();
+        }
+
         VmaAllocationCreateFlags const alloc_flags = mapped ? VMA_ALLOCATION_CREATE_MAPPED_BIT : 0;
 
         VmaAllocationCreateInfo alloc_info{
@@ -65,23 +72,14 @@ namespace lava {
             return false;
         }
 
-        if (!mapped) {
-            if (data) {
-                data_ptr map = nullptr;
-                if (failed(vmaMapMemory(device->alloc(), allocation, (void**) (&map)))) {
-                    log()->error("map buffer memory");
-                    return false;
-                }
+        vmaGetMemoryTypeProperties(device->alloc(), allocation_info.memoryType, &memory_flags);
 
-                memcpy(map, data, size);
-
-                vmaUnmapMemory(device->alloc(), allocation);
-            }
-        } else if (data && allocation_info.pMappedData) {
-            memcpy(allocation_info.pMappedData, data, size);
+        if (auto allocator = device->get_allocator())
+            allocator->track(tag, allocation_info.size);
+        mapped_on_use = false;
 
-            flush();
-        }
+        if (data && !write(0, data, size))
+            return false;
 
         descriptor.buffer = vk_buffer;
         descriptor.offset = 0;
@@ -98,6 +96,14 @@ namespace lava {
         if (!vk_buffer)
             return;
 
+        if (mapped_on_use) {
+            vmaUnmapMemory(device->alloc(), allocation);
+            mapped_on_use = false;
+        }
+
+        if (auto allocator = device->get_allocator())
+            allocator->untrack(tag, allocation_info.size);
+
         vmaDestroyBuffer(device->alloc(), vk_buffer, allocation);
         vk_buffer = VK_NULL_HANDLE;
         allocation = nullptr;
@@ -105,6 +111,18 @@ namespace lava {
         device = nullptr;
     }
 
+    VkBuffer buffer::relocate(VkBuffer new_buffer, VkDeviceMemory memory, VkDeviceSize offset) {
+        auto const old_buffer = vk_buffer;
+
+        vk_buffer = new_buffer;
+        descriptor.buffer = new_buffer;
+
+        allocation_info.deviceMemory = memory;
+        allocation_info.offset = offset;
+
+        return old_buffer;
+    }
+
     VkDeviceAddress buffer::get_address() const {
         if (device->call().vkGetBufferDeviceAddressKHR) {
             VkBufferDeviceAddressInfoKHR addr_info{
@@ -117,8 +135,108 @@ namespace lava {
         }
     }
 
+    void* buffer::map() {
+        if (allocation_info.pMappedData)
+            return allocation_info.pMappedData;
+
+        if (!host_visible()) {
+            log()->error("map buffer - memory not host visible");
+            return nullptr;
+        }
+
+        // stays mapped until destroy
+        if (failed(vmaMapMemory(device->alloc(), allocation, &allocation_info.pMappedData))) {
+            log()->error("map buffer memory");
+            return nullptr;
+        }
+
+        mapped_on_use = true;
+        return allocation_info.pMappedData;
+    }
+
+    bool buffer::write(VkDeviceSize offset, void const* data, VkDeviceSize size, bool flush_range) {
+        if (offset + size > get_size()) {
+            log()->error("write buffer - {} bytes at {} exceed size {}", size, offset, get_size());
+            return false;
+        }
+
+        auto target = map();
+        if (!target)
+            return false;
+
+        memcpy(as_ptr(target) + offset, data, size);
+
+        if (flush_range)
+            flush(offset, size);
+
+        return true;
+    }
+
     void buffer::flush(VkDeviceSize offset, VkDeviceSize size) {
+        if (host_coherent())
+            return;
+
         vmaFlushAllocation(device->alloc(), allocation, offset, size);
     }
 
+    void buffer::flush(range::list const& ranges) {
+        if (host_coherent())
+            return;
+
+        auto const atom_size = device->get_properties().limits.nonCoherentAtomSize;
+        for (auto& current : merge_buffer_ranges(ranges, atom_size, get_size()))
+            vmaFlushAllocation(device->alloc(), allocation, current.offset, current.size);
+    }
+
+    void buffer::invalidate(VkDeviceSize offset, VkDeviceSize size) {
+        if (host_coherent())
+            return;
+
+        vmaInvalidateAllocation(device->alloc(), allocation, offset, size);
+    }
+
+    void buffer::invalidate(range::list const& ranges) {
+        if (host_coherent())
+            return;
+
+        auto const atom_size = device->get_properties().limits.nonCoherentAtomSize;
+        for (auto& current : merge_buffer_ranges(ranges, atom_size, get_size()))
+            vmaInvalidateAllocation(device->alloc(), allocation, current.offset, current.size);
+    }
+
+    buffer::range::list merge_buffer_ranges(buffer::range::list ranges, VkDeviceSize atom_size, VkDeviceSize buffer_size) {
+        atom_size = std::max(atom_size, VkDeviceSize(1));
+
+        for (auto& current : ranges) {
+            if ((current.size == 0) || (current.offset >= buffer_size)) {
+                current.size = 0;
+                continue;
+            }
+
+            auto const end = current.size == VK_WHOLE_SIZE ? buffer_size
+                                                           : std::min(current.offset + current.size, buffer_size);
+
+            current.offset = current.offset / atom_size * atom_size;
+            current.size = std::min(align_up(end, atom_size), buffer_size) - current.offset;
+        }
+
+        std::sort(ranges.begin(), ranges.end(), [](auto const& a, auto const& b) { return a.offset < b.offset; });
+
+        buffer::range::list result;
+        for (auto& current : ranges) {
+            if (current.size == 0)
+                continue;
+
+            if (!result.empty() && (result.back().offset + result.back().size >= current.offset)) {
+                auto& last = result.back();
+                last.size = std::max(last.offset + last.size, current.offset + current.size) - last.offset;
+                continue;
+            }
+
+            result.push_back(current);
+        }
+
+        return result;
+    }
+
 } // namespace lava
@@ -12,6 +12,13 @@ namespace lava {
         using ptr = std::shared_ptr<buffer>;
         using list = std::vector<ptr>;
 
+        struct range {
+            using list = std::vector<range>;
+
+            VkDeviceSize offset = 0;
+            VkDeviceSize size = VK_WHOLE_SIZE;
+        };
+
         static VkPipelineStageFlags usage_to_possible_stages(VkBufferUsageFlags usage);
         static VkAccessFlags usage_to_possible_access(VkBufferUsageFlags usage);
 
@@ -46,6 +53,9 @@ namespace lava {
         VkDeviceSize get_size() const {
             return allocation_info.size;
         }
+        VkBufferUsageFlags get_usage() const {
+            return usage;
+        }
         void* get_mapped_data() const {
             return allocation_info.pMappedData;
         }
@@ -53,7 +63,44 @@ namespace lava {
             return allocation_info.deviceMemory;
         }
 
+        // host visible memory, buffers created without mapping are mapped once on first use
+        void* map();
+
+        bool write(VkDeviceSize offset, void const* data, VkDeviceSize size, bool flush_range = true);
+
+        // no-ops on host coherent memory
         void flush(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+        void flush(range::list const& ranges);
+
+        // before reading back gpu writes
+        void invalidate(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+        void invalidate(range::list const& ranges);
+
+        bool host_visible() const {
+            return memory_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        }
+        bool host_coherent() const {
+            return memory_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        }
+
+        // memory stats accounting, before create
+        void set_memory_tag(memory_tag value) {
+            tag = value;
+        }
+        memory_tag get_memory_tag() const {
+            return tag;
+        }
+
+        // concurrent use by these queue families without ownership transfers, before create
+        void set_shared_families(index_list const& value) {
+            shared_families = value;
+        }
+        index_list const& get_shared_families() const {
+            return shared_families;
+        }
+
+        // handle bound to moved memory, the old one is returned to be destroyed once unused
+        VkBuffer relocate(VkBuffer new_buffer, VkDeviceMemory memory, VkDeviceSize offset);
 
         VmaAllocation const& get_allocation() const {
             return allocation;
@@ -67,11 +114,21 @@ namespace lava {
 
         VkBuffer vk_buffer = VK_NULL_HANDLE;
         VmaAllocation allocation = nullptr;
+        VkBufferUsageFlags usage = 0;
 
         VmaAllocationInfo allocation_info = {};
         VkDescriptorBufferInfo descriptor = {};
+
+        VkMemoryPropertyFlags memory_flags = 0;
+        bool mapped_on_use = false;
+
+        memory_tag tag = memory_tag::none;
+        index_list shared_families;
     };
 
+    // sorted, expanded to atom size and merged where they touch
+    buffer::range::list merge_buffer_ranges(buffer::range::list ranges, VkDeviceSize atom_size, VkDeviceSize buffer_size);
+
     inline buffer::ptr make_buffer() {
         return std::make_shared<buffer>();
     }
@@ -0,0 +1,260 @@
+// file      : liblava/resource/buffer_allocator.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/resource/buffer_allocator.hpp>
+
+namespace lava {
+
+    void range_allocator::reset(VkDeviceSize c) {
+        capacity = c;
+        used = 0;
+
+        free_ranges.clear();
+        if (capacity > 0)
+            free_ranges.emplace(0, capacity);
+    }
+
+    std::optional<VkDeviceSize> range_allocator::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+        if ((size == 0) || (alignment == 0))
+            return std::nullopt;
+
+        for (auto it = free_ranges.begin(); it != free_ranges.end(); ++it) {
+            auto const [offset, range_size] = *it;
+
+            auto const aligned = align_up(offset, alignment);
+            if (aligned + size > offset + range_size)
+                continue;
+
+            free_ranges.erase(it);
+
+            // padding in front stays free
+            if (aligned > offset)
+                free_ranges.emplace(offset, aligned - offset);
+
+            if (aligned + size < offset + range_size)
+                free_ranges.emplace(aligned + size, offset + range_size - aligned - size);
+
+            used += size;
+            return aligned;
+        }
+
+        return std::nullopt;
+    }
+
+    void range_allocator::free(VkDeviceSize offset, VkDeviceSize size) {
+        if (size == 0)
+            return;
+
+        auto it = free_ranges.emplace(offset, size).first;
+
+        auto const next = std::next(it);
+        if ((next != free_ranges.end()) && (it->first + it->second == next->first)) {
+            it->second += next->second;
+            free_ranges.erase(next);
+        }
+
+        if (it != free_ranges.begin()) {
+            auto const prev = std::prev(it);
+            if (prev->first + prev->second == it->first) {
+                prev->second += it->second;
+                free_ranges.erase(it);
+            }
+        }
+
+        used -= std::min(used, size);
+    }
+
+    void ring_allocator::reset(VkDeviceSize c) {
+        capacity = c;
+        head = 0;
+        tail = 0;
+
+        marks.clear();
+    }
+
+    std::optional<VkDeviceSize> ring_allocator::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+        if ((size == 0) || (alignment == 0))
+            return std::nullopt;
+
+        auto const offset = align_up(head, alignment);
+
+        if (head >= tail) {
+            if (offset + size <= capacity) {
+                head = offset + size;
+                return offset;
+            }
+
+            // wrap around, keep head behind tail
+            if (size < tail) {
+                head = size;
+                return 0;
+            }
+
+            return std::nullopt;
+        }
+
+        if (offset + size < tail) {
+            head = offset + size;
+            return offset;
+        }
+
+        return std::nullopt;
+    }
+
+    void ring_allocator::mark(ui64 serial) {
+        marks.push_back({ serial, head });
+    }
+
+    void ring_allocator::retire(ui64 serial) {
+        while (!marks.empty() && (marks.front().serial <= serial)) {
+            tail = marks.front().end;
+            marks.pop_front();
+        }
+
+        if (marks.empty()) {
+            head = 0;
+            tail = 0;
+        }
+    }
+
+    bool buffer_allocator::create(device_ptr d, VkBufferUsageFlags u, VkDeviceSize bs, VmaMemoryUsage mu) {
+        device = d;
+        usage = u;
+        block_size = bs;
+        memory_usage = mu;
+
+        if (block_size == 0) {
+            log()->error("create buffer allocator - invalid block size");
+            return false;
+        }
+
+        auto const& limits = device->get_properties().limits;
+
+        alignment = 1;
+        if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+            alignment = std::max(alignment, limits.minUniformBufferOffsetAlignment);
+        if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+            alignment = std::max(alignment, limits.minStorageBufferOffsetAlignment);
+        if (usage & (VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT))
+            alignment = std::max(alignment, limits.minTexelBufferOffsetAlignment);
+
+        // flushed ranges do not share atoms
+        if (memory_usage != VMA_MEMORY_USAGE_GPU_ONLY)
+            alignment = std::max(alignment, limits.nonCoherentAtomSize);
+
+        return add_block(block_size);
+    }
+
+    void buffer_allocator::destroy() {
+        blocks.clear();
+        device = nullptr;
+    }
+
+    bool buffer_allocator::add_block(VkDeviceSize size) {
+        block current;
+        current.buffer = make_buffer();
+
+        auto const mapped = memory_usage != VMA_MEMORY_USAGE_GPU_ONLY;
+        if (!current.buffer->create(device, nullptr, size, usage, mapped, memory_usage)) {
+            log()->error("create buffer allocator block - {} bytes", size);
+            return false;
+        }
+
+        current.ranges.reset(size);
+        blocks.push_back(std::move(current));
+
+        return true;
+    }
+
+    buffer_range buffer_allocator::allocate(VkDeviceSize size) {
+        buffer_range result;
+
+        if (!device || (size == 0))
+            return result;
+
+        auto const aligned_size = align_up(size, alignment);
+
+        std::optional<VkDeviceSize> offset;
+
+        auto block_index = 0u;
+        for (; block_index < blocks.size(); ++block_index) {
+            offset = blocks[block_index].ranges.allocate(aligned_size, alignment);
+            if (offset)
+                break;
+        }
+
+        if (!offset) {
+            if (!add_block(std::max(block_size, aligned_size)))
+                return result;
+
+            offset = blocks.back().ranges.allocate(aligned_size, alignment);
+            if (!offset)
+                return result;
+        }
+
+        auto const& target = blocks.at(block_index).buffer;
+
+        result.buffer = target->get();
+        result.block = block_index;
+        result.offset = *offset;
+        result.size = aligned_size;
+
+        if (auto data = target->get_mapped_data())
+            result.mapped = (data_ptr) data + *offset;
+
+        result.descriptor = {
+            .buffer = result.buffer,
+            .offset = result.offset,
+            .range = size,
+        };
+
+        return result;
+    }
+
+    buffer_range buffer_allocator::allocate(void const* data, VkDeviceSize size) {
+        auto result = allocate(size);
+        if (!result.valid())
+            return result;
+
+        if (!result.mapped) {
+            log()->error("buffer allocator - range not mapped");
+            free(result);
+            return result;
+        }
+
+        memcpy(result.mapped, data, size);
+        flush(result);
+
+        return result;
+    }
+
+    void buffer_allocator::free(buffer_range& range) {
+        if (!range.valid() || (range.block >= blocks.size()))
+            return;
+
+        blocks[range.block].ranges.free(range.offset, range.size);
+        range = {};
+    }
+
+    void buffer_allocator::reset() {
+        for (auto& current : blocks)
+            current.ranges.reset(current.ranges.get_capacity());
+    }
+
+    void buffer_allocator::flush(buffer_range const& range) {
+        if (!range.valid() || (range.block >= blocks.size()))
+            return;
+
+        blocks[range.block].buffer->flush(range.offset, range.size);
+    }
+
+    VkDeviceSize buffer_allocator::get_used() const {
+        VkDeviceSize result = 0;
+        for (auto& current : blocks)
+            result += current.ranges.get_used();
+
+        return result;
+    }
+
+} // namespace lava
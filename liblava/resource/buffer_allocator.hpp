@@ -0,0 +1,160 @@
+// file      : liblava/resource/buffer_allocator.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <deque>
+#include <liblava/resource/buffer.hpp>
+#include <optional>
+
+namespace lava {
+
+    // offsets within a fixed capacity, first fit, freed ranges are merged
+    struct range_allocator {
+        void reset(VkDeviceSize capacity);
+
+        std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment = 1);
+        void free(VkDeviceSize offset, VkDeviceSize size);
+
+        VkDeviceSize get_capacity() const {
+            return capacity;
+        }
+        VkDeviceSize get_used() const {
+            return used;
+        }
+
+        // count of free ranges, 1 when unfragmented
+        size_t get_free_range_count() const {
+            return free_ranges.size();
+        }
+
+    private:
+        VkDeviceSize capacity = 0;
+        VkDeviceSize used = 0;
+
+        // offset, size
+        std::map<VkDeviceSize, VkDeviceSize> free_ranges;
+    };
+
+    // offsets in a fixed capacity that are freed in allocation order, e.g. per frame
+    struct ring_allocator {
+        void reset(VkDeviceSize capacity);
+
+        std::optional<VkDeviceSize> allocate(VkDeviceSize size, VkDeviceSize alignment = 1);
+
+        // allocations since the last mark are freed by retire(serial)
+        void mark(ui64 serial);
+
+        // all marks up to serial are done
+        void retire(ui64 serial);
+
+        VkDeviceSize get_capacity() const {
+            return capacity;
+        }
+
+        // space between tail and head is in use
+        VkDeviceSize get_head() const {
+            return head;
+        }
+        VkDeviceSize get_tail() const {
+            return tail;
+        }
+
+        size_t get_pending_count() const {
+            return marks.size();
+        }
+
+    private:
+        VkDeviceSize capacity = 0;
+        VkDeviceSize head = 0;
+        VkDeviceSize tail = 0;
+
+        struct ring_mark {
+            ui64 serial = 0;
+            VkDeviceSize end = 0;
+        };
+
+        std::deque<ring_mark> marks;
+    };
+
+    struct buffer_range {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        index block = no_index;
+
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+
+        // nullptr for gpu only memory
+        void* mapped = nullptr;
+
+        VkDescriptorBufferInfo descriptor = {};
+
+        bool valid() const {
+            return buffer != VK_NULL_HANDLE;
+        }
+
+        VkDescriptorBufferInfo const* get_descriptor_info() const {
+            return &descriptor;
+        }
+
+        void* get_mapped_data() const {
+            return mapped;
+        }
+    };
+
+    // small uniform and storage ranges out of a few big buffers
+    struct buffer_allocator {
+        ~buffer_allocator() {
+            destroy();
+        }
+
+        // offsets follow the min offset alignment of the usage
+        bool create(device_ptr device, VkBufferUsageFlags usage, VkDeviceSize block_size = 1024 * 1024,
+                    VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_CPU_TO_GPU);
+        void destroy();
+
+        // invalid range when out of memory, bigger ranges get a block of their own
+        buffer_range allocate(VkDeviceSize size);
+        buffer_range allocate(void const* data, VkDeviceSize size);
+
+        void free(buffer_range& range);
+
+        // drops all ranges, blocks are kept
+        void reset();
+
+        void flush(buffer_range const& range);
+
+        VkDeviceSize get_alignment() const {
+            return alignment;
+        }
+
+        size_t get_block_count() const {
+            return blocks.size();
+        }
+
+        VkDeviceSize get_used() const;
+
+        buffer::ptr get_block(index block) const {
+            return blocks.at(block).buffer;
+        }
+
+    private:
+        struct block {
+            buffer::ptr buffer;
+            range_allocator ranges;
+        };
+
+        bool add_block(VkDeviceSize size);
+
+        device_ptr device = nullptr;
+
+        VkBufferUsageFlags usage = 0;
+        VkDeviceSize block_size = 0;
+        VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_UNKNOWN;
+        VkDeviceSize alignment = 1;
+
+        std::vector<block> blocks;
+    };
+
+} // namespace lava
@@ -0,0 +1,548 @@
+// file      : liblava/resource/defragmenter.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/resource/defragmenter.hpp>
+
+namespace lava {
+
+    bool defragmenter::create(device_ptr d, index fc) {
+        device = d;
+        frame_count = fc;
+
+        if (frame_count == 0) {
+            log()->error("create defragmenter - invalid frame count");
+            return false;
+        }
+
+        serial = 0;
+        totals = {};
+
+        return true;
+    }
+
+    void defragmenter::destroy() {
+        if (!device)
+            return;
+
+        if (pass_pending) {
+            device->wait_for_idle();
+
+            destroy_retired();
+            pass_pending = false;
+
+            vmaEndDefragmentationPass(device->alloc(), context);
+        }
+
+        if (context)
+            end_context();
+
+        entries.clear();
+        active = false;
+
+        device = nullptr;
+    }
+
+    bool defragmenter::movable(VmaAllocation allocation) const {
+        if (!allocation)
+            return false;
+
+        VmaAllocationInfo info{};
+        vmaGetAllocationInfo(device->alloc(), allocation, &info);
+
+        VkMemoryPropertyFlags flags = 0;
+        vmaGetMemoryTypeProperties(device->alloc(), info.memoryType, &flags);
+
+        // mapped memory would change under the host
+        return !(flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    }
+
+    bool defragmenter::add(buffer::ptr buffer, moved_func on_moved) {
+        if (!device || !buffer || !buffer->valid())
+            return false;
+
+        if ((buffer->get_usage() & defragment_buffer_usage) != defragment_buffer_usage) {
+            log()->error("defragmenter - buffer {} without transfer usage", buffer->get_id().value);
+            return false;
+        }
+
+        if (!movable(buffer->get_allocation())) {
+            log()->error("defragmenter - buffer {} not in device memory", buffer->get_id().value);
+            return false;
+        }
+
+        entry item;
+        item.buffer = buffer;
+        item.on_moved = on_moved;
+
+        entries[buffer->get_id()] = item;
+        return true;
+    }
+
+    bool defragmenter::add(image::ptr image, VkImageLayout layout, moved_func on_moved) {
+        if (!device || !image || !image->get())
+            return false;
+
+        if ((image->get_info().usage & defragment_image_usage) != defragment_image_usage) {
+            log()->error("defragmenter - image {} without transfer usage", image->get_id().value);
+            return false;
+        }
+
+        if (!movable(image->get_allocation())) {
+            log()->error("defragmenter - image {} not in device memory", image->get_id().value);
+            return false;
+        }
+
+        entry item;
+        item.image = image;
+        item.layout = layout;
+        item.on_moved = on_moved;
+
+        entries[image->get_id()] = item;
+        return true;
+    }
+
+    bool defragmenter::add(texture::ptr texture, moved_func on_moved) {
+        if (!texture || !texture->get_image())
+            return false;
+
+        if (!add(texture->get_image(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, on_moved))
+            return false;
+
+        // kept by texture, the descriptor follows the view
+        auto item = entries.at(texture->get_image()->get_id());
+        entries.erase(texture->get_image()->get_id());
+
+        item.image.reset();
+        item.texture = texture;
+
+        entries[texture->get_id()] = item;
+        return true;
+    }
+
+    void defragmenter::remove(id::ref id) {
+        entries.erase(id);
+    }
+
+    bool defragmenter::process(VkCommandBuffer cmd_buf) {
+        if (!device)
+            return false;
+
+        ++serial;
+
+        // a full round of frames later all frames recorded with the old handles are done
+        if (pass_pending) {
+            if (serial < pass_serial + frame_count)
+                return true;
+
+            destroy_retired();
+            pass_pending = false;
+
+            if (!end_pass())
+                return false;
+        }
+
+        if (!active && (auto_start_ratio > 0.f) && (auto_start_interval > 0) && (serial % auto_start_interval == 0)) {
+            auto const memory = device->get_memory_stats();
+            auto const allocated = memory.used_bytes + memory.unused_bytes;
+
+            if ((allocated > 0) && (r32(memory.unused_bytes) / allocated > auto_start_ratio))
+                start();
+        }
+
+        if (!active && !context)
+            return true;
+
+        if (!context) {
+            if (!begin_context()) {
+                stop();
+                return false;
+            }
+
+            if (!context)
+                return true;
+        }
+
+        std::vector<VmaDefragmentationPassMoveInfo> moves(step_moves);
+
+        VmaDefragmentationPassInfo pass_info{
+            .moveCount = to_ui32(moves.size()),
+            .pMoves = moves.data(),
+        };
+
+        if (failed(vmaBeginDefragmentationPass(device->alloc(), context, &pass_info))) {
+            log()->error("defragmenter - begin pass");
+
+            end_context();
+            stop();
+            return false;
+        }
+
+        moves.resize(pass_info.moveCount);
+
+        if (moves.empty())
+            return end_pass();
+
+        if (!record_moves(cmd_buf, moves)) {
+            // nothing was relocated, the context is dropped without ending the pass
+            device->wait_for_idle();
+
+            end_context();
+            stop();
+            return false;
+        }
+
+        pass_pending = true;
+        pass_serial = serial;
+
+        ++totals.steps;
+
+        return true;
+    }
+
+    bool defragmenter::begin_context() {
+        targets.clear();
+
+        std::vector<VmaAllocation> allocations;
+
+        for (auto it = entries.begin(); it != entries.end();) {
+            auto const& item = it->second;
+
+            target current;
+            current.layout = item.layout;
+            current.on_moved = item.on_moved;
+
+            VmaAllocation allocation = nullptr;
+
+            if (auto buffer = item.buffer.lock()) {
+                if (buffer->valid())
+                    allocation = buffer->get_allocation();
+
+                current.buffer = buffer;
+            } else if (auto texture = item.texture.lock()) {
+                current.texture = texture;
+                current.image = texture->get_image();
+            } else if (auto image = item.image.lock()) {
+                current.image = image;
+            } else {
+                it = entries.erase(it);
+                continue;
+            }
+
+            if (current.image && current.image->get())
+                allocation = current.image->get_allocation();
+
+            if (movable(allocation)) {
+                allocations.push_back(allocation);
+                targets.emplace(allocation, current);
+            }
+
+            ++it;
+        }
+
+        if (allocations.empty()) {
+            stop();
+            return true;
+        }
+
+        VmaDefragmentationInfo2 const info{
+            .flags = VMA_DEFRAGMENTATION_FLAG_INCREMENTAL,
+            .allocationCount = to_ui32(allocations.size()),
+            .pAllocations = allocations.data(),
+            .pAllocationsChanged = nullptr,
+            .poolCount = 0,
+            .pPools = nullptr,
+            .maxCpuBytesToMove = 0,
+            .maxCpuAllocationsToMove = 0,
+            .maxGpuBytesToMove = step_bytes,
+            .maxGpuAllocationsToMove = step_moves,
+            .commandBuffer = VK_NULL_HANDLE,
+        };
+
+        context_stats = {};
+
+        auto const result = vmaDefragmentationBegin(device->alloc(), &info, &context_stats, &context);
+        if ((result != VK_SUCCESS) && (result != VK_NOT_READY)) {
+            log()->error("defragmenter - begin context ({})", str(to_string(result)));
+
+            context = VK_NULL_HANDLE;
+            targets.clear();
+            return false;
+        }
+
+        // nothing to do
+        if (!context) {
+            targets.clear();
+            stop();
+        }
+
+        return true;
+    }
+
+    void defragmenter::end_context() {
+        vmaDefragmentationEnd(device->alloc(), context);
+        context = VK_NULL_HANDLE;
+
+        totals.bytes_moved += context_stats.bytesMoved;
+        totals.bytes_freed += context_stats.bytesFreed;
+        totals.allocations_moved += context_stats.allocationsMoved;
+        totals.blocks_freed += context_stats.deviceMemoryBlocksFreed;
+
+        // compact as far as it gets
+        if (context_stats.allocationsMoved == 0)
+            stop();
+
+        targets.clear();
+    }
+
+    bool defragmenter::end_pass() {
+        auto const result = vmaEndDefragmentationPass(device->alloc(), context);
+
+        // more passes in this context
+        if (result == VK_NOT_READY)
+            return true;
+
+        end_context();
+
+        if (failed(result)) {
+            log()->error("defragmenter - end pass ({})", str(to_string(result)));
+            stop();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool defragmenter::record_moves(VkCommandBuffer cmd_buf, std::vector<VmaDefragmentationPassMoveInfo> const& moves) {
+        struct copy {
+            target* current = nullptr;
+
+            VkBuffer src_buffer = VK_NULL_HANDLE;
+            VkBuffer dst_buffer = VK_NULL_HANDLE;
+
+            VkImage src_image = VK_NULL_HANDLE;
+            VkImage dst_image = VK_NULL_HANDLE;
+            VkImageView dst_view = VK_NULL_HANDLE;
+
+            VmaDefragmentationPassMoveInfo const* move = nullptr;
+        };
+
+        std::vector<copy> copies;
+
+        auto destroy_copies = [&]() {
+            for (auto const& item : copies) {
+                if (item.dst_view)
+                    device->vkDestroyImageView(item.dst_view);
+
+                if (item.dst_image)
+                    device->call().vkDestroyImage(device->get(), item.dst_image, memory::alloc());
+
+                if (item.dst_buffer)
+                    device->call().vkDestroyBuffer(device->get(), item.dst_buffer, memory::alloc());
+            }
+        };
+
+        // vma frees the old place at the end of the pass, every move has to be carried out:
+        // all new handles are created before any resource is relocated
+        for (auto const& move : moves) {
+            auto it = targets.find(move.allocation);
+            if (it == targets.end()) {
+                log()->error("defragmenter - unknown allocation moved");
+                destroy_copies();
+                return false;
+            }
+
+            auto& current = it->second;
+
+            copy item;
+            item.current = &current;
+            item.move = &move;
+
+            if (current.buffer) {
+                VkBufferCreateInfo const create_info{
+                    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                    .size = current.buffer->get_descriptor_info()->range,
+                    .usage = current.buffer->get_usage(),
+                    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                };
+
+                auto const created = !failed(device->call().vkCreateBuffer(device->get(), &create_info, memory::alloc(), &item.dst_buffer));
+                copies.push_back(item);
+
+                if (!created || failed(device->call().vkBindBufferMemory(device->get(), item.dst_buffer, move.memory, move.offset))) {
+                    log()->error("defragmenter - create moved buffer");
+                    destroy_copies();
+                    return false;
+                }
+            } else {
+                auto create_info = current.image->get_info();
+                create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+                auto const created = !failed(device->call().vkCreateImage(device->get(), &create_info, memory::alloc(), &item.dst_image));
+                copies.push_back(item);
+
+                if (!created || failed(device->call().vkBindImageMemory(device->get(), item.dst_image, move.memory, move.offset))) {
+                    log()->error("defragmenter - create moved image");
+                    destroy_copies();
+                    return false;
+                }
+
+                auto view_info = current.image->get_view_info();
+                view_info.image = item.dst_image;
+
+                if (!device->vkCreateImageView(&view_info, &copies.back().dst_view)) {
+                    log()->error("defragmenter - create moved image view");
+                    destroy_copies();
+                    return false;
+                }
+            }
+        }
+
+        for (auto& item : copies) {
+            auto& current = *item.current;
+
+            if (current.buffer) {
+                item.src_buffer = current.buffer->relocate(item.dst_buffer, item.move->memory, item.move->offset);
+                retired_handles.push_back({ .buffer = item.src_buffer });
+            } else {
+                retired old;
+                current.image->relocate(item.dst_image, item.dst_view, old.image, old.view);
+
+                item.src_image = old.image;
+                retired_handles.push_back(old);
+            }
+        }
+
+        // waits for everything submitted before, frames in flight may still read the old place
+        VkMemoryBarrier const begin_memory_barrier{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+        };
+
+        VkMemoryBarrier const end_memory_barrier{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+        };
+
+        std::vector<VkImageMemoryBarrier> begin_barriers;
+        std::vector<VkImageMemoryBarrier> end_barriers;
+
+        for (auto const& item : copies) {
+            if (!item.src_image)
+                continue;
+
+            auto const& current = *item.current;
+
+            VkImageMemoryBarrier barrier{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = current.image->get_subresource_range(),
+            };
+
+            barrier.image = item.src_image;
+            barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barrier.oldLayout = current.layout;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            begin_barriers.push_back(barrier);
+
+            barrier.image = item.dst_image;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            begin_barriers.push_back(barrier);
+
+            // the old image is not used after this frame, only the new one returns to its layout
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = current.layout;
+            end_barriers.push_back(barrier);
+        }
+
+        device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                            1, &begin_memory_barrier, 0, nullptr,
+                                            to_ui32(begin_barriers.size()), begin_barriers.data());
+
+        for (auto const& item : copies) {
+            auto const& current = *item.current;
+
+            if (item.src_buffer) {
+                VkBufferCopy const region{
+                    .size = current.buffer->get_descriptor_info()->range,
+                };
+
+                device->call().vkCmdCopyBuffer(cmd_buf, item.src_buffer, item.dst_buffer, 1, &region);
+                continue;
+            }
+
+            auto const& info = current.image->get_info();
+            auto const& range = current.image->get_subresource_range();
+
+            std::vector<VkImageCopy> regions;
+            for (auto level = 0u; level < info.mipLevels; ++level) {
+                VkImageSubresourceLayers const subresource{
+                    .aspectMask = range.aspectMask,
+                    .mipLevel = level,
+                    .baseArrayLayer = 0,
+                    .layerCount = info.arrayLayers,
+                };
+
+                regions.push_back({
+                    .srcSubresource = subresource,
+                    .srcOffset = {},
+                    .dstSubresource = subresource,
+                    .dstOffset = {},
+                    .extent = {
+                        std::max(info.extent.width >> level, 1u),
+                        std::max(info.extent.height >> level, 1u),
+                        std::max(info.extent.depth >> level, 1u),
+                    },
+                });
+            }
+
+            device->call().vkCmdCopyImage(cmd_buf, item.src_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                          item.dst_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                          to_ui32(regions.size()), regions.data());
+        }
+
+        device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                                            1, &end_memory_barrier, 0, nullptr,
+                                            to_ui32(end_barriers.size()), end_barriers.data());
+
+        for (auto const& item : copies) {
+            auto const& current = *item.current;
+
+            if (current.texture)
+                current.texture->update_descriptor();
+
+            if (current.on_moved)
+                current.on_moved();
+        }
+
+        if (on_moved)
+            on_moved();
+
+        return true;
+    }
+
+    void defragmenter::destroy_retired() {
+        for (auto& handles : retired_handles) {
+            if (handles.view)
+                device->vkDestroyImageView(handles.view);
+
+            if (handles.image)
+                device->call().vkDestroyImage(device->get(), handles.image, memory::alloc());
+
+            if (handles.buffer)
+                device->call().vkDestroyBuffer(device->get(), handles.buffer, memory::alloc());
+        }
+
+        retired_handles.clear();
+    }
+
+} // namespace lava
@@ -0,0 +1,148 @@
+// file      : liblava/resource/defragmenter.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/resource/texture.hpp>
+
+namespace lava {
+
+    // resources must be created with it to be moved
+    constexpr VkBufferUsageFlags const defragment_buffer_usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    constexpr VkImageUsageFlags const defragment_image_usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    // incremental compaction of device local memory, a bounded step of moves per frame
+    struct defragmenter : id_obj {
+        using ptr = std::shared_ptr<defragmenter>;
+
+        // called when the resource got new handles, descriptors written with the old ones must be updated
+        using moved_func = std::function<void()>;
+
+        struct stats {
+            ui64 bytes_moved = 0;
+            ui64 bytes_freed = 0;
+            ui32 allocations_moved = 0;
+            ui32 blocks_freed = 0;
+            ui32 steps = 0;
+        };
+
+        ~defragmenter() {
+            destroy();
+        }
+
+        bool create(device_ptr device, index frame_count);
+        void destroy();
+
+        // after each step that moved resources, recordings with the old handles must be redone
+        moved_func on_moved;
+
+        // gpu only resources with transfer src and dst usage, not written on the gpu after upload
+        bool add(buffer::ptr buffer, moved_func on_moved = {});
+        bool add(image::ptr image, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, moved_func on_moved = {});
+        bool add(texture::ptr texture, moved_func on_moved = {});
+
+        // by the id of the added resource
+        void remove(id::ref id);
+
+        // once per frame, copies are recorded before the resources are used,
+        // old handles are destroyed when all frames in flight are done with them
+        bool process(VkCommandBuffer cmd_buf);
+
+        // runs until a step finds nothing to move
+        void start() {
+            active = true;
+        }
+        void stop() {
+            active = false;
+        }
+        bool running() const {
+            return active || (context != VK_NULL_HANDLE);
+        }
+
+        // upper bounds of a step
+        void set_step_budget(VkDeviceSize bytes, ui32 moves) {
+            step_bytes = bytes;
+            step_moves = moves;
+        }
+
+        // starts when the unused share of allocated device memory exceeds ratio (0 = off),
+        // checked every interval frames
+        void set_auto_start(r32 ratio, ui32 interval = 600) {
+            auto_start_ratio = ratio;
+            auto_start_interval = interval;
+        }
+
+        stats const& get_stats() const {
+            return totals;
+        }
+
+        size_t get_resource_count() const {
+            return entries.size();
+        }
+
+    private:
+        struct entry {
+            std::weak_ptr<lava::buffer> buffer;
+            std::weak_ptr<lava::image> image;
+            std::weak_ptr<lava::texture> texture;
+
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            moved_func on_moved;
+        };
+
+        // resources of the running context stay alive until it ends
+        struct target {
+            lava::buffer::ptr buffer;
+            lava::image::ptr image;
+            lava::texture::ptr texture;
+
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            moved_func on_moved;
+        };
+
+        struct retired {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            VkImage image = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+        };
+
+        bool movable(VmaAllocation allocation) const;
+
+        bool begin_context();
+        void end_context();
+        bool end_pass();
+
+        bool record_moves(VkCommandBuffer cmd_buf, std::vector<VmaDefragmentationPassMoveInfo> const& moves);
+        void destroy_retired();
+
+        device_ptr device = nullptr;
+        index frame_count = 0;
+
+        std::map<id, entry> entries;
+
+        bool active = false;
+        VkDeviceSize step_bytes = 16 * 1024 * 1024;
+        ui32 step_moves = 64;
+
+        r32 auto_start_ratio = 0.f;
+        ui32 auto_start_interval = 600;
+
+        VmaDefragmentationContext context = VK_NULL_HANDLE;
+        VmaDefragmentationStats context_stats = {};
+        std::map<VmaAllocation, target> targets;
+
+        // pass recorded, waiting for frames in flight
+        bool pass_pending = false;
+        ui64 pass_serial = 0;
+        std::vector<retired> retired_handles;
+
+        ui64 serial = 0;
+        stats totals;
+    };
+
+    inline defragmenter::ptr make_defragmenter() {
+        return std::make_shared<defragmenter>();
+    }
+
+} // namespace lava
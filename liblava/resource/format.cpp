@@ -403,6 +403,17 @@ lava::VkFormat_optional lava::get_supported_format(VkPhysicalDevice physical_dev
     return std::nullopt;
 }
 
+lava::VkFormat_optional lava::get_supported_compressed_format(VkPhysicalDevice physical_device, bool srgb) {
+    VkFormats const formats = srgb ? VkFormats{ VK_FORMAT_BC7_SRGB_BLOCK,
+                                                VK_FORMAT_ASTC_4x4_SRGB_BLOCK,
+                                                VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK }
+                                   : VkFormats{ VK_FORMAT_BC7_UNORM_BLOCK,
+                                                VK_FORMAT_ASTC_4x4_UNORM_BLOCK,
+                                                VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK };
+
+    return get_supported_format(physical_device, formats, VK_IMAGE_USAGE_SAMPLED_BIT);
+}
+
 VkImageMemoryBarrier lava::image_memory_barrier(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout) {
     return {
         .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
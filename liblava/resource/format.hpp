@@ -33,6 +33,9 @@ namespace lava {
 
     VkFormat_optional get_supported_format(VkPhysicalDevice physical_device, VkFormats const& possible_formats, VkImageUsageFlags usage);
 
+    // sampled rgba block format (bc7, astc 4x4, etc2) for transcoding
+    VkFormat_optional get_supported_compressed_format(VkPhysicalDevice physical_device, bool srgb = true);
+
     VkImageMemoryBarrier image_memory_barrier(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout);
 
     void set_image_layout(device_ptr device, VkCommandBuffer cmd_buffer, VkImage image, VkImageLayout old_image_layout,
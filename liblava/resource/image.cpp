@@ -52,15 +52,24 @@ namespace lava {
 
         info.extent = { size.x, size.y, 1 };
 
+        if (mip_levels_generation)
+            set_level_count(mip_level_count(size));
+
         if (!vk_image) {
             VmaAllocationCreateInfo create_info{
                 .usage = memory_usage,
             };
 
-            if (failed(vmaCreateImage(device->alloc(), &info, &create_info, &vk_image, &allocation, nullptr))) {
+            VmaAllocationInfo allocation_info{};
+            if (failed(vmaCreateImage(device->alloc(), &info, &create_info, &vk_image, &allocation, &allocation_info))) {
                 log()->error("create image");
                 return false;
             }
+
+            memory_size = allocation_info.size;
+
+            if (auto allocator = device->get_allocator())
+                allocator->track(tag, memory_size);
         }
 
         view_info.image = vk_image;
@@ -79,6 +88,10 @@ namespace lava {
             return;
 
         if (vk_image) {
+            if (allocation)
+                if (auto allocator = device->get_allocator())
+                    allocator->untrack(tag, memory_size);
+
             vmaDestroyImage(device->alloc(), vk_image, allocation);
             vk_image = 0;
             allocation = nullptr;
@@ -87,6 +100,15 @@ namespace lava {
         device = nullptr;
     }
 
+    void image::relocate(VkImage new_image, VkImageView new_view, VkImage& old_image, VkImageView& old_view) {
+        old_image = vk_image;
+        old_view = view;
+
+        vk_image = new_image;
+        view = new_view;
+        view_info.image = new_image;
+    }
+
     image::ptr make_image(VkFormat format, VkImage vk_image) {
         return std::make_shared<image>(format, vk_image);
     }
@@ -8,6 +8,14 @@
 
 namespace lava {
 
+    inline ui32 mip_level_count(uv2 size) {
+        auto result = 1u;
+        for (auto dim = std::max(size.x, size.y); dim > 1; dim >>= 1)
+            ++result;
+
+        return result;
+    }
+
     struct image : id_obj {
         using ptr = std::shared_ptr<image>;
         using map = std::map<id, ptr>;
@@ -42,6 +50,14 @@ namespace lava {
             return view;
         }
 
+        VmaAllocation get_allocation() const {
+            return allocation;
+        }
+
+        // image bound to moved memory with a view created from get_view_info(),
+        // old handles are returned to be destroyed once unused
+        void relocate(VkImage new_image, VkImageView new_view, VkImage& old_image, VkImageView& old_view);
+
         VkImageCreateInfo const& get_info() const {
             return info;
         }
@@ -85,6 +101,14 @@ namespace lava {
             view_info.viewType = type;
         }
 
+        // memory stats accounting, before create
+        void set_memory_tag(memory_tag value) {
+            tag = value;
+        }
+        memory_tag get_memory_tag() const {
+            return tag;
+        }
+
     private:
         device_ptr device = nullptr;
 
@@ -92,6 +116,8 @@ namespace lava {
         VkImageCreateInfo info;
 
         VmaAllocation allocation = nullptr;
+        VkDeviceSize memory_size = 0;
+        memory_tag tag = memory_tag::none;
 
         VkImageView view = VK_NULL_HANDLE;
 
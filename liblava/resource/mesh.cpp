@@ -2,6 +2,7 @@
 // copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
 // license   : MIT; see accompanying LICENSE file
 
+#include <liblava/resource/defragmenter.hpp>
 #include <liblava/resource/mesh.hpp>
 
 namespace lava {
@@ -22,8 +23,9 @@ namespace lava {
 
         if (!data.vertices.empty()) {
             vertex_buffer = make_buffer();
+            vertex_buffer->set_memory_tag(memory_tag::mesh);
 
-            if (!vertex_buffer->create(device, data.vertices.data(), sizeof(vertex) * data.vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, mapped, memory_usage)) {
+            if (!vertex_buffer->create(device, data.vertices.data(), sizeof(vertex) * data.vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | defragment_buffer_usage, mapped, memory_usage)) {
                 log()->error("create mesh vertex buffer");
                 return false;
             }
@@ -31,8 +33,9 @@ namespace lava {
 
         if (!data.indices.empty()) {
             index_buffer = make_buffer();
+            index_buffer->set_memory_tag(memory_tag::mesh);
 
-            if (!index_buffer->create(device, data.indices.data(), sizeof(ui32) * data.indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mapped, memory_usage)) {
+            if (!index_buffer->create(device, data.indices.data(), sizeof(ui32) * data.indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | defragment_buffer_usage, mapped, memory_usage)) {
                 log()->error("create mesh index buffer");
                 return false;
             }
@@ -0,0 +1,269 @@
+// file      : liblava/resource/mip_map.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <array>
+#include <cmath>
+#include <liblava/resource/format.hpp>
+#include <liblava/resource/mip_map.hpp>
+
+namespace lava {
+
+    bool mip_levels_supported(device_ptr device, VkFormat format) {
+        VkFormatProperties format_props;
+        vkGetPhysicalDeviceFormatProperties(device->get_vk_physical_device(), format, &format_props);
+
+        VkFormatFeatureFlags const features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT
+                                              | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+        return (format_props.optimalTilingFeatures & features) == features;
+    }
+
+    void generate_mip_levels(device_ptr device, VkCommandBuffer cmd_buf, image::ptr image,
+                             VkImageLayout final_layout, VkPipelineStageFlags dst_stage) {
+        auto range = image->get_subresource_range();
+        auto const level_count = range.levelCount;
+
+        range.levelCount = 1;
+
+        auto const dst_access = final_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ? VK_ACCESS_SHADER_READ_BIT
+                                                                                         : VK_ACCESS_MEMORY_READ_BIT;
+
+        auto size = image->get_size();
+
+        for (auto level = 1u; level < level_count; ++level) {
+            range.baseMipLevel = level - 1;
+
+            insert_image_memory_barrier(device, cmd_buf, image->get(),
+                                        VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, range);
+
+            auto const next_size = uv2(std::max(size.x >> 1, 1u), std::max(size.y >> 1, 1u));
+
+            VkImageBlit const blit{
+                .srcSubresource = {
+                    .aspectMask = range.aspectMask,
+                    .mipLevel = level - 1,
+                    .baseArrayLayer = range.baseArrayLayer,
+                    .layerCount = range.layerCount,
+                },
+                .srcOffsets = { {}, { to_i32(size.x), to_i32(size.y), 1 } },
+                .dstSubresource = {
+                    .aspectMask = range.aspectMask,
+                    .mipLevel = level,
+                    .baseArrayLayer = range.baseArrayLayer,
+                    .layerCount = range.layerCount,
+                },
+                .dstOffsets = { {}, { to_i32(next_size.x), to_i32(next_size.y), 1 } },
+            };
+
+            device->call().vkCmdBlitImage(cmd_buf, image->get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                          image->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+            insert_image_memory_barrier(device, cmd_buf, image->get(),
+                                        VK_ACCESS_TRANSFER_READ_BIT, dst_access,
+                                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, final_layout,
+                                        VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage, range);
+
+            size = next_size;
+        }
+
+        range.baseMipLevel = level_count - 1;
+
+        insert_image_memory_barrier(device, cmd_buf, image->get(),
+                                    VK_ACCESS_TRANSFER_WRITE_BIT, dst_access,
+                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, final_layout,
+                                    VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage, range);
+    }
+
+    // taps start at 2 * x + first of the source level
+    struct mip_kernel {
+        i32 first = 0;
+        std::vector<r32> weights;
+    };
+
+    r64 mip_bessel_i0(r64 x) {
+        r64 result = 1.0;
+        r64 term = 1.0;
+
+        for (auto k = 1; k < 32; ++k) {
+            term *= (x * 0.5 / k) * (x * 0.5 / k);
+            result += term;
+
+            if (term < result * 1e-12)
+                break;
+        }
+
+        return result;
+    }
+
+    mip_kernel make_mip_kernel(mip_filter filter) {
+        if (filter == mip_filter::box)
+            return { 0, { 0.5f, 0.5f } };
+
+        // windowed sinc, 3 destination texels wide
+        auto const radius = 3.0;
+        auto const alpha = 4.0;
+        auto const pi = 3.14159265358979323846;
+
+        mip_kernel result;
+        result.first = -2 * to_i32(radius) + 1;
+
+        auto sum = 0.0;
+        std::vector<r64> weights;
+
+        for (auto k = result.first; k <= 2 * to_i32(radius); ++k) {
+            auto const t = (k - 0.5) * 0.5;
+
+            auto const sinc = t == 0.0 ? 1.0 : std::sin(pi * t) / (pi * t);
+
+            auto const w = t / radius;
+            auto const window = std::abs(w) >= 1.0 ? 0.0 : mip_bessel_i0(alpha * std::sqrt(1.0 - w * w)) / mip_bessel_i0(alpha);
+
+            weights.push_back(sinc * window);
+            sum += sinc * window;
+        }
+
+        for (auto weight : weights)
+            result.weights.push_back(to_r32(weight / sum));
+
+        return result;
+    }
+
+    // separable, one axis at a time
+    void mip_downsample(std::vector<r32> const& source, uv2 source_size, std::vector<r32>& result, uv2 result_size,
+                        ui32 channels, mip_kernel const& kernel) {
+        std::vector<r32> temp(result_size.x * source_size.y * channels, 0.f);
+
+        auto const taps = to_i32(kernel.weights.size());
+
+        for (auto y = 0u; y < source_size.y; ++y) {
+            auto const src_row = source.data() + y * source_size.x * channels;
+            auto dst_row = temp.data() + y * result_size.x * channels;
+
+            for (auto x = 0u; x < result_size.x; ++x) {
+                auto dst = dst_row + x * channels;
+
+                if (source_size.x == result_size.x) {
+                    std::copy_n(src_row + x * channels, channels, dst);
+                    continue;
+                }
+
+                for (auto t = 0; t < taps; ++t) {
+                    auto const sx = std::clamp(to_i32(2 * x) + kernel.first + t, 0, to_i32(source_size.x) - 1);
+                    auto const src = src_row + sx * channels;
+                    auto const weight = kernel.weights[t];
+
+                    for (auto c = 0u; c < channels; ++c)
+                        dst[c] += src[c] * weight;
+                }
+            }
+        }
+
+        auto const row_size = result_size.x * channels;
+
+        result.assign(row_size * result_size.y, 0.f);
+
+        for (auto y = 0u; y < result_size.y; ++y) {
+            auto dst_row = result.data() + y * row_size;
+
+            if (source_size.y == result_size.y) {
+                std::copy_n(temp.data() + y * row_size, row_size, dst_row);
+                continue;
+            }
+
+            for (auto t = 0; t < taps; ++t) {
+                auto const sy = std::clamp(to_i32(2 * y) + kernel.first + t, 0, to_i32(source_size.y) - 1);
+                auto const src_row = temp.data() + sy * row_size;
+                auto const weight = kernel.weights[t];
+
+                for (auto i = 0u; i < row_size; ++i)
+                    dst_row[i] += src_row[i] * weight;
+            }
+        }
+    }
+
+    inline r32 srgb_to_linear(r32 value) {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    inline r32 linear_to_srgb(r32 value) {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+    }
+
+    bool compute_mip_levels(cdata const& source, uv2 size, ui32 channels, unique_data& result,
+                            texture::mip_level::list& levels, mip_filter filter, bool srgb) {
+        if (!source.ptr || (channels == 0) || (size.x == 0) || (size.y == 0)) {
+            log()->error("compute mip levels - invalid source");
+            return false;
+        }
+
+        if (source.size < size_t(size.x) * size.y * channels) {
+            log()->error("compute mip levels - source size {} too small", source.size);
+            return false;
+        }
+
+        levels.clear();
+
+        auto const level_count = mip_level_count(size);
+        auto extent = size;
+
+        size_t total = 0;
+        for (auto level = 0u; level < level_count; ++level) {
+            texture::mip_level mip;
+            mip.extent = extent;
+            mip.size = extent.x * extent.y * channels;
+
+            levels.push_back(mip);
+            total += mip.size;
+
+            extent = uv2(std::max(extent.x >> 1, 1u), std::max(extent.y >> 1, 1u));
+        }
+
+        result.set(total);
+        if (!result.ptr) {
+            log()->error("compute mip levels - allocate {} bytes", total);
+            return false;
+        }
+
+        // alpha stays linear
+        auto const color_channels = (srgb && channels == 4) ? 3u : (srgb ? channels : 0u);
+
+        std::array<r32, 256> to_linear;
+        for (auto i = 0u; i < to_linear.size(); ++i)
+            to_linear[i] = srgb_to_linear(i / 255.f);
+
+        std::vector<r32> current(levels.front().size);
+        for (auto i = 0u; i < current.size(); ++i) {
+            auto const value = ui8(source.ptr[i]);
+            current[i] = (i % channels) < color_channels ? to_linear[value] : value / 255.f;
+        }
+
+        memcpy(result.ptr, source.ptr, levels.front().size);
+
+        auto const kernel = make_mip_kernel(filter);
+
+        std::vector<r32> next;
+        auto offset = size_t(levels.front().size);
+
+        for (auto level = 1u; level < level_count; ++level) {
+            mip_downsample(current, levels[level - 1].extent, next, levels[level].extent, channels, kernel);
+
+            auto dst = as_ptr(result.ptr + offset);
+            for (auto i = 0u; i < next.size(); ++i) {
+                auto value = std::clamp(next[i], 0.f, 1.f);
+                if ((i % channels) < color_channels)
+                    value = linear_to_srgb(value);
+
+                dst[i] = char(ui8(value * 255.f + 0.5f));
+            }
+
+            offset += levels[level].size;
+            current.swap(next);
+        }
+
+        return true;
+    }
+
+} // namespace lava
@@ -0,0 +1,27 @@
+// file      : liblava/resource/mip_map.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/resource/texture.hpp>
+
+namespace lava {
+
+    bool mip_levels_supported(device_ptr device, VkFormat format);
+
+    // all levels in transfer dst layout, level 0 filled
+    void generate_mip_levels(device_ptr device, VkCommandBuffer cmd_buf, image::ptr image,
+                             VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                             VkPipelineStageFlags dst_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+    enum class mip_filter : type {
+        box = 0,
+        kaiser
+    };
+
+    // offline chain for 8 bit texels, result holds all levels tightly packed (level 0 first)
+    bool compute_mip_levels(cdata const& source, uv2 size, ui32 channels, unique_data& result,
+                            texture::mip_level::list& levels, mip_filter filter = mip_filter::box, bool srgb = false);
+
+} // namespace lava
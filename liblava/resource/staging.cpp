@@ -0,0 +1,836 @@
+// file      : liblava/resource/staging.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/resource/format.hpp>
+#include <liblava/resource/mip_map.hpp>
+#include <liblava/resource/staging.hpp>
+#include <numeric>
+
+namespace lava {
+
+    // every stage that may sample an acquired image, tessellation and geometry need device features
+    constexpr VkPipelineStageFlags const acquire_stages = VK_PIPELINE_STAGE_TRANSFER_BIT
+                                                          | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+                                                          | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+                                                          | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+    bool staging::create(device_ptr d, VkDeviceSize capacity) {
+        device = d;
+
+        return create_ring(capacity);
+    }
+
+    bool staging::create_ring(VkDeviceSize capacity, index_list const& families) {
+        if (ring)
+            ring->destroy();
+
+        ring = make_buffer();
+        ring->set_memory_tag(memory_tag::staging);
+        ring->set_shared_families(families);
+
+        if (!ring->create_mapped(device, nullptr, capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY)) {
+            log()->error("create staging ring");
+            ring = nullptr;
+            return false;
+        }
+
+        ring_ranges.reset(ring->get_size());
+        frame_serials.clear();
+
+        return true;
+    }
+
+    void staging::destroy() {
+        clear();
+
+        destroy_transfer_frames();
+        transfer_queue = {};
+        transfer_timeline.destroy();
+
+        if (ring) {
+            ring->destroy();
+            ring = nullptr;
+        }
+
+        ring_ranges.reset(0);
+        frame_serials.clear();
+
+        device = nullptr;
+    }
+
+    void staging::clear() {
+        for (auto& item : todo)
+            if (item.on_staged)
+                item.on_staged(false);
+
+        for (auto& job : jobs)
+            if (job->on_staged)
+                job->on_staged(false);
+
+        todo.clear();
+        jobs.clear();
+    }
+
+    bool staging::set_transfer_queue(queue::ref target, index family) {
+        if (!target.valid() || (target.family == family)) {
+            log()->error("staging transfer queue - no separate queue family");
+            return false;
+        }
+
+        // a skipped frame never waits on its transfer, a binary semaphore would stay signaled
+        if (!device->timeline_semaphore_supported()) {
+            log()->error("staging transfer queue - no timeline semaphores");
+            return false;
+        }
+
+        if ((ring_ranges.get_pending_count() > 0) || !jobs.empty()) {
+            log()->error("staging transfer queue - set before staging");
+            return false;
+        }
+
+        destroy_transfer_frames();
+
+        if (!transfer_timeline.get() && !transfer_timeline.create(device))
+            return false;
+
+        // copies on the transfer queue, clears and banded copies on the frame queue
+        if (!create_ring(ring->get_size(), { target.family, family }))
+            return false;
+
+        transfer_queue = target;
+        dst_family = family;
+
+        transfer_granularity = device->get_physical_device()->get_queue_family_properties().at(target.family).minImageTransferGranularity;
+
+        return true;
+    }
+
+    void staging::destroy_transfer_frames() {
+        for (auto& [frame, transfer] : transfer_frames) {
+            transfer_timeline.wait(transfer.value);
+            device->vkDestroyCommandPool(transfer.pool);
+        }
+
+        transfer_frames.clear();
+        acquires.clear();
+
+        submitted_point = {};
+    }
+
+    VkCommandBuffer staging::begin_transfer(index frame) {
+        if (!transfer_frames.count(frame)) {
+            transfer_frame transfer;
+
+            if (!device->vkCreateCommandPool(transfer_queue.family, &transfer.pool)) {
+                log()->error("create staging transfer command pool");
+                return VK_NULL_HANDLE;
+            }
+
+            if (!device->vkAllocateCommandBuffers(transfer.pool, 1, &transfer.cmd_buf)) {
+                log()->error("create staging transfer frame");
+
+                device->vkDestroyCommandPool(transfer.pool);
+                return VK_NULL_HANDLE;
+            }
+
+            transfer_frames.emplace(frame, transfer);
+        }
+
+        auto& transfer = transfer_frames.at(frame);
+
+        if (failed(device->call().vkResetCommandPool(device->get(), transfer.pool, 0))) {
+            log()->error("staging reset transfer command pool");
+            return VK_NULL_HANDLE;
+        }
+
+        VkCommandBufferBeginInfo const begin_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        if (failed(device->call().vkBeginCommandBuffer(transfer.cmd_buf, &begin_info)))
+            return VK_NULL_HANDLE;
+
+        transfer_recorded = false;
+
+        return transfer.cmd_buf;
+    }
+
+    bool staging::submit_transfer(index frame, bool recorded) {
+        auto& transfer = transfer_frames.at(frame);
+
+        if (failed(device->call().vkEndCommandBuffer(transfer.cmd_buf)))
+            return false;
+
+        if (!recorded)
+            return true;
+
+        auto const point = transfer_timeline.get_point(transfer_timeline.next());
+
+        timeline_submit transfer_submit;
+        transfer_submit.add_signal(point);
+
+        VkCommandBuffers const cmd_buffers = { transfer.cmd_buf };
+        auto const submit_info = transfer_submit.get_submit_info(cmd_buffers);
+
+        if (!device->vkQueueSubmit(transfer_queue.vk_queue, 1, &submit_info, VK_NULL_HANDLE)) {
+            log()->error("staging submit transfer");
+
+            // the value is taken, waits on it and later values must not hang
+            transfer_timeline.signal(point.value);
+            return false;
+        }
+
+        transfer.value = point.value;
+        submitted_point = point;
+        return true;
+    }
+
+    staging::job::ptr staging::make_image_job(image::ptr image, VkImageLayout final_layout, texture::layer::list const& layers) {
+        auto result = std::make_shared<job>();
+        result->image = image;
+        result->final_layout = final_layout;
+        result->subresource_range = image->get_subresource_range();
+
+        auto const format = image->get_format();
+
+        ui32 block_width = 1;
+        ui32 block_height = 1;
+        format_block_dim(format, block_width, block_height);
+
+        auto const block_size = format_block_size(format);
+
+        VkDeviceSize offset = 0;
+
+        for (auto layer = 0u; layer < layers.size(); ++layer) {
+            for (auto level = 0u; level < layers[layer].levels.size(); ++level) {
+                auto const& mip = layers[layer].levels[level];
+
+                VkBufferImageCopy const region{
+                    .bufferOffset = offset,
+                    .imageSubresource = {
+                        .aspectMask = result->subresource_range.aspectMask,
+                        .mipLevel = level,
+                        .baseArrayLayer = layer,
+                        .layerCount = 1,
+                    },
+                    .imageOffset = {},
+                    .imageExtent = { mip.extent.x, mip.extent.y, 1 },
+                };
+
+                result->image_regions.push_back(region);
+
+                if (mip.size > 0)
+                    offset += mip.size;
+                else
+                    offset += VkDeviceSize(ceil_div(mip.extent.x, block_width)) * ceil_div(mip.extent.y, block_height) * block_size;
+            }
+        }
+
+        return result;
+    }
+
+    staging::job::ptr staging::make_texture_job(texture::ptr texture) {
+        if (!texture->generates_mip_levels()) {
+            auto result = make_image_job(texture->get_image(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, texture->get_layers());
+            result->texture = texture;
+            return result;
+        }
+
+        // only level 0 is uploaded
+        auto layers = texture->get_layers();
+        for (auto& layer : layers)
+            layer.levels.resize(1);
+
+        auto result = make_image_job(texture->get_image(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, layers);
+        result->texture = texture;
+        result->mip_levels_generation = true;
+        return result;
+    }
+
+    bool staging::add_job(job::ptr job, void const* data, size_t data_size) {
+        VkDeviceSize required = 0;
+
+        if (!job->image_regions.empty()) {
+            auto const format = job->image->get_format();
+
+            ui32 block_width = 1;
+            ui32 block_height = 1;
+            format_block_dim(format, block_width, block_height);
+
+            auto const& last = job->image_regions.back();
+            required = last.bufferOffset
+                       + VkDeviceSize(ceil_div(last.imageExtent.width, block_width))
+                             * ceil_div(last.imageExtent.height, block_height) * format_block_size(format);
+        } else {
+            for (auto& region : job->buffer_regions)
+                required = std::max(required, region.srcOffset + region.size);
+        }
+
+        if (data_size < required) {
+            log()->error("staging upload - data size {} is smaller than required {}", data_size, required);
+            return false;
+        }
+
+        if (data) {
+            job->storage.set(data_size);
+            if (!job->storage.ptr) {
+                log()->error("staging upload - allocate {} bytes", data_size);
+                return false;
+            }
+
+            memcpy(job->storage.ptr, data, data_size);
+            job->source = { job->storage.ptr, data_size };
+        }
+
+        jobs.push_back(job);
+        return true;
+    }
+
+    bool staging::upload(texture::ptr texture, void const* data, size_t data_size) {
+        auto image = texture->get_image();
+        if (!image) {
+            log()->error("staging upload - texture without image");
+            return false;
+        }
+
+        return add_job(make_texture_job(texture), data, data_size);
+    }
+
+    bool staging::upload(image::ptr image, void const* data, size_t data_size, VkImageLayout final_layout) {
+        texture::layer::list layers(image->get_subresource_range().layerCount);
+
+        for (auto& layer : layers) {
+            texture::mip_level level;
+            level.extent = image->get_size();
+
+            layer.levels.push_back(level);
+        }
+
+        return add_job(make_image_job(image, final_layout, layers), data, data_size);
+    }
+
+    bool staging::upload(buffer::ptr buffer, void const* data, size_t data_size, VkDeviceSize offset) {
+        if (offset + data_size > buffer->get_size()) {
+            log()->error("staging upload - buffer range exceeds size {}", buffer->get_size());
+            return false;
+        }
+
+        auto job = std::make_shared<staging::job>();
+        job->buffer = buffer;
+        job->buffer_regions.push_back({ .srcOffset = 0, .dstOffset = offset, .size = data_size });
+
+        return add_job(job, data, data_size);
+    }
+
+    bool staging::update(image::ptr image, update_region::list const& regions, void const* data, size_t data_size,
+                         VkImageLayout layout) {
+        if (regions.empty())
+            return true;
+
+        auto const format = image->get_format();
+
+        ui32 block_width = 1;
+        ui32 block_height = 1;
+        format_block_dim(format, block_width, block_height);
+
+        VkDeviceSize const block_size = format_block_size(format);
+
+        auto const& range = image->get_subresource_range();
+        auto const image_size = image->get_size();
+
+        auto job = std::make_shared<staging::job>();
+        job->image = image;
+        job->old_layout = layout;
+        job->final_layout = layout;
+        job->frame_queue = true;
+
+        auto min_level = range.levelCount;
+        auto max_level = 0u;
+        auto min_layer = range.layerCount;
+        auto max_layer = 0u;
+
+        VkDeviceSize offset = 0;
+
+        for (auto& region : regions) {
+            if ((region.level >= range.levelCount) || (region.layer >= range.layerCount)) {
+                log()->error("staging update - level {} layer {} out of range", region.level, region.layer);
+                return false;
+            }
+
+            uv2 const extent = { std::max(image_size.x >> region.level, 1u), std::max(image_size.y >> region.level, 1u) };
+
+            if ((region.offset.x + region.size.x > extent.x) || (region.offset.y + region.size.y > extent.y)) {
+                log()->error("staging update - region exceeds level {}", region.level);
+                return false;
+            }
+
+            // compressed blocks are never split
+            if ((region.offset.x % block_width) || (region.offset.y % block_height)
+                || ((region.size.x % block_width) && (region.offset.x + region.size.x != extent.x))
+                || ((region.size.y % block_height) && (region.offset.y + region.size.y != extent.y))) {
+                log()->error("staging update - region not aligned to {}x{} blocks", block_width, block_height);
+                return false;
+            }
+
+            job->image_regions.push_back({
+                .bufferOffset = offset,
+                .imageSubresource = {
+                    .aspectMask = range.aspectMask,
+                    .mipLevel = region.level,
+                    .baseArrayLayer = region.layer,
+                    .layerCount = 1,
+                },
+                .imageOffset = { to_i32(region.offset.x), to_i32(region.offset.y), 0 },
+                .imageExtent = { region.size.x, region.size.y, 1 },
+            });
+
+            offset += VkDeviceSize(ceil_div(region.size.x, block_width)) * ceil_div(region.size.y, block_height) * block_size;
+
+            min_level = std::min(min_level, region.level);
+            max_level = std::max(max_level, region.level);
+            min_layer = std::min(min_layer, region.layer);
+            max_layer = std::max(max_layer, region.layer);
+        }
+
+        job->subresource_range = range;
+        job->subresource_range.baseMipLevel = min_level;
+        job->subresource_range.levelCount = max_level - min_level + 1;
+        job->subresource_range.baseArrayLayer = min_layer;
+        job->subresource_range.layerCount = max_layer - min_layer + 1;
+
+        if (!jobs.empty()) {
+            auto& last = *jobs.back();
+
+            if ((last.image == image) && last.frame_queue && !last.clear && !last.started
+                && (last.old_layout == layout) && (last.final_layout == layout) && last.storage.ptr) {
+                if (data_size < offset) {
+                    log()->error("staging update - data size {} is smaller than required {}", data_size, offset);
+                    return false;
+                }
+
+                return merge_update(last, *job, data);
+            }
+        }
+
+        return add_job(job, data, data_size);
+    }
+
+    bool staging::merge_update(job& target, job const& next, void const* data) {
+        auto const& last_region = next.image_regions.back();
+
+        ui32 block_width = 1;
+        ui32 block_height = 1;
+        format_block_dim(target.image->get_format(), block_width, block_height);
+
+        auto const next_size = last_region.bufferOffset
+                               + VkDeviceSize(ceil_div(last_region.imageExtent.width, block_width))
+                                     * ceil_div(last_region.imageExtent.height, block_height)
+                                     * format_block_size(target.image->get_format());
+
+        unique_data storage(target.source.size + next_size);
+        if (!storage.ptr) {
+            log()->error("staging update - allocate {} bytes", storage.size);
+            return false;
+        }
+
+        memcpy(storage.ptr, target.source.ptr, target.source.size);
+        memcpy(storage.ptr + target.source.size, data, next_size);
+
+        for (auto region : next.image_regions) {
+            region.bufferOffset += target.source.size;
+            target.image_regions.push_back(region);
+        }
+
+        auto& range = target.subresource_range;
+        auto const& next_range = next.subresource_range;
+
+        auto const level_end = std::max(range.baseMipLevel + range.levelCount, next_range.baseMipLevel + next_range.levelCount);
+        auto const layer_end = std::max(range.baseArrayLayer + range.layerCount, next_range.baseArrayLayer + next_range.layerCount);
+
+        range.baseMipLevel = std::min(range.baseMipLevel, next_range.baseMipLevel);
+        range.levelCount = level_end - range.baseMipLevel;
+        range.baseArrayLayer = std::min(range.baseArrayLayer, next_range.baseArrayLayer);
+        range.layerCount = layer_end - range.baseArrayLayer;
+
+        // unique_data has no move, hand over the buffer
+        std::swap(target.storage.ptr, storage.ptr);
+        std::swap(target.storage.size, storage.size);
+
+        target.source = { target.storage.ptr, target.storage.size };
+
+        return true;
+    }
+
+    bool staging::clear_image(image::ptr image, VkImageLayout final_layout) {
+        auto job = std::make_shared<staging::job>();
+        job->image = image;
+        job->final_layout = final_layout;
+        job->subresource_range = image->get_subresource_range();
+        job->clear = true;
+        job->frame_queue = true;
+
+        jobs.push_back(job);
+        return true;
+    }
+
+    void staging::retire(index frame) {
+        if (!frame_serials.count(frame))
+            return;
+
+        // the frame fence also covers all earlier submissions
+        ring_ranges.retire(frame_serials.at(frame));
+    }
+
+    void staging::begin_image(VkCommandBuffer cmd_buf, job& current) {
+        if (current.suspended) {
+            set_image_layout(device, cmd_buf, current.image->get(), current.final_layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                             current.subresource_range, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+            current.suspended = false;
+            return;
+        }
+
+        if (current.started)
+            return;
+
+        // any stage of the consumers may still read existing contents
+        auto const src_stage = current.old_layout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_PIPELINE_STAGE_HOST_BIT
+                                                                               : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        set_image_layout(device, cmd_buf, current.image->get(), current.old_layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         current.subresource_range, src_stage, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        if (current.clear) {
+            VkClearColorValue const clear_color{};
+            device->call().vkCmdClearColorImage(cmd_buf, current.image->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                &clear_color, 1, &current.subresource_range);
+        }
+
+        current.started = true;
+
+        if (!current.frame_queue)
+            transfer_recorded = true;
+    }
+
+    void staging::suspend_image(VkCommandBuffer cmd_buf, job& current) {
+        // owned by the transfer queue until the release
+        if (!current.started || current.suspended || (use_transfer_queue() && !current.frame_queue))
+            return;
+
+        // draws in between sample it in the layout of its descriptor
+        set_image_layout(device, cmd_buf, current.image->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, current.final_layout,
+                         current.subresource_range, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+        current.suspended = true;
+    }
+
+    staging::stage_result staging::stage_image(VkCommandBuffer cmd_buf, job& current, VkDeviceSize& budget) {
+        auto const format = current.image->get_format();
+
+        ui32 block_width = 1;
+        ui32 block_height = 1;
+        format_block_dim(format, block_width, block_height);
+
+        VkDeviceSize const block_size = format_block_size(format);
+        auto const alignment = std::lcm(std::lcm(VkDeviceSize(4), block_size),
+                                        std::max(device->get_properties().limits.optimalBufferCopyOffsetAlignment, VkDeviceSize(1)));
+
+        auto ring_data = as_ptr(ring->get_mapped_data());
+
+        // bands on the transfer queue start and end on its granularity (in blocks)
+        VkDeviceSize granule = 1;
+        if (use_transfer_queue() && !current.frame_queue)
+            granule = std::max(VkDeviceSize(transfer_granularity.height), VkDeviceSize(1));
+
+        std::vector<VkBufferImageCopy> copies;
+
+        auto record = [&]() {
+            if (copies.empty())
+                return;
+
+            device->call().vkCmdCopyBufferToImage(cmd_buf, ring->get(), current.image->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                  to_ui32(copies.size()), copies.data());
+
+            if (!current.frame_queue)
+                transfer_recorded = true;
+        };
+
+        while (current.next_region < current.image_regions.size()) {
+            auto const& region = current.image_regions.at(current.next_region);
+
+            auto const row_pitch = VkDeviceSize(ceil_div(region.imageExtent.width, block_width)) * block_size;
+            auto const rows = VkDeviceSize(ceil_div(region.imageExtent.height, block_height));
+
+            auto row_count = std::min(rows - current.progress, budget / row_pitch);
+            if (row_count < rows - current.progress)
+                row_count -= row_count % granule;
+
+            if (row_count == 0) {
+                record();
+
+                if (granule * row_pitch > std::min(frame_budget, ring->get_size())) {
+                    log()->error("stage image - band of {} bytes exceeds staging budget", granule * row_pitch);
+                    return stage_result::failed;
+                }
+
+                return stage_result::pending;
+            }
+
+            auto const size = row_count * row_pitch;
+
+            auto const offset = ring_ranges.allocate(size, alignment);
+            if (!offset) {
+                record();
+                return stage_result::pending;
+            }
+
+            budget -= size;
+
+            begin_image(cmd_buf, current);
+
+            memcpy(ring_data + *offset, current.source.ptr + region.bufferOffset + current.progress * row_pitch, size);
+            ring->flush(*offset, size);
+
+            auto const first_row = to_ui32(current.progress * block_height);
+
+            VkBufferImageCopy copy = region;
+            copy.bufferOffset = *offset;
+            copy.bufferRowLength = 0;
+            copy.bufferImageHeight = 0;
+            copy.imageOffset.y += to_i32(first_row);
+            copy.imageExtent.height = std::min(to_ui32(row_count * block_height), region.imageExtent.height - first_row);
+
+            copies.push_back(copy);
+
+            current.progress += row_count;
+            if (current.progress == rows) {
+                ++current.next_region;
+                current.progress = 0;
+            }
+        }
+
+        record();
+
+        begin_image(cmd_buf, current);
+
+        if (!use_transfer_queue() || current.frame_queue) {
+            if (current.mip_levels_generation)
+                generate_mip_levels(device, cmd_buf, current.image, current.final_layout, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+            else
+                set_image_layout(device, cmd_buf, current.image->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, current.final_layout,
+                                 current.subresource_range, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+            return stage_result::done;
+        }
+
+        // release on the transfer queue, acquire is recorded into the frame
+        // blits need the graphics queue, mip levels are generated after the acquire
+        auto const new_layout = current.mip_levels_generation ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : current.final_layout;
+
+        auto barrier = image_memory_barrier(current.image->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, new_layout);
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.srcQueueFamilyIndex = transfer_queue.family;
+        barrier.dstQueueFamilyIndex = dst_family;
+        barrier.subresourceRange = current.subresource_range;
+
+        device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+        transfer_recorded = true;
+
+        barrier.srcAccessMask = 0;
+        if (current.mip_levels_generation)
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        else
+            barrier.dstAccessMask = current.final_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ? VK_ACCESS_SHADER_READ_BIT
+                                                                                                     : VK_ACCESS_MEMORY_READ_BIT;
+
+        acquires.push_back({ current.image, barrier, current.mip_levels_generation, current.final_layout });
+
+        return stage_result::done;
+    }
+
+    void staging::record_acquires(VkCommandBuffer cmd_buf, VkImage image) {
+        std::vector<VkImageMemoryBarrier> barriers;
+        std::vector<acquire_target> mip_targets;
+
+        auto it = acquires.begin();
+        while (it != acquires.end()) {
+            if ((image != VK_NULL_HANDLE) && (it->image->get() != image)) {
+                ++it;
+                continue;
+            }
+
+            barriers.push_back(it->barrier);
+            if (it->mip_levels_generation)
+                mip_targets.push_back(*it);
+
+            it = acquires.erase(it);
+        }
+
+        if (barriers.empty())
+            return;
+
+        // the frame waits on the transfer sync point at transfer_wait_stage
+        device->call().vkCmdPipelineBarrier(cmd_buf, transfer_wait_stage, acquire_stages,
+                                            0, 0, nullptr, 0, nullptr, to_ui32(barriers.size()), barriers.data());
+
+        for (auto& target : mip_targets)
+            generate_mip_levels(device, cmd_buf, target.image, target.final_layout, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    }
+
+    staging::stage_result staging::stage_buffer(VkCommandBuffer cmd_buf, job& current, VkDeviceSize& budget) {
+        // draws read the buffer between frames, all regions are copied at once
+        VkDeviceSize size = 0;
+        for (auto& region : current.buffer_regions)
+            size += align_up(region.size, VkDeviceSize(16));
+
+        if (size > ring->get_size()) {
+            log()->error("stage buffer - {} bytes exceed staging capacity", size);
+            return stage_result::failed;
+        }
+
+        // a full budget next frame, larger uploads go alone
+        if ((size > budget) && (budget < frame_budget))
+            return stage_result::pending;
+
+        auto const offset = ring_ranges.allocate(size, 16);
+        if (!offset)
+            return stage_result::pending;
+
+        budget -= std::min(budget, size);
+
+        auto ring_data = as_ptr(ring->get_mapped_data());
+
+        std::vector<VkBufferCopy> copies;
+
+        auto src_offset = *offset;
+        for (auto& region : current.buffer_regions) {
+            memcpy(ring_data + src_offset, current.source.ptr + region.srcOffset, region.size);
+            copies.push_back({ .srcOffset = src_offset, .dstOffset = region.dstOffset, .size = region.size });
+
+            src_offset += align_up(region.size, VkDeviceSize(16));
+        }
+
+        ring->flush(*offset, size);
+
+        auto const usage = current.buffer->get_usage();
+
+        auto dst_stages = buffer::usage_to_possible_stages(usage);
+        if (dst_stages == 0)
+            dst_stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        // earlier reads are done before the copy overwrites them
+        device->call().vkCmdPipelineBarrier(cmd_buf, dst_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+        device->call().vkCmdCopyBuffer(cmd_buf, ring->get(), current.buffer->get(), to_ui32(copies.size()), copies.data());
+
+        VkBufferMemoryBarrier const barrier{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = buffer::usage_to_possible_access(usage),
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = current.buffer->get(),
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+        };
+
+        device->call().vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stages, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+        return stage_result::done;
+    }
+
+    bool staging::stage(VkCommandBuffer cmd_buf, index frame) {
+        if (!ring) {
+            log()->error("stage - staging not created");
+            return false;
+        }
+
+        // the frame waits on its transfer, unless it was skipped
+        if (transfer_frames.count(frame) && !transfer_timeline.wait(transfer_frames.at(frame).value))
+            return false;
+
+        retire(frame);
+
+        ++serial;
+        frame_serials[frame] = serial;
+
+        submitted_point = {};
+
+        for (auto& [texture, on_staged] : todo) {
+            if (!texture->get_image() || !texture->has_upload_data()) {
+                log()->error("stage texture - no upload data");
+
+                if (on_staged)
+                    on_staged(false);
+                continue;
+            }
+
+            auto job = make_texture_job(texture);
+            job->source = texture->get_upload_data();
+            job->on_staged = on_staged;
+
+            if (!add_job(job, nullptr, job->source.size) && on_staged)
+                on_staged(false);
+        }
+
+        todo.clear();
+
+        if (jobs.empty())
+            return true;
+
+        // buffers and updated images may hold live data outside the uploaded range, they stay on the frame queue
+        VkCommandBuffer image_cmd_buf = cmd_buf;
+        if (use_transfer_queue()) {
+            image_cmd_buf = begin_transfer(frame);
+            if (!image_cmd_buf)
+                return false;
+        }
+
+        auto budget = frame_budget;
+
+        while (!jobs.empty()) {
+            auto& job = *jobs.front();
+
+            // whole mip levels only, banded copies stay on the frame queue
+            if (job.image && !job.started && use_transfer_queue() && (transfer_granularity.height == 0))
+                job.frame_queue = true;
+
+            // updates and clears of an uploaded image need it back on this queue first
+            if (job.image && job.frame_queue && !job.started)
+                record_acquires(cmd_buf, job.image->get());
+
+            auto const result = job.buffer ? stage_buffer(cmd_buf, job, budget)
+                                           : stage_image(job.frame_queue ? cmd_buf : image_cmd_buf, job, budget);
+            if (result == stage_result::pending) {
+                if (job.image)
+                    suspend_image(job.frame_queue ? cmd_buf : image_cmd_buf, job);
+                break;
+            }
+
+            if (job.texture)
+                job.texture->destroy_upload_data();
+
+            if (job.on_staged)
+                job.on_staged(result == stage_result::done);
+
+            jobs.pop_front();
+        }
+
+        if (budget < frame_budget)
+            ring_ranges.mark(serial);
+
+        if (!use_transfer_queue())
+            return true;
+
+        if (!submit_transfer(frame, transfer_recorded))
+            return false;
+
+        record_acquires(cmd_buf);
+
+        return true;
+    }
+
+} // namespace lava
@@ -0,0 +1,211 @@
+// file      : liblava/resource/staging.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <deque>
+#include <liblava/base/timeline_semaphore.hpp>
+#include <liblava/resource/buffer_allocator.hpp>
+#include <liblava/resource/texture.hpp>
+
+namespace lava {
+
+    constexpr VkDeviceSize const default_staging_capacity = 64 * 1024 * 1024;
+    constexpr VkDeviceSize const default_staging_frame_budget = 16 * 1024 * 1024;
+
+    struct staging : id_obj {
+        using ptr = std::shared_ptr<staging>;
+
+        ~staging() {
+            destroy();
+        }
+
+        bool create(device_ptr device, VkDeviceSize capacity = default_staging_capacity);
+        void destroy();
+
+        // result of a texture, false when it failed or was dropped by clear()
+        // not sampled before, the upload may span several frames
+        using staged_func = std::function<void(bool)>;
+
+        void add(texture::ptr texture, staged_func on_staged = {}) {
+            todo.push_back({ texture, on_staged });
+        }
+
+        bool upload(texture::ptr texture, void const* data, size_t data_size);
+        bool upload(image::ptr image, void const* data, size_t data_size,
+                    VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        bool upload(buffer::ptr buffer, void const* data, size_t data_size, VkDeviceSize offset = 0);
+
+        struct update_region {
+            using list = std::vector<update_region>;
+
+            uv2 offset = uv2(0, 0);
+            uv2 size = uv2(0, 0);
+
+            ui32 level = 0;
+            ui32 layer = 0;
+        };
+
+        // texels of all regions tightly packed in order, contents outside are kept
+        // consecutive updates of the same image are recorded with one copy
+        bool update(image::ptr image, update_region::list const& regions, void const* data, size_t data_size,
+                    VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        bool update(texture::ptr texture, update_region::list const& regions, void const* data, size_t data_size) {
+            return update(texture->get_image(), regions, data, data_size);
+        }
+
+        bool upload(image::ptr image, ui32 layer, uv2 offset, uv2 size, void const* data, size_t data_size) {
+            return update(image, { { offset, size, 0, layer } }, data, data_size);
+        }
+
+        // undefined to cleared contents in final layout
+        bool clear_image(image::ptr image, VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        // false on errors, busy() tells if jobs are left
+        bool stage(VkCommandBuffer cmd_buf, index frame);
+
+        // copies are recorded on the transfer queue and handed over to family,
+        // the frame must wait on get_transfer_sync() after stage(), requires timeline semaphores
+        bool set_transfer_queue(queue::ref target, index family);
+        bool use_transfer_queue() const {
+            return transfer_queue.valid();
+        }
+
+        // transfer submitted by the last stage(), invalid when nothing was submitted
+        sync_point get_transfer_sync() const {
+            return submitted_point;
+        }
+
+        static constexpr VkPipelineStageFlags const transfer_wait_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+        // drops all pending jobs
+        void clear();
+
+        bool busy() const {
+            return !todo.empty() || !jobs.empty();
+        }
+
+        bool valid() const {
+            return ring != nullptr;
+        }
+
+        VkDeviceSize get_capacity() const {
+            return ring ? ring->get_size() : 0;
+        }
+
+        void set_frame_budget(VkDeviceSize value) {
+            frame_budget = value;
+        }
+        VkDeviceSize get_frame_budget() const {
+            return frame_budget;
+        }
+
+    private:
+        struct job {
+            using ptr = std::shared_ptr<job>;
+            using list = std::deque<ptr>;
+
+            texture::ptr texture;
+            image::ptr image;
+            buffer::ptr buffer;
+
+            unique_data storage;
+            cdata source;
+
+            std::vector<VkBufferImageCopy> image_regions;
+            std::vector<VkBufferCopy> buffer_regions;
+
+            index next_region = 0;
+            VkDeviceSize progress = 0; // block rows of next region
+
+            VkImageSubresourceRange subresource_range = {};
+            VkImageLayout old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            bool mip_levels_generation = false;
+            bool clear = false;
+            bool frame_queue = false; // existing contents or clears stay on the frame queue
+            bool started = false;
+            bool suspended = false; // in final layout between frames
+
+            staged_func on_staged;
+        };
+
+        enum class stage_result : type {
+            done = 0,
+            pending,
+            failed
+        };
+
+        job::ptr make_image_job(image::ptr image, VkImageLayout final_layout, texture::layer::list const& layers);
+        job::ptr make_texture_job(texture::ptr texture);
+        bool add_job(job::ptr job, void const* data, size_t data_size);
+        bool merge_update(job& target, job const& next, void const* data);
+
+        void begin_image(VkCommandBuffer cmd_buf, job& current);
+        void suspend_image(VkCommandBuffer cmd_buf, job& current);
+        stage_result stage_image(VkCommandBuffer cmd_buf, job& current, VkDeviceSize& budget);
+        stage_result stage_buffer(VkCommandBuffer cmd_buf, job& current, VkDeviceSize& budget);
+
+        bool create_ring(VkDeviceSize capacity, index_list const& families = {});
+
+        void retire(index frame);
+
+        VkCommandBuffer begin_transfer(index frame);
+        bool submit_transfer(index frame, bool recorded);
+        void destroy_transfer_frames();
+
+        device_ptr device = nullptr;
+
+        buffer::ptr ring;
+        ring_allocator ring_ranges;
+        VkDeviceSize frame_budget = default_staging_frame_budget;
+
+        std::map<index, ui64> frame_serials;
+        ui64 serial = 0;
+
+        struct todo_texture {
+            texture::ptr texture;
+            staged_func on_staged;
+        };
+
+        std::vector<todo_texture> todo;
+        job::list jobs;
+
+        queue transfer_queue;
+        index dst_family = 0;
+        VkExtent3D transfer_granularity = { 1, 1, 1 };
+
+        struct transfer_frame {
+            VkCommandPool pool = VK_NULL_HANDLE;
+            VkCommandBuffer cmd_buf = VK_NULL_HANDLE;
+
+            // signaled by the last submit, a skipped frame never waits on it
+            ui64 value = 0;
+        };
+
+        std::map<index, transfer_frame> transfer_frames;
+
+        // released on the transfer queue, acquired in the frame before the next use
+        struct acquire_target {
+            image::ptr image;
+            VkImageMemoryBarrier barrier = {};
+            bool mip_levels_generation = false;
+            VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        };
+        std::vector<acquire_target> acquires;
+
+        // all pending acquires or only those of image
+        void record_acquires(VkCommandBuffer cmd_buf, VkImage image = VK_NULL_HANDLE);
+
+        bool transfer_recorded = false;
+        timeline_semaphore transfer_timeline;
+        sync_point submitted_point;
+    };
+
+    inline staging::ptr make_staging() {
+        return std::make_shared<staging>();
+    }
+
+} // namespace lava
@@ -2,14 +2,15 @@
 // copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
 // license   : MIT; see accompanying LICENSE file
 
-#include <liblava/resource/format.hpp>
+#include <liblava/resource/mip_map.hpp>
 #include <liblava/resource/texture.hpp>
 
 namespace lava {
 
-    bool texture::create(device_ptr device, uv2 size, VkFormat format, layer::list const& l, texture_type t) {
+    bool texture::create(device_ptr device, uv2 size, VkFormat format, layer::list const& l, texture_type t, bool mip_generation) {
         layers = l;
         type = t;
+        mip_levels_generation = false;
 
         if (layers.empty()) {
             layer layer;
@@ -21,6 +22,27 @@ namespace lava {
             layers.push_back(layer);
         }
 
+        if (mip_generation) {
+            if (mip_levels_supported(device, format)) {
+                auto const level_count = mip_level_count(size);
+
+                for (auto& layer : layers) {
+                    layer.levels.resize(1);
+
+                    for (auto level = 1u; level < level_count; ++level) {
+                        mip_level mip;
+                        mip.extent = uv2(std::max(size.x >> level, 1u), std::max(size.y >> level, 1u));
+
+                        layer.levels.push_back(mip);
+                    }
+                }
+
+                mip_levels_generation = level_count > 1;
+            } else {
+                log()->warn("texture mip levels generation - format {} not supported", to_i32(format));
+            }
+        }
+
         VkSamplerAddressMode sampler_address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
         if (type == texture_type::array || type == texture_type::cube_map)
             sampler_address_mode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
@@ -39,17 +61,19 @@ namespace lava {
             .compareEnable = VK_FALSE,
             .compareOp = VK_COMPARE_OP_NEVER,
             .minLod = 0.f,
-            .maxLod = to_r32(layers.front().levels.size()),
+            .maxLod = VK_LOD_CLAMP_NONE,
             .borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
             .unnormalizedCoordinates = VK_FALSE,
         };
 
-        if (!device->vkCreateSampler(&sampler_info, &sampler)) {
+        sampler = device->get_sampler_cache().acquire(sampler_info);
+        if (!sampler) {
             log()->error("create texture sampler");
             return false;
         }
 
         img = make_image(format);
+        img->set_memory_tag(memory_tag::texture);
 
         if (type == texture_type::cube_map)
             img->set_flags(VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT);
@@ -78,12 +102,12 @@ namespace lava {
     }
 
     void texture::destroy() {
-        destroy_upload_buffer();
+        destroy_upload_data();
 
         if (sampler) {
             if (img)
                 if (auto device = img->get_device())
-                    device->vkDestroySampler(sampler);
+                    device->get_sampler_cache().release(sampler);
 
             sampler = VK_NULL_HANDLE;
         }
@@ -94,127 +118,21 @@ namespace lava {
         }
     }
 
-    void texture::destroy_upload_buffer() {
-        upload_buffer = nullptr;
+    void texture::destroy_upload_data() {
+        upload_data.free();
+        upload_data.size = 0;
     }
 
     bool texture::upload(void const* data, size_t data_size) {
-        upload_buffer = make_buffer();
+        destroy_upload_data();
 
-        return upload_buffer->create(img->get_device(), data, data_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false, VMA_MEMORY_USAGE_CPU_TO_GPU);
-    }
-
-    bool texture::stage(VkCommandBuffer cmd_buf) {
-        if (!upload_buffer || !upload_buffer->valid()) {
-            log()->error("stage texture");
+        upload_data.set(data_size);
+        if (!upload_data.ptr) {
+            log()->error("upload texture data");
             return false;
         }
 
-        VkImageSubresourceRange subresource_range{
-            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-            .baseMipLevel = 0,
-            .levelCount = to_ui32(layers.front().levels.size()),
-            .baseArrayLayer = 0,
-            .layerCount = to_ui32(layers.size()),
-        };
-
-        auto device = img->get_device();
-
-        set_image_layout(device, cmd_buf, img->get(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresource_range,
-                         VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-
-        std::vector<VkBufferImageCopy> regions;
-
-        if (to_ui32(layers.front().levels.size()) > 1) {
-            auto offset = 0u;
-
-            for (auto layer = 0u; layer < layers.size(); ++layer) {
-                for (auto level = 0u; level < to_ui32(layers.front().levels.size()); ++level) {
-                    VkImageSubresourceLayers image_subresource{
-                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                        .mipLevel = level,
-                        .baseArrayLayer = layer,
-                        .layerCount = 1,
-                    };
-
-                    VkExtent3D image_extent{
-                        .width = layers[layer].levels[level].extent.x,
-                        .height = layers[layer].levels[level].extent.y,
-                        .depth = 1,
-                    };
-
-                    VkBufferImageCopy buffer_copy_region{
-                        .bufferOffset = offset,
-                        .imageSubresource = image_subresource,
-                        .imageExtent = image_extent,
-                    };
-
-                    regions.push_back(buffer_copy_region);
-
-                    offset += layers[layer].levels[level].size;
-                }
-            }
-        } else {
-            VkImageSubresourceLayers subresource_layers{
-                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                .mipLevel = 0,
-                .baseArrayLayer = 0,
-                .layerCount = to_ui32(layers.size()),
-            };
-
-            auto size = img->get_size();
-
-            VkBufferImageCopy region{
-                .bufferOffset = 0,
-                .bufferRowLength = size.x,
-                .bufferImageHeight = size.y,
-                .imageSubresource = subresource_layers,
-                .imageOffset = {},
-                .imageExtent = { size.x, size.y, 1 },
-            };
-
-            regions.push_back(region);
-        }
-
-        device->call().vkCmdCopyBufferToImage(cmd_buf, upload_buffer->get(), img->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                              to_ui32(regions.size()), regions.data());
-
-        set_image_layout(device, cmd_buf, img->get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresource_range,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
-
-        return true;
-    }
-
-    bool staging::stage(VkCommandBuffer cmd_buf, index frame) {
-        if (!staged.empty() && staged.count(frame) && !staged.at(frame).empty()) {
-            for (auto& texture : staged.at(frame))
-                texture->destroy_upload_buffer();
-
-            staged.erase(frame);
-        }
-
-        if (todo.empty())
-            return false;
-
-        texture::list stage_done;
-
-        for (auto& texture : todo) {
-            if (!texture->stage(cmd_buf))
-                continue;
-
-            stage_done.push_back(texture);
-        }
-
-        if (!staged.count(frame))
-            staged.emplace(frame, texture::list());
-
-        for (auto& texture : stage_done) {
-            if (!contains(staged.at(frame), texture))
-                staged.at(frame).push_back(texture);
-
-            remove(todo, texture);
-        }
+        memcpy(upload_data.ptr, data, data_size);
 
         return true;
     }
@@ -46,12 +46,19 @@ namespace lava {
         }
 
         bool create(device_ptr device, uv2 size, VkFormat format,
-                    layer::list const& layers = {}, texture_type type = texture_type::tex_2d);
+                    layer::list const& layers = {}, texture_type type = texture_type::tex_2d,
+                    bool mip_levels_generation = false);
         void destroy();
 
         bool upload(void const* data, size_t data_size);
-        bool stage(VkCommandBuffer cmd_buffer);
-        void destroy_upload_buffer();
+        void destroy_upload_data();
+
+        cdata get_upload_data() const {
+            return { upload_data.ptr, upload_data.size };
+        }
+        bool has_upload_data() const {
+            return upload_data.ptr != nullptr;
+        }
 
         VkDescriptorImageInfo const* get_descriptor_info() const {
             return &descriptor;
@@ -61,6 +68,11 @@ namespace lava {
             return img;
         }
 
+        // after the image view changed
+        void update_descriptor() {
+            descriptor.imageView = img ? img->get_view() : VK_NULL_HANDLE;
+        }
+
         uv2 get_size() const {
             return img ? img->get_size() : uv2();
         }
@@ -72,45 +84,32 @@ namespace lava {
             return img ? img->get_format() : VK_FORMAT_UNDEFINED;
         }
 
+        layer::list const& get_layers() const {
+            return layers;
+        }
+
+        // upload data holds level 0 only, other levels are blitted after upload
+        bool generates_mip_levels() const {
+            return mip_levels_generation;
+        }
+
     private:
         image::ptr img;
 
         texture_type type = texture_type::none;
         layer::list layers;
+        bool mip_levels_generation = false;
 
         VkSampler sampler = 0;
         VkDescriptorImageInfo descriptor = {};
 
-        buffer::ptr upload_buffer;
+        unique_data upload_data;
     };
 
     inline texture::ptr make_texture() {
         return std::make_shared<texture>();
     }
 
-    struct staging {
-        void add(texture::ptr texture) {
-            todo.push_back(texture);
-        }
-
-        bool stage(VkCommandBuffer cmd_buf, index frame);
-
-        void clear() {
-            todo.clear();
-            staged.clear();
-        }
-
-        bool busy() const {
-            return !todo.empty() || !staged.empty();
-        }
-
-    private:
-        texture::list todo;
-
-        using frame_stage_map = std::map<index, texture::list>;
-        frame_stage_map staged;
-    };
-
     using texture_registry = id_registry<texture, file_format>;
 
 } // namespace lava
@@ -0,0 +1,337 @@
+// file      : liblava/resource/transient_image_pool.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/resource/transient_image_pool.hpp>
+#include <numeric>
+
+namespace lava {
+
+    std::vector<VkDeviceSize> alias_offsets(alias_request::list const& requests, VkDeviceSize& block_size) {
+        std::vector<VkDeviceSize> result(requests.size(), 0);
+        block_size = 0;
+
+        // big first, fewer holes
+        std::vector<index> order(requests.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](index a, index b) {
+            return requests[a].size > requests[b].size;
+        });
+
+        std::vector<index> placed;
+
+        for (auto i : order) {
+            auto const& current = requests[i];
+            auto const alignment = std::max(current.alignment, VkDeviceSize(1));
+
+            VkDeviceSize offset = 0;
+
+            for (auto moved = true; moved;) {
+                moved = false;
+
+                for (auto p : placed) {
+                    auto const& other = requests[p];
+
+                    if ((current.last_pass < other.first_pass) || (other.last_pass < current.first_pass))
+                        continue;
+
+                    if ((offset >= result[p] + other.size) || (offset + current.size <= result[p]))
+                        continue;
+
+                    offset = align_up(result[p] + other.size, alignment);
+                    moved = true;
+                }
+            }
+
+            result[i] = offset;
+            placed.push_back(i);
+
+            block_size = std::max(block_size, offset + current.size);
+        }
+
+        return result;
+    }
+
+    bool transient_image_pool::create(device_ptr d, index frame_count) {
+        device = d;
+
+        if (frame_count == 0) {
+            log()->error("create transient image pool - invalid frame count");
+            return false;
+        }
+
+        slots.resize(frame_count);
+        current_frame = no_index;
+
+        VkPhysicalDeviceMemoryProperties const* properties = nullptr;
+        vmaGetMemoryProperties(device->alloc(), &properties);
+
+        lazy_type_available = false;
+        for (auto i = 0u; i < properties->memoryTypeCount; ++i)
+            if (properties->memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+                lazy_type_available = true;
+
+        return true;
+    }
+
+    void transient_image_pool::destroy() {
+        if (!device)
+            return;
+
+        for (auto& current : slots)
+            release(current);
+
+        slots.clear();
+        requests.clear();
+
+        device = nullptr;
+    }
+
+    void transient_image_pool::begin(index frame) {
+        current_frame = slots.empty() ? no_index : frame % slots.size();
+
+        requests.clear();
+        slot_rebuilt = false;
+    }
+
+    index transient_image_pool::request(VkFormat format, uv2 size, VkImageUsageFlags usage, ui32 first_pass, ui32 last_pass) {
+        requests.push_back({
+            .format = format,
+            .size = size,
+            .usage = usage,
+            .first_pass = first_pass,
+            .last_pass = std::max(first_pass, last_pass),
+        });
+
+        return to_index(requests.size() - 1);
+    }
+
+    bool transient_image_pool::end() {
+        if (current_frame == no_index)
+            return false;
+
+        auto& current = slots.at(current_frame);
+        if ((current.keys == requests) && (current.images.size() == requests.size()))
+            return true;
+
+        release(current);
+        slot_rebuilt = true;
+
+        if (requests.empty())
+            return true;
+
+        if (!build(current)) {
+            release(current);
+            return false;
+        }
+
+        return true;
+    }
+
+    image::ptr transient_image_pool::get(index request) const {
+        if (current_frame == no_index)
+            return nullptr;
+
+        auto const& current = slots.at(current_frame);
+        if (request >= current.images.size())
+            return nullptr;
+
+        return current.images.at(request);
+    }
+
+    bool transient_image_pool::lazy(VkImageUsageFlags usage) const {
+        if (!lazy_allocation || !lazy_type_available)
+            return false;
+
+        constexpr VkImageUsageFlags const attachment_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+                                                             | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+                                                             | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT
+                                                             | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+        return (usage & ~attachment_usage) == 0;
+    }
+
+    bool transient_image_pool::build(slot& target) {
+        target.keys = requests;
+
+        std::vector<VkMemoryRequirements> requirements;
+
+        // aliased per set of allowed memory types
+        std::map<ui32, std::vector<index>> groups;
+
+        for (auto i = 0u; i < requests.size(); ++i) {
+            auto const& request = requests.at(i);
+
+            auto usage = request.usage;
+            auto const lazy_image = lazy(usage);
+            if (lazy_image)
+                usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+            VkImageCreateInfo const create_info{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .imageType = VK_IMAGE_TYPE_2D,
+                .format = request.format,
+                .extent = { request.size.x, request.size.y, 1 },
+                .mipLevels = 1,
+                .arrayLayers = 1,
+                .samples = VK_SAMPLE_COUNT_1_BIT,
+                .tiling = VK_IMAGE_TILING_OPTIMAL,
+                .usage = usage,
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            };
+
+            VkImage vk_image = VK_NULL_HANDLE;
+            if (failed(device->call().vkCreateImage(device->get(), &create_info, memory::alloc(), &vk_image))) {
+                log()->error("create transient image");
+                return false;
+            }
+
+            auto result = make_image(request.format, vk_image);
+            result->set_usage(usage);
+            target.images.push_back(result);
+
+            VkMemoryRequirements memory_requirements{};
+            device->call().vkGetImageMemoryRequirements(device->get(), vk_image, &memory_requirements);
+            requirements.push_back(memory_requirements);
+
+            target.requested_size += memory_requirements.size;
+
+            if (lazy_image) {
+                VmaAllocationCreateInfo const alloc_info{
+                    .usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED,
+                };
+
+                VmaAllocation allocation = nullptr;
+                if (check(vmaAllocateMemoryForImage(device->alloc(), vk_image, &alloc_info, &allocation, nullptr))) {
+                    if (check(vmaBindImageMemory(device->alloc(), allocation, vk_image))) {
+                        target.allocations.push_back(allocation);
+                        continue;
+                    }
+
+                    vmaFreeMemory(device->alloc(), allocation);
+                }
+
+                log()->warn("transient image - lazily allocated memory not available");
+            }
+
+            groups[memory_requirements.memoryTypeBits].push_back(i);
+        }
+
+        for (auto& [type_bits, members] : groups) {
+            alias_request::list alias_requests;
+
+            VkDeviceSize alignment = 1;
+            for (auto i : members) {
+                alias_requests.push_back({
+                    .size = requirements.at(i).size,
+                    .alignment = requirements.at(i).alignment,
+                    .first_pass = requests.at(i).first_pass,
+                    .last_pass = requests.at(i).last_pass,
+                });
+
+                alignment = std::max(alignment, requirements.at(i).alignment);
+            }
+
+            VkDeviceSize block_size = 0;
+            auto const offsets = alias_offsets(alias_requests, block_size);
+
+            VkMemoryRequirements const block_requirements{
+                .size = block_size,
+                .alignment = alignment,
+                .memoryTypeBits = type_bits,
+            };
+
+            VmaAllocationCreateInfo const alloc_info{
+                .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+            };
+
+            VmaAllocation allocation = nullptr;
+            VmaAllocationInfo allocation_info{};
+            if (failed(vmaAllocateMemory(device->alloc(), &block_requirements, &alloc_info, &allocation, &allocation_info))) {
+                log()->error("allocate transient image memory - {} bytes", block_size);
+                return false;
+            }
+
+            target.allocations.push_back(allocation);
+
+            for (auto m = 0u; m < members.size(); ++m) {
+                auto const vk_image = target.images.at(members[m])->get();
+
+                if (failed(device->call().vkBindImageMemory(device->get(), vk_image, allocation_info.deviceMemory,
+                                                            allocation_info.offset + offsets[m]))) {
+                    log()->error("bind transient image memory");
+                    return false;
+                }
+            }
+        }
+
+        for (auto i = 0u; i < requests.size(); ++i) {
+            if (!target.images.at(i)->create(device, requests.at(i).size)) {
+                log()->error("create transient image view");
+                return false;
+            }
+        }
+
+        auto allocator = device->get_allocator();
+
+        for (auto allocation : target.allocations) {
+            VmaAllocationInfo allocation_info{};
+            vmaGetAllocationInfo(device->alloc(), allocation, &allocation_info);
+
+            target.memory_size += allocation_info.size;
+
+            if (allocator)
+                allocator->track(memory_tag::transient, allocation_info.size);
+        }
+
+        return true;
+    }
+
+    void transient_image_pool::release(slot& target) {
+        // images own their handle
+        for (auto& current : target.images) {
+            if (current->get_device())
+                current->destroy();
+            else
+                device->call().vkDestroyImage(device->get(), current->get(), memory::alloc());
+        }
+
+        target.images.clear();
+
+        auto allocator = device->get_allocator();
+
+        for (auto allocation : target.allocations) {
+            VmaAllocationInfo allocation_info{};
+            vmaGetAllocationInfo(device->alloc(), allocation, &allocation_info);
+
+            if (allocator && (target.memory_size > 0))
+                allocator->untrack(memory_tag::transient, allocation_info.size);
+
+            vmaFreeMemory(device->alloc(), allocation);
+        }
+
+        target.allocations.clear();
+        target.keys.clear();
+
+        target.memory_size = 0;
+        target.requested_size = 0;
+    }
+
+    VkDeviceSize transient_image_pool::get_memory_size() const {
+        VkDeviceSize result = 0;
+        for (auto const& current : slots)
+            result += current.memory_size;
+
+        return result;
+    }
+
+    VkDeviceSize transient_image_pool::get_requested_size() const {
+        VkDeviceSize result = 0;
+        for (auto const& current : slots)
+            result += current.requested_size;
+
+        return result;
+    }
+
+} // namespace lava
@@ -0,0 +1,116 @@
+// file      : liblava/resource/transient_image_pool.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/resource/image.hpp>
+
+namespace lava {
+
+    // lifetime in pass order of the frame, first and last pass inclusive
+    struct alias_request {
+        using list = std::vector<alias_request>;
+
+        VkDeviceSize size = 0;
+        VkDeviceSize alignment = 1;
+
+        ui32 first_pass = 0;
+        ui32 last_pass = 0;
+    };
+
+    // offsets in one memory block, requests with overlapping lifetimes do not overlap in memory
+    std::vector<VkDeviceSize> alias_offsets(alias_request::list const& requests, VkDeviceSize& block_size);
+
+    // intermediate images per frame in flight, memory shared between images that are not alive at the same time
+    struct transient_image_pool : id_obj {
+        using ptr = std::shared_ptr<transient_image_pool>;
+
+        ~transient_image_pool() {
+            destroy();
+        }
+
+        bool create(device_ptr device, index frame_count);
+        void destroy();
+
+        // after the fence of the frame
+        void begin(index frame);
+
+        // index of the image in this frame
+        index request(VkFormat format, uv2 size, VkImageUsageFlags usage, ui32 first_pass = 0, ui32 last_pass = 0);
+
+        // recycles the images of the last use of this frame if all requests match
+        bool end();
+
+        // images start undefined in their first pass, an aliased image needs a barrier
+        // after the last pass of the image before it on the same memory
+        image::ptr get(index request) const;
+
+        // images of this frame were recreated by end(), descriptors must be updated
+        bool rebuilt() const {
+            return slot_rebuilt;
+        }
+
+        // attachment only images in lazily allocated memory (tile based gpus)
+        void set_lazy_allocation(bool value) {
+            lazy_allocation = value;
+        }
+        bool lazy_allocation_supported() const {
+            return lazy_type_available;
+        }
+
+        // all frames
+        VkDeviceSize get_memory_size() const;
+
+        // all frames without aliasing
+        VkDeviceSize get_requested_size() const;
+
+    private:
+        struct key {
+            using list = std::vector<key>;
+
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            uv2 size = uv2(0, 0);
+            VkImageUsageFlags usage = 0;
+
+            ui32 first_pass = 0;
+            ui32 last_pass = 0;
+
+            bool operator==(key const& other) const {
+                return (format == other.format) && (size == other.size) && (usage == other.usage)
+                       && (first_pass == other.first_pass) && (last_pass == other.last_pass);
+            }
+        };
+
+        struct slot {
+            key::list keys;
+            image::list images;
+
+            std::vector<VmaAllocation> allocations;
+
+            VkDeviceSize memory_size = 0;
+            VkDeviceSize requested_size = 0;
+        };
+
+        bool lazy(VkImageUsageFlags usage) const;
+
+        bool build(slot& target);
+        void release(slot& target);
+
+        device_ptr device = nullptr;
+
+        std::vector<slot> slots;
+        index current_frame = no_index;
+
+        key::list requests;
+        bool slot_rebuilt = false;
+
+        bool lazy_allocation = true;
+        bool lazy_type_available = false;
+    };
+
+    inline transient_image_pool::ptr make_transient_image_pool() {
+        return std::make_shared<transient_image_pool>();
+    }
+
+} // namespace lava
@@ -0,0 +1,122 @@
+// file      : liblava/resource/uniform_ring.cpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#include <liblava/resource/uniform_ring.hpp>
+
+namespace lava {
+
+    bool uniform_ring_offsets::reset(index fc, VkDeviceSize fcap, VkDeviceSize r, VkDeviceSize a) {
+        frame_count = fc;
+        range = r;
+        alignment = std::max(a, VkDeviceSize(1));
+        frame_capacity = align_up(fcap, alignment);
+
+        current_frame = 0;
+        head = 0;
+
+        return (frame_count > 0) && (range > 0) && (fcap >= range);
+    }
+
+    void uniform_ring_offsets::begin_frame(index frame) {
+        current_frame = frame % frame_count;
+        head = 0;
+    }
+
+    std::optional<VkDeviceSize> uniform_ring_offsets::allocate(VkDeviceSize size) {
+        auto const offset = align_up(head, alignment);
+
+        // descriptor range must stay inside the frame region
+        if (offset + range > frame_capacity)
+            return std::nullopt;
+
+        head = offset + size;
+
+        return get_frame_offset() + offset;
+    }
+
+    bool uniform_ring::create(device_ptr d, index frame_count, VkDeviceSize frame_capacity, VkDeviceSize range, VkBufferUsageFlags u) {
+        device = d;
+        usage = u;
+
+        auto const& limits = device->get_properties().limits;
+
+        auto alignment = limits.minUniformBufferOffsetAlignment;
+        auto max_range = VkDeviceSize(limits.maxUniformBufferRange);
+
+        if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+            alignment = limits.minStorageBufferOffsetAlignment;
+            max_range = limits.maxStorageBufferRange;
+        }
+
+        if (range > max_range) {
+            log()->error("create uniform ring - range {} exceeds {}", range, max_range);
+            return false;
+        }
+
+        // frame regions are flushed on their own
+        if (!offsets.reset(frame_count, frame_capacity, range, std::max(alignment, limits.nonCoherentAtomSize))) {
+            log()->error("create uniform ring - invalid capacity");
+            return false;
+        }
+
+        ring = make_buffer();
+        if (!ring->create_mapped(device, nullptr, offsets.get_frame_capacity() * frame_count, usage)) {
+            log()->error("create uniform ring buffer");
+            return false;
+        }
+
+        descriptor = {
+            .buffer = ring->get(),
+            .offset = 0,
+            .range = range,
+        };
+
+        flushed = 0;
+
+        return true;
+    }
+
+    void uniform_ring::destroy() {
+        if (ring) {
+            ring->destroy();
+            ring = nullptr;
+        }
+
+        device = nullptr;
+    }
+
+    void uniform_ring::begin_frame(index frame) {
+        offsets.begin_frame(frame);
+        flushed = 0;
+    }
+
+    void uniform_ring::flush() {
+        if (!ring || (offsets.get_used() == flushed))
+            return;
+
+        ring->flush(offsets.get_frame_offset() + flushed, offsets.get_used() - flushed);
+        flushed = offsets.get_used();
+    }
+
+    uniform_ring::allocation uniform_ring::allocate(VkDeviceSize size) {
+        allocation result;
+
+        if (!ring || (size == 0) || (size > descriptor.range)) {
+            log()->error("uniform ring - invalid size {}", size);
+            return result;
+        }
+
+        auto const offset = offsets.allocate(size);
+        if (!offset) {
+            log()->error("uniform ring - frame capacity {} exceeded", offsets.get_frame_capacity());
+            return result;
+        }
+
+        result.data = (data_ptr) ring->get_mapped_data() + *offset;
+        result.offset = to_ui32(*offset);
+
+        return result;
+    }
+
+} // namespace lava
@@ -0,0 +1,125 @@
+// file      : liblava/resource/uniform_ring.hpp
+// copyright : Copyright (c) 2018-present, Lava Block OÜ and contributors
+// license   : MIT; see accompanying LICENSE file
+
+#pragma once
+
+#include <liblava/resource/buffer.hpp>
+#include <optional>
+
+namespace lava {
+
+    // dynamic offsets of the frame regions in a ring, no device
+    struct uniform_ring_offsets {
+        // capacity is aligned up to the alignment
+        bool reset(index frame_count, VkDeviceSize frame_capacity, VkDeviceSize range, VkDeviceSize alignment);
+
+        void begin_frame(index frame);
+
+        // offset in the ring, the descriptor range stays inside the frame region
+        std::optional<VkDeviceSize> allocate(VkDeviceSize size);
+
+        // start of the current frame region
+        VkDeviceSize get_frame_offset() const {
+            return current_frame * frame_capacity;
+        }
+        VkDeviceSize get_frame_capacity() const {
+            return frame_capacity;
+        }
+
+        index get_frame_count() const {
+            return frame_count;
+        }
+        VkDeviceSize get_range() const {
+            return range;
+        }
+        VkDeviceSize get_alignment() const {
+            return alignment;
+        }
+
+        // of the current frame
+        VkDeviceSize get_used() const {
+            return head;
+        }
+
+    private:
+        index frame_count = 0;
+        VkDeviceSize frame_capacity = 0;
+        VkDeviceSize range = 0;
+        VkDeviceSize alignment = 1;
+
+        index current_frame = 0;
+        VkDeviceSize head = 0;
+    };
+
+    // transient per draw data behind one dynamic descriptor, a region per frame in flight
+    struct uniform_ring {
+        ~uniform_ring() {
+            destroy();
+        }
+
+        struct allocation {
+            void* data = nullptr;
+            ui32 offset = 0; // dynamic offset
+
+            bool valid() const {
+                return data != nullptr;
+            }
+        };
+
+        // range is the descriptor range, the largest size of an allocation
+        bool create(device_ptr device, index frame_count, VkDeviceSize frame_capacity = 256 * 1024,
+                    VkDeviceSize range = 256, VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+        void destroy();
+
+        // reset of the frame region, its fence must have signaled
+        void begin_frame(index frame);
+
+        // before submit
+        void flush();
+
+        allocation allocate(VkDeviceSize size);
+
+        template<typename T>
+        allocation push(T const& value) {
+            auto result = allocate(sizeof(T));
+            if (result.valid())
+                memcpy(result.data, &value, sizeof(T));
+
+            return result;
+        }
+
+        VkDescriptorBufferInfo const* get_descriptor_info() const {
+            return &descriptor;
+        }
+
+        VkDescriptorType get_descriptor_type() const {
+            return (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC
+                                                                : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        }
+
+        buffer::ptr get_buffer() const {
+            return ring;
+        }
+
+        VkDeviceSize get_alignment() const {
+            return offsets.get_alignment();
+        }
+
+        // of the current frame
+        VkDeviceSize get_used() const {
+            return offsets.get_used();
+        }
+
+    private:
+        device_ptr device = nullptr;
+        buffer::ptr ring;
+
+        VkBufferUsageFlags usage = 0;
+        VkDescriptorBufferInfo descriptor = {};
+
+        uniform_ring_offsets offsets;
+        VkDeviceSize flushed = 0;
+    };
+
+} // namespace lava
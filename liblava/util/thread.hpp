@@ -24,6 +24,10 @@ namespace lava {
     struct thread_pool {
         using task = std::function<void(id::ref)>; // thread id
 
+        ~thread_pool() {
+            teardown();
+        }
+
         void setup(ui32 count = 2) {
             for (auto i = 0u; i < count; ++i)
                 workers.emplace_back(worker(*this));
@@ -37,6 +41,10 @@ namespace lava {
                 worker.join();
 
             workers.clear();
+
+            // queued tasks are dropped, ready for another setup
+            tasks.clear();
+            stop = false;
         }
 
         template<typename F>
@@ -48,6 +56,36 @@ namespace lava {
             condition.notify_one();
         }
 
+        // func(0) on the calling thread, the others on the pool, returns when all are done
+        bool parallel_for(ui32 count, std::function<bool(index)> const& func) {
+            if (count == 0)
+                return true;
+
+            std::mutex done_mutex;
+            std::condition_variable done;
+
+            auto pending = count - 1;
+            auto result = true;
+
+            for (auto i = 1u; i < count; ++i) {
+                enqueue([&, i](id::ref) {
+                    auto const value = func(i);
+
+                    std::unique_lock<std::mutex> lock(done_mutex);
+                    result = result && value;
+                    --pending;
+                    done.notify_one();
+                });
+            }
+
+            auto const first = func(0);
+
+            std::unique_lock<std::mutex> lock(done_mutex);
+            done.wait(lock, [&]() { return pending == 0; });
+
+            return result && first;
+        }
+
     private:
         struct worker {
             explicit worker(thread_pool& pool)
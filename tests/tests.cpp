@@ -405,3 +405,335 @@ LAVA_TEST(8, "imgui demo") {
 
     return app.run();
 }
+
+LAVA_TEST(9, "texture batch decode") {
+    frame frame(argh);
+    if (!frame.ready())
+        return error::not_ready;
+
+    auto device = frame.create_device();
+    if (!device)
+        return error::create_failed;
+
+    string directory = "res";
+    argh({ "-d", "--dir" }) >> directory;
+
+    file_format::list files;
+    for (auto& entry : fs::recursive_directory_iterator(directory)) {
+        auto const path = entry.path().string();
+        if (extension(str(path), { "JPG", "PNG", "TGA", "BMP", "HDR" }))
+            files.push_back({ path, VK_FORMAT_R8G8B8A8_SRGB });
+    }
+
+    if (files.empty())
+        return error::load_failed;
+
+    timer timer;
+
+    texture::list serial;
+    for (auto& file : files)
+        serial.push_back(load_texture(device, file));
+
+    auto const serial_time = timer.elapsed();
+
+    thread_pool pool;
+    pool.setup(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+
+    timer.reset();
+    auto batch = load_textures(device, files, pool);
+    auto const batch_time = timer.elapsed();
+
+    pool.teardown();
+
+    auto images_per_sec = [&](ms time) {
+        return to_r64(files.size()) / std::max(to_r64(time.count()) / 1000., 0.001);
+    };
+
+    log()->info("{} images - serial {} ms ({:.1f} images/sec) - batch {} ms ({:.1f} images/sec)",
+                files.size(), serial_time.count(), images_per_sec(serial_time),
+                batch_time.count(), images_per_sec(batch_time));
+
+    serial.clear();
+    batch.clear();
+
+    return 0;
+}
+
+LAVA_TEST(10, "block compression") {
+    string filename = "res/light/normal.png";
+    argh({ "-f", "--file" }) >> filename;
+
+    image_data image(filename);
+    if (!image.ready)
+        return error::load_failed;
+
+    cdata const source{ image.data, size_t(image.size.x) * image.size.y * 4 };
+
+    ui32 thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    argh({ "-t", "--threads" }) >> thread_count;
+
+    thread_pool pool;
+    pool.setup(std::max(thread_count, 1u) - 1);
+
+    auto const mega_pixels = to_r64(image.size.x) * image.size.y / 1000000.;
+
+    struct test_format {
+        block_format format;
+        ui32 channels;
+        name label;
+    };
+
+    test_format const formats[] = {
+        { block_format::bc1, 3, "bc1" }, { block_format::bc3, 4, "bc3" }, { block_format::bc5, 2, "bc5" }, { block_format::bc7, 4, "bc7" }
+    };
+
+    for (auto& [format, channels, label] : formats) {
+        timer timer;
+
+        unique_data compressed;
+        if (!compress_blocks(source, image.size, format, compressed, pool, thread_count))
+            return error::run_aborted;
+
+        auto const time = timer.elapsed();
+
+        unique_data result;
+        if (!decompress_blocks(compressed, image.size, format, result))
+            return error::run_aborted;
+
+        log()->info("{} - {}x{} - psnr {:.2f} dB - {} ms ({:.1f} MPix/s, {} threads)", label, image.size.x, image.size.y, compute_psnr(source, result, channels), time.count(),
+                    mega_pixels / std::max(to_r64(time.count()) / 1000., 0.001), thread_count);
+    }
+
+    pool.teardown();
+
+    return 0;
+}
+
+LAVA_TEST(11, "immediate submit") {
+    frame frame(argh);
+    if (!frame.ready())
+        return error::not_ready;
+
+    device_ptr device = frame.create_device();
+    if (!device)
+        return error::create_failed;
+
+    ui32 const count = 16;
+
+    auto buffer = make_buffer();
+    if (!buffer->create_mapped(device, nullptr, count * sizeof(ui32), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU))
+        return error::create_failed;
+
+    immediate_submit immediate;
+    if (!immediate.create(device, device->graphics_queue()))
+        return error::create_failed;
+
+    immediate.set_batch_size(4);
+
+    for (auto i = 0u; i < count; ++i) {
+        auto const recorded = immediate.record([&, i](VkCommandBuffer cmd_buf) {
+            device->call().vkCmdFillBuffer(cmd_buf, buffer->get(), i * sizeof(ui32), sizeof(ui32), i + 1);
+        });
+
+        if (!recorded)
+            return error::run_aborted;
+    }
+
+    if (!immediate.flush())
+        return error::run_aborted;
+
+    buffer->invalidate();
+
+    auto const values = static_cast<ui32 const*>(buffer->get_mapped_data());
+    for (auto i = 0u; i < count; ++i) {
+        if (values[i] != i + 1) {
+            log()->error("immediate submit - value {} is {}", i, values[i]);
+            return error::run_aborted;
+        }
+    }
+
+    log()->info("immediate submit - {} commands in {} submits", count, immediate.get_submit_count());
+
+    immediate.destroy();
+    buffer->destroy();
+
+    return 0;
+}
+
+LAVA_TEST(12, "secondary subpass") {
+    app app("secondary subpass", argh);
+    if (!app.setup())
+        return error::not_ready;
+
+    mesh::ptr triangle = create_mesh(app.device, mesh_type::triangle);
+    if (!triangle)
+        return error::create_failed;
+
+    pipeline_layout::ptr layout;
+    graphics_pipeline::list pipelines;
+
+    ui32 const pipeline_count = 4;
+
+    app.on_create = [&]() {
+        layout = make_pipeline_layout();
+        if (!layout->create(app.device))
+            return false;
+
+        render_pass::ptr render_pass = app.shading.get_pass();
+
+        for (auto i = 0u; i < pipeline_count; ++i) {
+            auto pipeline = make_graphics_pipeline(app.device);
+
+            pipeline->on_process = [&](VkCommandBuffer cmd_buf) {
+                triangle->bind_draw(cmd_buf);
+            };
+
+            if (!pipeline->add_shader(file_data("triangle/vertex.spirv"), VK_SHADER_STAGE_VERTEX_BIT))
+                return false;
+
+            if (!pipeline->add_shader(file_data("triangle/fragment.spirv"), VK_SHADER_STAGE_FRAGMENT_BIT))
+                return false;
+
+            pipeline->add_color_blend_attachment();
+
+            pipeline->set_vertex_input_binding({ 0, sizeof(vertex), VK_VERTEX_INPUT_RATE_VERTEX });
+            pipeline->set_vertex_input_attributes({
+                { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, to_ui32(offsetof(vertex, position)) },
+                { 1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, to_ui32(offsetof(vertex, color)) },
+            });
+
+            pipeline->set_layout(layout);
+
+            if (!pipeline->create(render_pass->get()))
+                return false;
+
+            render_pass->add_front(pipeline);
+            pipelines.push_back(pipeline);
+        }
+
+        // imgui and the triangles recorded in 2 buckets on secondary command buffers
+        auto subpass = render_pass->get_subpass(0);
+        subpass->set_secondary(app.device->graphics_queue().family, 2);
+        subpass->set_cache();
+
+        return true;
+    };
+
+    app.on_destroy = [&]() {
+        auto subpass = app.shading.get_pass()->get_subpass(0);
+        subpass->set_inline();
+
+        for (auto& pipeline : pipelines) {
+            app.shading.get_pass()->remove(pipeline);
+            pipeline->destroy();
+        }
+
+        pipelines.clear();
+        layout->destroy();
+    };
+
+    app.imgui.on_draw = [&]() {
+        ImGui::SetNextWindowPos(ImVec2(30, 30), ImGuiCond_FirstUseEver);
+
+        ImGui::Begin(app.get_name());
+
+        for (auto i = 0u; i < pipelines.size(); ++i) {
+            auto active = pipelines.at(i)->activated();
+            if (ImGui::Checkbox(str(fmt::format("pipeline {}", i)), &active))
+                pipelines.at(i)->toggle();
+        }
+
+        ImGui::End();
+    };
+
+    app.add_run_end([&]() {
+        triangle->destroy();
+    });
+
+    return app.run();
+}
+
+LAVA_TEST(13, "texture cache") {
+    frame frame(argh);
+    if (!frame.ready())
+        return error::not_ready;
+
+    device_ptr device = frame.create_device();
+    if (!device)
+        return error::create_failed;
+
+    string directory = "res";
+    argh({ "-d", "--dir" }) >> directory;
+
+    auto const icon = (fs::path(directory) / "icon.png").string();
+    auto const logo = (fs::path(directory) / "Vulkan_170px_Dec16.png").string();
+
+    // same content under another path
+    auto const icon_copy = (fs::temp_directory_path() / "lava_texture_cache_icon.png").string();
+    fs::copy_file(icon, icon_copy, fs::copy_options::overwrite_existing);
+
+    staging staging;
+    if (!staging.create(device))
+        return error::create_failed;
+
+    immediate_submit immediate;
+    if (!immediate.create(device, device->graphics_queue()))
+        return error::create_failed;
+
+    texture_cache cache;
+    if (!cache.create(device, &staging, 1))
+        return error::create_failed;
+
+    cache.set_keep_frames(0);
+
+    auto upload = [&]() {
+        cache.update();
+
+        while (staging.busy()) {
+            if (!immediate.execute([&](VkCommandBuffer cmd_buf) { staging.stage(cmd_buf, 0); }))
+                return false;
+        }
+
+        return true;
+    };
+
+    auto result = 0;
+
+    {
+        auto icon_texture = cache.load(icon);
+        auto copy_texture = cache.load(icon_copy);
+        auto logo_texture = cache.load(logo);
+
+        if (!icon_texture || !logo_texture || (icon_texture != copy_texture) || (cache.size() != 2)) {
+            log()->error("texture cache - {} textures, copy shared {}", cache.size(), icon_texture == copy_texture);
+            result = error::run_aborted;
+        }
+
+        if (!upload())
+            result = error::run_aborted;
+
+        // referenced textures stay over budget
+        cache.update();
+        if (cache.size() != 2) {
+            log()->error("texture cache - evicted referenced textures");
+            result = error::run_aborted;
+        }
+    }
+
+    // unused textures over budget are evicted after keep frames
+    cache.update();
+    if (cache.size() != 0) {
+        log()->error("texture cache - {} textures not evicted", cache.size());
+        result = error::run_aborted;
+    }
+
+    log()->info("texture cache - used {} bytes", cache.get_used());
+
+    cache.destroy();
+    immediate.destroy();
+    staging.destroy();
+
+    fs::remove(icon_copy);
+
+    return result;
+}
@@ -112,3 +112,514 @@ TEST_CASE("queue setup - Intel(R) HD Graphics 620", "[queue]") {
         REQUIRE(verify_queues(list, properties) == verify_queues_result::ok);
     }
 }
+
+TEST_CASE("mip levels - cpu filter", "[mip_map]") {
+    REQUIRE(mip_level_count({ 1, 1 }) == 1);
+    REQUIRE(mip_level_count({ 256, 64 }) == 9);
+    REQUIRE(mip_level_count({ 5, 3 }) == 3);
+
+    uv2 const size = { 8, 4 };
+    std::vector<ui8> texels(size.x * size.y * 4, 200);
+
+    unique_data result;
+    texture::mip_level::list levels;
+
+    SECTION("box") {
+        REQUIRE(compute_mip_levels({ texels.data(), texels.size() }, size, 4, result, levels, mip_filter::box));
+
+        REQUIRE(levels.size() == 4);
+        REQUIRE(levels.back().extent == uv2(1, 1));
+        REQUIRE(result.size == (32 + 8 + 2 + 1) * 4);
+        REQUIRE(ui8(result.ptr[result.size - 1]) == 200);
+    }
+
+    SECTION("kaiser srgb") {
+        REQUIRE(compute_mip_levels({ texels.data(), texels.size() }, size, 4, result, levels, mip_filter::kaiser, true));
+
+        // constant input stays constant
+        for (auto i = 0u; i < result.size; ++i)
+            REQUIRE(std::abs(ui8(result.ptr[i]) - 200) <= 1);
+    }
+}
+
+TEST_CASE("ktx2 - uncompressed rgba8", "[ktx2]") {
+    std::vector<ui8> file(80 + 24 + 16, 0);
+
+    ui8 const identifier[] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+    memcpy(file.data(), identifier, sizeof(identifier));
+
+    auto write = [&](size_t offset, auto value) {
+        memcpy(file.data() + offset, &value, sizeof(value));
+    };
+
+    write(12, ui32(VK_FORMAT_R8G8B8A8_UNORM));
+    write(16, ui32(1)); // type size
+    write(20, ui32(2)); // width
+    write(24, ui32(2)); // height
+    write(36, ui32(1)); // faces
+    write(40, ui32(1)); // levels
+
+    write(80, ui64(104)); // level 0 offset
+    write(88, ui64(16));
+    write(96, ui64(16));
+
+    for (auto i = 0u; i < 16; ++i)
+        file[104 + i] = ui8(i);
+
+    cdata const data{ file.data(), file.size() };
+    REQUIRE(is_ktx2(data));
+
+    texture_data result;
+    REQUIRE(load_ktx2_texture(data, result));
+
+    REQUIRE(result.format == VK_FORMAT_R8G8B8A8_UNORM);
+    REQUIRE(result.type == texture_type::tex_2d);
+    REQUIRE(result.size == uv2(2, 2));
+    REQUIRE(result.layers.size() == 1);
+    REQUIRE(result.data.size == 16);
+    REQUIRE(ui8(result.data.ptr[15]) == 15);
+    REQUIRE_FALSE(result.mip_levels_generation);
+
+    // generated at load
+    write(40, ui32(0));
+    REQUIRE(load_ktx2_texture(data, result));
+    REQUIRE(result.mip_levels_generation);
+    write(40, ui32(1));
+
+    // offset + size wraps around
+    write(80, ui64(~0ull - 7));
+    REQUIRE_FALSE(load_ktx2_texture(data, result));
+}
+
+TEST_CASE("block compression - round trip", "[block_compression]") {
+    uv2 const size = { 37, 21 };
+
+    std::vector<ui8> texels(size.x * size.y * 4);
+    for (auto y = 0u; y < size.y; ++y) {
+        for (auto x = 0u; x < size.x; ++x) {
+            auto texel = texels.data() + (y * size.x + x) * 4;
+            texel[0] = ui8(x * 255 / size.x);
+            texel[1] = ui8(y * 255 / size.y);
+            texel[2] = ui8((x + y) * 4);
+            texel[3] = 255;
+        }
+    }
+
+    cdata const source{ texels.data(), texels.size() };
+
+    thread_pool pool;
+    pool.setup(3);
+
+    auto round_trip = [&](block_format format, ui32 channels, ui32 task_count) {
+        unique_data compressed;
+        if (task_count > 1)
+            REQUIRE(compress_blocks(source, size, format, compressed, pool, task_count));
+        else
+            REQUIRE(compress_blocks(source, size, format, compressed));
+
+        REQUIRE(compressed.size == get_block_compressed_size(size, format));
+
+        unique_data result;
+        REQUIRE(decompress_blocks(compressed, size, format, result));
+
+        return compute_psnr(source, result, channels);
+    };
+
+    REQUIRE(round_trip(block_format::bc1, 3, 1) > 30.0);
+    REQUIRE(round_trip(block_format::bc3, 4, 2) > 30.0);
+    REQUIRE(round_trip(block_format::bc5, 2, 1) > 40.0);
+    REQUIRE(round_trip(block_format::bc7, 4, 4) > 35.0);
+
+    pool.teardown();
+
+    REQUIRE(get_block_compressed_size(size, block_format::bc1) == 10 * 6 * 8);
+    REQUIRE(get_block_format(block_format::bc7, true) == VK_FORMAT_BC7_SRGB_BLOCK);
+}
+
+TEST_CASE("buffer allocator - range allocator", "[buffer_allocator]") {
+    range_allocator ranges;
+    ranges.reset(1024);
+
+    REQUIRE(ranges.allocate(100, 256) == 0);
+    REQUIRE(ranges.allocate(100, 256) == 256);
+
+    // alignment padding is used by smaller ranges
+    REQUIRE(ranges.allocate(10) == 100);
+    REQUIRE(ranges.get_used() == 210);
+    REQUIRE_FALSE(ranges.allocate(1024));
+
+    ranges.free(256, 100);
+    ranges.free(0, 100);
+    ranges.free(100, 10);
+
+    REQUIRE(ranges.get_used() == 0);
+    REQUIRE(ranges.get_free_range_count() == 1);
+    REQUIRE(ranges.allocate(1024) == 0);
+}
+
+TEST_CASE("buffer allocator - ring allocator", "[buffer_allocator]") {
+    ring_allocator ring;
+    ring.reset(1024);
+
+    REQUIRE(ring.allocate(400, 256) == 0);
+    ring.mark(1);
+
+    REQUIRE(ring.allocate(400, 256) == 512);
+    ring.mark(2);
+
+    // no wrap onto the first frame in flight
+    REQUIRE_FALSE(ring.allocate(200));
+
+    ring.retire(1);
+    REQUIRE(ring.get_tail() == 400);
+
+    // wraps around behind the tail
+    REQUIRE(ring.allocate(200) == 0);
+    REQUIRE_FALSE(ring.allocate(300));
+    REQUIRE(ring.allocate(100) == 200);
+    ring.mark(3);
+
+    REQUIRE(ring.get_pending_count() == 2);
+
+    ring.retire(3);
+    REQUIRE(ring.get_pending_count() == 0);
+    REQUIRE(ring.allocate(1024) == 0);
+}
+
+TEST_CASE("sampler cache - keys", "[sampler_cache]") {
+    VkSamplerCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+        .maxLod = VK_LOD_CLAMP_NONE,
+    };
+
+    auto const key = sampler_cache::get_key(info);
+    REQUIRE(key);
+    REQUIRE(sampler_cache::get_key(info) == key);
+
+    info.maxAnisotropy = 16.f;
+    REQUIRE(sampler_cache::get_key(info) != key);
+
+    // chained structs are never shared
+    VkSamplerReductionModeCreateInfo const reduction{
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO,
+        .reductionMode = VK_SAMPLER_REDUCTION_MODE_MIN,
+    };
+    info.pNext = &reduction;
+    REQUIRE_FALSE(sampler_cache::get_key(info));
+}
+
+TEST_CASE("buffer - merge flush ranges", "[buffer]") {
+    auto const ranges = merge_buffer_ranges({ { 200, 8 }, { 0, 10 }, { 12, 4 }, { 1000, 4 }, { 240, VK_WHOLE_SIZE } }, 64, 250);
+
+    REQUIRE(ranges.size() == 2);
+
+    REQUIRE(ranges[0].offset == 0);
+    REQUIRE(ranges[0].size == 64);
+
+    // clamped to the buffer size
+    REQUIRE(ranges[1].offset == 192);
+    REQUIRE(ranges[1].size == 58);
+}
+
+TEST_CASE("uniform ring - offsets", "[uniform_ring]") {
+    uniform_ring_offsets offsets;
+
+    REQUIRE_FALSE(offsets.reset(0, 1024, 256, 256));
+    REQUIRE_FALSE(offsets.reset(2, 128, 256, 256));
+
+    // capacity aligned up
+    REQUIRE(offsets.reset(2, 1000, 256, 256));
+    REQUIRE(offsets.get_frame_capacity() == 1024);
+
+    REQUIRE(offsets.allocate(16) == 0);
+    REQUIRE(offsets.allocate(100) == 256);
+    REQUIRE(offsets.allocate(256) == 512);
+    REQUIRE(offsets.get_used() == 768);
+
+    // the descriptor range of the last offset must fit
+    REQUIRE(offsets.allocate(1) == 768);
+    REQUIRE_FALSE(offsets.allocate(1));
+
+    offsets.begin_frame(1);
+    REQUIRE(offsets.get_used() == 0);
+    REQUIRE(offsets.allocate(4) == 1024);
+    REQUIRE(offsets.allocate(4) == 1024 + 256);
+
+    // frames wrap around the ring
+    offsets.begin_frame(2);
+    REQUIRE(offsets.get_frame_offset() == 0);
+    REQUIRE(offsets.allocate(4) == 0);
+
+    offsets.begin_frame(3);
+    REQUIRE(offsets.allocate(4) == 1024);
+
+    // no alignment
+    REQUIRE(offsets.reset(1, 64, 16, 0));
+    REQUIRE(offsets.get_alignment() == 1);
+    REQUIRE(offsets.allocate(3) == 0);
+    REQUIRE(offsets.allocate(3) == 3);
+}
+
+TEST_CASE("memory - cpu callbacks by scope", "[memory]") {
+    auto callbacks = memory::alloc();
+    REQUIRE(callbacks != nullptr);
+
+    auto const before = memory::get_cpu_stats();
+
+    auto object = callbacks->pfnAllocation(callbacks->pUserData, 100, 64, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+    REQUIRE(object != nullptr);
+    REQUIRE(reinterpret_cast<uintptr_t>(object) % 64 == 0);
+
+    auto command = callbacks->pfnAllocation(callbacks->pUserData, 40, 8, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+    REQUIRE(command != nullptr);
+    memset(command, 1, 40);
+
+    command = callbacks->pfnReallocation(callbacks->pUserData, command, 200, 8, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+    REQUIRE(command != nullptr);
+    REQUIRE(static_cast<char*>(command)[39] == 1);
+
+    auto stats = memory::get_cpu_stats();
+    REQUIRE(stats[VK_SYSTEM_ALLOCATION_SCOPE_OBJECT].count == before[VK_SYSTEM_ALLOCATION_SCOPE_OBJECT].count + 1);
+    REQUIRE(stats[VK_SYSTEM_ALLOCATION_SCOPE_OBJECT].bytes == before[VK_SYSTEM_ALLOCATION_SCOPE_OBJECT].bytes + 100);
+    REQUIRE(stats[VK_SYSTEM_ALLOCATION_SCOPE_COMMAND].bytes == before[VK_SYSTEM_ALLOCATION_SCOPE_COMMAND].bytes + 200);
+    REQUIRE(stats[VK_SYSTEM_ALLOCATION_SCOPE_COMMAND].arena_count == before[VK_SYSTEM_ALLOCATION_SCOPE_COMMAND].arena_count + 2);
+
+    // behind the live allocation in the same arena block
+    auto aligned = callbacks->pfnAllocation(callbacks->pUserData, 24, 64, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+    REQUIRE(aligned != nullptr);
+    REQUIRE(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+    callbacks->pfnFree(callbacks->pUserData, aligned);
+
+    callbacks->pfnFree(callbacks->pUserData, command);
+    callbacks->pfnFree(callbacks->pUserData, object);
+
+    stats = memory::get_cpu_stats();
+    REQUIRE(stats[VK_SYSTEM_ALLOCATION_SCOPE_OBJECT].bytes == before[VK_SYSTEM_ALLOCATION_SCOPE_OBJECT].bytes);
+    REQUIRE(stats[VK_SYSTEM_ALLOCATION_SCOPE_COMMAND].count == before[VK_SYSTEM_ALLOCATION_SCOPE_COMMAND].count);
+}
+
+TEST_CASE("transient image pool - alias offsets", "[transient_image_pool]") {
+    VkDeviceSize block_size = 0;
+
+    // first two never alive at the same time
+    auto offsets = alias_offsets({ { 100, 1, 0, 1 }, { 100, 1, 2, 3 }, { 50, 64, 1, 2 } }, block_size);
+
+    REQUIRE(offsets[0] == 0);
+    REQUIRE(offsets[1] == 0);
+    REQUIRE(offsets[2] == 128);
+    REQUIRE(block_size == 178);
+
+    offsets = alias_offsets({ { 10, 1, 0, 0 }, { 20, 1, 0, 0 }, { 30, 1, 0, 0 } }, block_size);
+    REQUIRE(block_size == 60);
+}
+
+TEST_CASE("texture atlas - skyline packer", "[texture_atlas]") {
+    skyline_packer packer;
+    packer.reset({ 64, 64 });
+
+    REQUIRE(packer.insert({ 32, 16 }) == uv2(0, 0));
+    REQUIRE(packer.insert({ 32, 32 }) == uv2(32, 0));
+    REQUIRE(packer.insert({ 32, 16 }) == uv2(0, 16));
+    REQUIRE(packer.insert({ 64, 32 }) == uv2(0, 32));
+
+    REQUIRE(packer.get_occupancy() == 1.f);
+    REQUIRE_FALSE(packer.insert({ 1, 1 }));
+
+    packer.reset({ 64, 64 });
+    REQUIRE_FALSE(packer.insert({ 65, 1 }));
+    REQUIRE(packer.get_used_area() == 0);
+}
+
+TEST_CASE("texture cache - file identity", "[texture_cache]") {
+    auto const directory = fs::temp_directory_path();
+    auto const path_a = (directory / "lava_texture_cache_a.bin").string();
+    auto const path_b = (directory / "lava_texture_cache_b.bin").string();
+
+    std::array<char, 4> const bytes_a = { 1, 2, 3, 4 };
+    std::array<char, 4> const bytes_b = { 1, 2, 3, 5 };
+
+    REQUIRE(write_file(str(path_a), bytes_a.data(), bytes_a.size()));
+    REQUIRE(write_file(str(path_b), bytes_b.data(), bytes_b.size()));
+
+    file_format const file_a{ path_a, VK_FORMAT_R8G8B8A8_SRGB };
+    file_format const file_b{ path_b, VK_FORMAT_R8G8B8A8_SRGB };
+
+    cdata const content_a{ bytes_a.data(), bytes_a.size() };
+    cdata const content_b{ bytes_b.data(), bytes_b.size() };
+
+    // same content under another path
+    REQUIRE(hash_texture_file(file_a, texture_type::tex_2d, content_a) == hash_texture_file(file_b, texture_type::tex_2d, content_a));
+    REQUIRE(same_texture_file(file_b, texture_type::tex_2d, content_a, file_a, texture_type::tex_2d));
+
+    // a hash hit on different content, format or type is no match
+    REQUIRE_FALSE(same_texture_file(file_a, texture_type::tex_2d, content_b, file_a, texture_type::tex_2d));
+    REQUIRE_FALSE(same_texture_file(file_a, texture_type::tex_2d, cdata{ bytes_a.data(), 3 }, file_a, texture_type::tex_2d));
+    REQUIRE_FALSE(same_texture_file({ path_a, VK_FORMAT_R8G8B8A8_UNORM }, texture_type::tex_2d, content_a, file_a, texture_type::tex_2d));
+    REQUIRE_FALSE(same_texture_file(file_a, texture_type::array, content_a, file_a, texture_type::tex_2d));
+
+    // files not read compare the path
+    REQUIRE(same_texture_file(file_a, texture_type::tex_2d, {}, file_a, texture_type::tex_2d));
+    REQUIRE_FALSE(same_texture_file(file_a, texture_type::tex_2d, {}, file_b, texture_type::tex_2d));
+
+    fs::remove(path_a);
+    fs::remove(path_b);
+}
+
+TEST_CASE("texture stream - request queue", "[texture_stream]") {
+    texture_stream_queue queue;
+
+    auto const placeholder = make_texture();
+
+    auto request_a = queue.add({ "a.png", VK_FORMAT_R8G8B8A8_SRGB }, texture_type::tex_2d, placeholder);
+    auto request_b = queue.add({ "b.png", VK_FORMAT_R8G8B8A8_SRGB }, texture_type::tex_2d, placeholder);
+    auto request_c = queue.add({ "c.png", VK_FORMAT_R8G8B8A8_SRGB }, texture_type::tex_2d, placeholder);
+
+    REQUIRE(queue.get_pending() == 3);
+
+    auto const a = request_a->target;
+    auto const b = request_b->target;
+    auto const c = request_c->target;
+
+    REQUIRE(a->get() == placeholder);
+    REQUIRE(a->get_state() == streamed_texture::state::loading);
+
+    texture::ptr updated;
+    a->add_update([&](texture::ptr texture) { updated = texture; });
+
+    // decoded in any order
+    queue.push_decoded(request_c);
+    queue.push_decoded(request_a);
+    queue.push_decoded(request_b);
+
+    auto const decoded = queue.take_decoded();
+    REQUIRE(decoded.size() == 3);
+    REQUIRE(decoded.front() == request_c);
+    REQUIRE(queue.take_decoded().empty());
+
+    // decode failed
+    queue.fail(b);
+    REQUIRE(b->get_state() == streamed_texture::state::failed);
+    REQUIRE(b->get() == placeholder);
+    REQUIRE(queue.get_pending() == 2);
+
+    auto const texture_a = make_texture();
+    auto const texture_c = make_texture();
+
+    auto staged_a = queue.upload(a, texture_a);
+    auto staged_c = queue.upload(c, texture_c);
+
+    // placeholder until staged
+    REQUIRE(a->get_state() == streamed_texture::state::uploading);
+    REQUIRE(a->get() == placeholder);
+    REQUIRE(queue.swap_staged().empty());
+    REQUIRE_FALSE(updated);
+
+    staged_a(true);
+    staged_c(false);
+
+    REQUIRE(queue.swap_staged().size() == 2);
+    REQUIRE(queue.get_pending() == 0);
+
+    REQUIRE(a->ready());
+    REQUIRE(a->get() == texture_a);
+    REQUIRE(updated == texture_a);
+
+    // upload failed
+    REQUIRE(c->get_state() == streamed_texture::state::failed);
+    REQUIRE(c->get() == placeholder);
+
+    // ready textures update at once
+    texture::ptr late;
+    a->add_update([&](texture::ptr texture) { late = texture; });
+    REQUIRE(late == texture_a);
+
+    REQUIRE(queue.swap_staged().empty());
+}
+
+TEST_CASE("virtual texture - page table", "[virtual_texture]") {
+    virtual_page const page{ 3, 1234, 16383 };
+    REQUIRE(virtual_page::unpack(page.pack()) == page);
+
+    virtual_page_table table;
+    REQUIRE(table.create({ 1024, 1024 }, 128, 4, 4));
+    table.set_keep_frames(0);
+
+    REQUIRE(table.get_page_count(0) == uv2(8, 8));
+    REQUIRE(table.get_page_count(3) == uv2(1, 1));
+
+    // invalid ids are ignored, parents are requested first
+    std::vector<ui32> const feedback{ virtual_page{ 0, 3, 3 }.pack(), virtual_page{ 0, 3, 3 }.pack(), virtual_page{ 9, 0, 0 }.pack() };
+
+    auto requests = table.process_feedback(feedback.data(), feedback.size(), 2);
+    REQUIRE(requests == virtual_page::list{ { 3, 0, 0 }, { 2, 0, 0 } });
+
+    requests = table.process_feedback(feedback.data(), feedback.size(), 8);
+    REQUIRE(requests == virtual_page::list{ { 1, 1, 1 }, { 0, 3, 3 } });
+    REQUIRE(table.get_pending_count() == 4);
+
+    std::optional<virtual_page> evicted;
+    for (auto& current : virtual_page::list{ { 3, 0, 0 }, { 2, 0, 0 }, { 1, 1, 1 }, { 0, 3, 3 } }) {
+        REQUIRE(table.make_resident(current, evicted));
+        REQUIRE_FALSE(evicted);
+    }
+
+    REQUIRE(table.get_pending_count() == 0);
+    REQUIRE(table.find_resident(3, 3) == virtual_page{ 0, 3, 3 });
+    REQUIRE(table.find_resident(0, 0) == virtual_page{ 2, 0, 0 });
+
+    table.pin({ 3, 0, 0 });
+
+    // least recently used page makes room
+    std::vector<ui32> const used{ virtual_page{ 1, 1, 1 }.pack() };
+    REQUIRE(table.process_feedback(used.data(), used.size(), 8).empty());
+
+    REQUIRE(table.make_resident({ 0, 0, 0 }, evicted));
+    REQUIRE(evicted == virtual_page{ 0, 3, 3 });
+
+    // all other pages used this frame
+    REQUIRE_FALSE(table.make_resident({ 0, 1, 0 }, evicted));
+}
+
+TEST_CASE("render graph - culling and barriers", "[render_graph]") {
+    render_graph graph;
+
+    auto const color = graph.add_image("color", VK_FORMAT_R8G8B8A8_UNORM, { 64, 64 });
+    auto const output = graph.import_image("output", nullptr, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    auto const unused = graph.add_image("unused", VK_FORMAT_R8G8B8A8_UNORM, { 64, 64 });
+
+    graph.set_external_writes(output, 0, 0);
+    graph.set_output(output);
+
+    graph.add_pass("scene", { { color, resource_usage::color_attachment } }, {});
+    graph.add_pass("post", { { color, resource_usage::sampled }, { output, resource_usage::color_attachment } }, {});
+    graph.add_pass("debug", { { unused, resource_usage::color_attachment } }, {});
+
+    REQUIRE(graph.compile());
+    REQUIRE_FALSE(graph.culled(0));
+    REQUIRE_FALSE(graph.culled(1));
+    REQUIRE(graph.culled(2));
+
+    REQUIRE(graph.get_first_pass(color) == 0);
+    REQUIRE(graph.get_last_pass(color) == 1);
+
+    auto const& scene = graph.get_barriers(0);
+    REQUIRE(scene.size() == 1);
+    REQUIRE(scene[0].old_layout == VK_IMAGE_LAYOUT_UNDEFINED);
+    REQUIRE(scene[0].new_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+    // sampled after written as attachment
+    auto const& post = graph.get_barriers(1);
+    REQUIRE(post.size() == 2);
+    REQUIRE(post[0].resource == color);
+    REQUIRE(post[0].new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    REQUIRE(post[0].src_stage == VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    REQUIRE(post[0].dst_access == VK_ACCESS_SHADER_READ_BIT);
+
+    auto const& final_barriers = graph.get_final_barriers();
+    REQUIRE(final_barriers.size() == 1);
+    REQUIRE(final_barriers[0].resource == output);
+    REQUIRE(final_barriers[0].new_layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+}